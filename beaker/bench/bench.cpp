@@ -0,0 +1,114 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// The beaker-bench program runs a corpus of Beaker
+// programs through the toolchain and reports the time
+// spent in each phase of translation and execution.
+
+#include "beaker/bench/harness.hpp"
+#include "beaker/options.hpp"
+#include "beaker/job.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+
+static void
+usage(std::ostream& os, po::options_description& desc)
+{
+  os << "usage: beaker-bench [options] input-file...\n";
+  os << desc << '\n';
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  init_colors();
+
+  po::options_description opts("Benchmark options");
+  opts.add_options()
+    ("help",         po::bool_switch(),                  "Print this message and exit.")
+    ("input,i",      po::value<String_seq>(),            "Specify input files.")
+    ("output,o",     po::value<String>(),                "Write results to the given file.")
+    ("format,f",     po::value<String>()->default_value("json"),
+     "Specify the output format (json or csv).")
+    ("repeat,r",     po::value<int>()->default_value(3), "Run each phase this many times.")
+    ("workdir,w",    po::value<String>()->default_value("."),
+     "Specify where native programs are built.")
+    ("no-interpret", po::bool_switch(),                  "Do not run the interpreter.")
+    ("no-native",    po::bool_switch(),                  "Do not compile native programs.");
+
+  po::positional_options_description positional_opts;
+  positional_opts.add("input", -1);
+
+  po::variables_map vm;
+  try {
+    po::store(
+      po::command_line_parser(argc, argv)
+        .options(opts)
+        .positional(positional_opts)
+        .run(),
+      vm);
+    po::notify(vm);
+  } catch(std::exception& err) {
+    std::cerr << "error: " << err.what() << "\n\n";
+    usage(std::cerr, opts);
+    return -1;
+  }
+
+  if (vm["help"].as<bool>()) {
+    usage(std::cout, opts);
+    return 0;
+  }
+  if (!vm.count("input")) {
+    std::cerr << "error: no input files\n\n";
+    usage(std::cerr, opts);
+    return -1;
+  }
+
+  Bench_config conf;
+  conf.repeat = std::max(1, vm["repeat"].as<int>());
+  conf.workdir = vm["workdir"].as<String>();
+  conf.interpret = !vm["no-interpret"].as<bool>();
+  conf.native = !vm["no-native"].as<bool>();
+
+  String fmt = vm["format"].as<String>();
+  if (fmt != "json" && fmt != "csv") {
+    std::cerr << "error: invalid output format\n\n";
+    usage(std::cerr, opts);
+    return -1;
+  }
+
+  // Run each benchmark in turn. Failures are recorded
+  // in the results, not diagnosed.
+  Bench_result_seq results;
+  for (String const& s : vm["input"].as<String_seq>()) {
+    Path p = s;
+    std::cerr << "running " << p.stem().string() << '\n';
+    results.push_back(run_benchmark(p, conf));
+  }
+
+  // Write the results.
+  std::ofstream ofs;
+  if (vm.count("output"))
+    ofs.open(vm["output"].as<String>());
+  std::ostream& os = ofs.is_open() ? ofs : std::cout;
+  if (fmt == "json")
+    write_json(os, results);
+  else
+    write_csv(os, results);
+
+  // Summarize failures.
+  int status = 0;
+  for (Bench_result const& r : results) {
+    for (Phase const& p : r.phases) {
+      if (!p.ok) {
+        std::cerr << r.program << ": " << p.name << ": " << p.note << '\n';
+        status = 1;
+      }
+    }
+  }
+  return status;
+}
@@ -0,0 +1,117 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// The beaker-call program measures the cost of calling
+// Beaker functions from C++ through an engine. The
+// module is loaded once, and each function is called
+// repeatedly through its handle. The time per call is
+// reported in nanoseconds.
+
+#include "beaker/bench/harness.hpp"
+#include "beaker/engine.hpp"
+#include "beaker/error.hpp"
+#include "beaker/options.hpp"
+
+#include <iomanip>
+#include <iostream>
+
+
+static void
+usage(std::ostream& os, po::options_description& desc)
+{
+  os << "usage: beaker-call [options] input-file\n";
+  os << desc << '\n';
+}
+
+
+// Call fn n times, returning the best time per call
+// in nanoseconds over r repetitions. The sum of the
+// results is accumulated in sum so that the calls
+// are not optimized away.
+template<typename Fn>
+static double
+measure(Fn fn, int n, int r, Integer_value& sum)
+{
+  double best = 0;
+  for (int i = 0; i < r; ++i) {
+    Bench_timer t;
+    for (int j = 0; j < n; ++j)
+      sum += fn(j);
+    double ns = t.elapsed() * 1e9 / n;
+    if (i == 0 || ns < best)
+      best = ns;
+  }
+  return best;
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  po::options_description opts("Call options");
+  opts.add_options()
+    ("help",      po::bool_switch(),                        "Print this message and exit.")
+    ("input,i",   po::value<String>(),                      "Specify the input file.")
+    ("count,n",   po::value<int>()->default_value(1000000), "The number of calls per repetition.")
+    ("repeat,r",  po::value<int>()->default_value(3),       "Run each measurement this many times.");
+
+  po::positional_options_description positional_opts;
+  positional_opts.add("input", 1);
+
+  po::variables_map vm;
+  try {
+    po::store(
+      po::command_line_parser(argc, argv)
+        .options(opts)
+        .positional(positional_opts)
+        .run(),
+      vm);
+    po::notify(vm);
+  } catch(std::exception& err) {
+    std::cerr << "error: " << err.what() << "\n\n";
+    usage(std::cerr, opts);
+    return -1;
+  }
+  if (vm["help"].as<bool>()) {
+    usage(std::cout, opts);
+    return 0;
+  }
+  if (!vm.count("input")) {
+    std::cerr << "error: no input file\n\n";
+    usage(std::cerr, opts);
+    return -1;
+  }
+
+  int n = std::max(1, vm["count"].as<int>());
+  int r = std::max(1, vm["repeat"].as<int>());
+
+  try {
+    Engine eng;
+    eng.load(vm["input"].as<String>());
+
+    Function_handle nop = eng.function("nop");
+    Function_handle add = eng.function("add");
+    Function_handle count = eng.function("count");
+    Function_handle fib = eng.function("fib");
+
+    Integer_value sum = 0;
+    std::cout << std::left << std::setw(12) << "function"
+              << "ns/call" << '\n' << std::fixed << std::setprecision(1);
+    std::cout << std::setw(12) << "nop"
+              << measure([&](int) { return nop.call<int>(); }, n, r, sum) << '\n';
+    std::cout << std::setw(12) << "add"
+              << measure([&](int i) { return add.call<int>(i, 1); }, n, r, sum) << '\n';
+    std::cout << std::setw(12) << "count"
+              << measure([&](int) { return count.call<int>(); }, n, r, sum) << '\n';
+    std::cout << std::setw(12) << "fib(10)"
+              << measure([&](int) { return fib.call<int>(10); }, n / 100 + 1, r, sum) << '\n';
+    std::cerr << "checksum: " << sum << '\n';
+  } catch (Translation_error& err) {
+    diagnose(err);
+    return -1;
+  } catch (std::runtime_error& err) {
+    std::cerr << "error: " << err.what() << '\n';
+    return -1;
+  }
+  return 0;
+}
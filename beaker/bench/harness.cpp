@@ -0,0 +1,396 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/bench/harness.hpp"
+#include "beaker/job.hpp"
+#include "beaker/lexer.hpp"
+#include "beaker/parser.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/elaborator.hpp"
+#include "beaker/evaluator.hpp"
+#include "beaker/generator.hpp"
+#include "beaker/error.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <sys/wait.h>
+
+#include <llvm/IR/Module.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+
+// Returns the named phase, or nullptr if the phase
+// was not run.
+Phase const*
+Bench_result::phase(String const& n) const
+{
+  for (Phase const& p : phases)
+    if (p.name == n)
+      return &p;
+  return nullptr;
+}
+
+
+namespace
+{
+
+// The state of a single translation. The front end
+// modifies its inputs, so each repetition starts
+// over with a fresh translation.
+struct Translation
+{
+  Translation()
+  {
+    init_symbols(syms);
+  }
+
+  Symbol_table syms;
+  Location_map locs;
+  Token_stream toks;
+  Module_decl  mod;
+  Function_decl* main = nullptr;
+};
+
+
+// Accumulates the measurement of a phase over a
+// number of repetitions. Only the best time is kept.
+// Memory is measured on the first repetition.
+struct Phase_timer
+{
+  Phase_timer(Phase& p, int n)
+    : phase(p), first(n == 0), mem(bench_memory())
+  { }
+
+  ~Phase_timer()
+  {
+    double t = timer.elapsed();
+    if (first || t < phase.seconds)
+      phase.seconds = t;
+    if (first) {
+      Bench_memory now = bench_memory();
+      phase.allocated = now.allocated - mem.allocated;
+      phase.retained = now.live > mem.live ? now.live - mem.live : 0;
+    }
+  }
+
+  Phase&       phase;
+  bool         first;
+  Bench_memory mem;
+  Bench_timer  timer;
+};
+
+
+// Returns the phase with the given name, adding it
+// to the result if it was not already present.
+Phase&
+get_phase(Bench_result& r, String const& n)
+{
+  for (Phase& p : r.phases)
+    if (p.name == n)
+      return p;
+  r.phases.push_back(Phase {n});
+  return r.phases.back();
+}
+
+
+// Mark the phase as failed.
+void
+fail(Phase& p, String const& msg)
+{
+  p.ok = false;
+  p.note = msg;
+}
+
+
+// Run the front end over the source text, recording the
+// time spent in each phase. Returns false if translation
+// fails.
+bool
+translate(Bench_result& r, Translation& tr, String const& src, int n)
+{
+  Phase& lex = get_phase(r, "lex");
+  Phase& parse = get_phase(r, "parse");
+  Phase& elab = get_phase(r, "elaborate");
+  Phase* cur = &lex;
+  try {
+    Input_buffer buf = src;
+    {
+      Phase_timer t(lex, n);
+      Lexer lexer(tr.syms, buf);
+      if (!lexer.lex(tr.toks)) {
+        fail(lex, "lexical error");
+        return false;
+      }
+    }
+    cur = &parse;
+    {
+      Phase_timer t(parse, n);
+      Parser parser(tr.syms, tr.toks, tr.locs);
+      if (!parser.module(&tr.mod)) {
+        fail(parse, "syntax error");
+        return false;
+      }
+    }
+    cur = &elab;
+    {
+      Phase_timer t(elab, n);
+      Elaborator elaborator(tr.locs, tr.syms);
+      elaborator.elaborate(&tr.mod);
+      tr.main = elaborator.main;
+    }
+  } catch (Translation_error& err) {
+    fail(*cur, err.what());
+    return false;
+  }
+  return true;
+}
+
+
+// Generate IR for the translated program, recording the
+// time spent. The IR is written to ir when it is
+// non-empty. Returns false if generation fails.
+bool
+generate(Bench_result& r, Translation& tr, int n, Path const& ir)
+{
+  Phase& gen = get_phase(r, "generate");
+  try {
+    // The module is owned by the generator, so it must
+    // be written out before the generator goes away.
+    Generator g;
+    llvm::Module* m;
+    {
+      Phase_timer t(gen, n);
+      m = g(&tr.mod);
+    }
+    if (!ir.empty()) {
+      std::error_code err;
+      llvm::raw_fd_ostream ofs(ir.string(), err, llvm::sys::fs::F_None);
+      ofs << *m;
+    }
+  } catch (std::exception& err) {
+    fail(gen, err.what());
+    return false;
+  }
+  return true;
+}
+
+
+// Evaluate the main function of a translated program.
+void
+interpret(Bench_result& r, Translation& tr, Bench_config const& conf)
+{
+  Phase& p = get_phase(r, "interpret");
+  if (!tr.main) {
+    fail(p, "no main");
+    return;
+  }
+  try {
+    for (int i = 0; i < conf.repeat; ++i) {
+      Phase_timer t(p, i);
+      Evaluator ev;
+      Value v = ev.exec(tr.main);
+      std::stringstream ss;
+      ss << v;
+      r.result = ss.str();
+      r.caches = ev.cache_stats();
+    }
+  } catch (std::exception& err) {
+    fail(p, err.what());
+  }
+}
+
+
+// Run the given command, returning its exit code, or -1
+// if the command could not be run.
+int
+execute(Job const& job)
+{
+  std::stringstream ss;
+  ss << job.exec.string();
+  for (String const& arg : job.args)
+    ss << ' ' << arg;
+  int status = std::system(ss.str().c_str());
+  if (status == -1 || !WIFEXITED(status))
+    return -1;
+  return WEXITSTATUS(status);
+}
+
+
+// Lower, assemble, and link the generated IR, and then
+// run the resulting program.
+void
+native(Bench_result& r, Path const& ir, Bench_config const& conf)
+{
+  Path as = to_asm_file(ir);
+  Path obj = to_object_file(ir);
+  Path exe = ir;
+  exe.replace_extension(executable_extension());
+
+  // Lower and link the program once. These phases are
+  // measured by the native toolchain, not by us.
+  Phase& lower = get_phase(r, "lower");
+  {
+    Phase_timer t(lower, 0);
+    Job job(llvm_compiler(), {format("-o {}", as.string()), ir.string()});
+    if (execute(job) != 0) {
+      fail(lower, "llc failed");
+      return;
+    }
+  }
+  Phase& link = get_phase(r, "link");
+  {
+    Phase_timer t(link, 0);
+    Job as_job(native_assembler(), {"-c", format("-o {}", obj.string()), as.string()});
+    Job ld_job(native_linker(), {format("-o {}", exe.string()), obj.string()});
+    if (execute(as_job) != 0 || execute(ld_job) != 0) {
+      fail(link, "link failed");
+      return;
+    }
+  }
+
+  // Run the program. Its exit code is the result of
+  // main, which is also recorded.
+  Phase& run = get_phase(r, "native");
+  for (int i = 0; i < conf.repeat; ++i) {
+    Phase_timer t(run, i);
+    int code = execute(Job(exe, {}));
+    if (code < 0) {
+      fail(run, "program did not exit normally");
+      return;
+    }
+    if (r.result.empty())
+      r.result = std::to_string(code);
+  }
+}
+
+
+} // namespace
+
+
+// Measure the given program.
+Bench_result
+run_benchmark(Path const& p, Bench_config const& conf)
+{
+  std::ifstream ifs(p.string());
+  std::stringstream ss;
+  ss << ifs.rdbuf();
+  return run_benchmark(p.stem().string(), ss.str(), conf);
+}
+
+
+// Measure the program named n, with the given source
+// text. The front end is run conf.repeat times, and then
+// the last translation is used for interpretation and
+// native compilation.
+Bench_result
+run_benchmark(String const& n, String const& src, Bench_config const& conf)
+{
+  Bench_result r {n};
+  Path ir = conf.workdir / (n + ".ll");
+
+  // Run the front end. Only the last repetition writes
+  // out the IR for native compilation.
+  //
+  // FIXME: Translations are never deleted because the
+  // global type tables may refer to their declarations.
+  Translation* tr = nullptr;
+  bool gen = true;
+  for (int i = 0; i < conf.repeat; ++i) {
+    tr = new Translation();
+    if (!translate(r, *tr, src, i))
+      return r;
+    bool last = (i == conf.repeat - 1);
+    if (gen)
+      gen = generate(r, *tr, i, last && conf.native ? ir : Path());
+  }
+
+  // The interpreter does not depend on code generation,
+  // but native compilation does.
+  if (conf.interpret)
+    interpret(r, *tr, conf);
+  if (conf.native && gen)
+    native(r, ir, conf);
+  return r;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Output
+
+namespace
+{
+
+// Write s as a JSON string.
+void
+write_json_string(std::ostream& os, String const& s)
+{
+  os << '"';
+  for (char c : s) {
+    switch (c) {
+      case '"': os << "\\\""; break;
+      case '\\': os << "\\\\"; break;
+      case '\n': os << "\\n"; break;
+      case '\t': os << "\\t"; break;
+      default: os << c; break;
+    }
+  }
+  os << '"';
+}
+
+} // namespace
+
+
+// Write the results as a JSON array with one object
+// per program. Each phase is an object keyed by the
+// name of the phase.
+void
+write_json(std::ostream& os, Bench_result_seq const& rs)
+{
+  os << "[\n";
+  for (std::size_t i = 0; i < rs.size(); ++i) {
+    Bench_result const& r = rs[i];
+    os << "  {\"program\": ";
+    write_json_string(os, r.program);
+    os << ", \"result\": ";
+    write_json_string(os, r.result);
+    os << ", \"inline_caches\": {\"sites\": " << r.caches.sites
+       << ", \"megamorphic\": " << r.caches.megamorphic
+       << ", \"hits\": " << r.caches.hits
+       << ", \"misses\": " << r.caches.misses << '}';
+    os << ", \"phases\": {";
+    for (std::size_t j = 0; j < r.phases.size(); ++j) {
+      Phase const& p = r.phases[j];
+      os << (j ? ", " : "");
+      write_json_string(os, p.name);
+      os << ": {\"seconds\": " << p.seconds
+         << ", \"allocated\": " << p.allocated
+         << ", \"retained\": " << p.retained
+         << ", \"ok\": " << (p.ok ? "true" : "false");
+      if (!p.ok) {
+        os << ", \"note\": ";
+        write_json_string(os, p.note);
+      }
+      os << '}';
+    }
+    os << "}}" << (i + 1 < rs.size() ? "," : "") << '\n';
+  }
+  os << "]\n";
+}
+
+
+// Write the results as comma-separated values with
+// one line per phase of each program.
+void
+write_csv(std::ostream& os, Bench_result_seq const& rs)
+{
+  os << "program,phase,seconds,allocated,retained,ok\n";
+  for (Bench_result const& r : rs)
+    for (Phase const& p : r.phases)
+      os << r.program << ',' << p.name << ','
+         << p.seconds << ',' << p.allocated << ','
+         << p.retained << ',' << (p.ok ? 1 : 0) << '\n';
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_BENCH_HARNESS_HPP
+#define BEAKER_BENCH_HARNESS_HPP
+
+// The benchmark harness runs a Beaker program through
+// each phase of the toolchain and records the time
+// spent in each phase. Results are written in a
+// machine-readable form so that runs can be compared
+// against a saved baseline.
+
+#include <beaker/prelude.hpp>
+#include <beaker/file.hpp>
+#include <beaker/evaluator.hpp>
+
+#include <chrono>
+#include <deque>
+#include <iosfwd>
+
+
+// Configures a benchmark run.
+struct Bench_config
+{
+  int  repeat    = 1;     // Number of times each phase is run
+  bool interpret = true;  // Run the program in the interpreter
+  bool native    = true;  // Compile and run a native program
+  Path workdir   = ".";   // Where native artifacts are written
+};
+
+
+// The measurement of a single phase of translation
+// or execution. The time is the best wall-clock time
+// over all repetitions, in seconds. Memory is measured
+// in bytes during the first repetition: the number
+// of bytes allocated, and the number of those still
+// allocated at the end of the phase.
+//
+// If the phase failed, then ok is false and the
+// note contains a short description of the error.
+// A failed phase is run only once.
+struct Phase
+{
+  String name;
+  double      seconds   = 0;
+  std::size_t allocated = 0;
+  std::size_t retained  = 0;
+  bool        ok        = true;
+  String      note;
+};
+
+
+// A sequence of phases. References to phases are
+// not invalidated as new phases are added.
+using Phase_seq = std::deque<Phase>;
+
+
+// The measurements of a single program. The result
+// is the value computed by the interpreter or the
+// exit code of the native program. The counters of the
+// interpreter's inline caches are those of its last run.
+struct Bench_result
+{
+  String             program;
+  Phase_seq          phases;
+  String             result;
+  Inline_cache_stats caches;
+
+  Phase const* phase(String const&) const;
+};
+
+
+using Bench_result_seq = std::vector<Bench_result>;
+
+
+// A wall-clock timer.
+struct Bench_timer
+{
+  using Clock = std::chrono::steady_clock;
+
+  Bench_timer()
+    : start(Clock::now())
+  { }
+
+  // Returns the number of seconds since the timer
+  // was started.
+  double elapsed() const
+  {
+    std::chrono::duration<double> d = Clock::now() - start;
+    return d.count();
+  }
+
+  Clock::time_point start;
+};
+
+
+// Counters for memory allocated through the global
+// allocation functions, in bytes. These are maintained
+// by replacements of operator new and delete, which
+// are defined in memory.cpp.
+struct Bench_memory
+{
+  std::size_t allocated = 0; // Total bytes allocated
+  std::size_t live      = 0; // Bytes currently allocated
+  std::size_t peak      = 0; // Maximum of live bytes
+};
+
+
+Bench_memory bench_memory();
+
+
+Bench_result run_benchmark(Path const&, Bench_config const&);
+Bench_result run_benchmark(String const&, String const&, Bench_config const&);
+
+
+void write_json(std::ostream&, Bench_result_seq const&);
+void write_csv(std::ostream&, Bench_result_seq const&);
+
+
+#endif
@@ -0,0 +1,72 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Replaces the global allocation functions so that the
+// benchmark harness can measure the memory used by
+// each phase. Each allocation is prefixed by a small
+// header that records its size.
+
+#include "beaker/bench/harness.hpp"
+
+#include <cstdlib>
+#include <new>
+
+
+namespace
+{
+
+// The header is large enough to preserve the alignment
+// guaranteed by malloc.
+union Header
+{
+  std::size_t    size;
+  std::max_align_t align;
+};
+
+
+Bench_memory mem;
+
+
+void*
+allocate(std::size_t n)
+{
+  Header* h = static_cast<Header*>(std::malloc(sizeof(Header) + n));
+  if (!h)
+    throw std::bad_alloc();
+  h->size = n;
+  mem.allocated += n;
+  mem.live += n;
+  if (mem.live > mem.peak)
+    mem.peak = mem.live;
+  return h + 1;
+}
+
+
+void
+deallocate(void* p)
+{
+  if (!p)
+    return;
+  Header* h = static_cast<Header*>(p) - 1;
+  mem.live -= h->size;
+  std::free(h);
+}
+
+
+} // namespace
+
+
+// Returns the current memory counters.
+Bench_memory
+bench_memory()
+{
+  return mem;
+}
+
+
+void* operator new(std::size_t n) { return allocate(n); }
+void* operator new[](std::size_t n) { return allocate(n); }
+void operator delete(void* p) noexcept { deallocate(p); }
+void operator delete[](void* p) noexcept { deallocate(p); }
+void operator delete(void* p, std::size_t) noexcept { deallocate(p); }
+void operator delete[](void* p, std::size_t) noexcept { deallocate(p); }
@@ -0,0 +1,173 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// The beaker-scale program synthesizes modules of
+// increasing size and reports how the time and memory
+// used by each phase of the front end grow.
+//
+// One dimension of the synthesized module is varied
+// while the others are held fixed. The growth of each
+// phase is summarized as an empirical exponent: the
+// slope of log(time) against log(size) between the
+// first and last steps. An exponent near 1 is linear.
+
+#include "beaker/bench/harness.hpp"
+#include "beaker/bench/synth.hpp"
+#include "beaker/options.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+
+static void
+usage(std::ostream& os, po::options_description& desc)
+{
+  os << "usage: beaker-scale [options]\n";
+  os << desc << '\n';
+}
+
+
+// Returns the configuration for the given value
+// of the dimension, or false if the dimension is
+// not valid.
+static bool
+configure(Synth_config& conf, String const& dim, int n)
+{
+  if (dim == "size") {
+    conf.functions = n;
+    conf.sets = std::max(1, n / 8);
+    conf.records = std::max(1, n / 8);
+  } else if (dim == "overloads") {
+    conf.overloads = n;
+  } else if (dim == "depth") {
+    conf.depth = n;
+  } else if (dim == "nesting") {
+    conf.nesting = n;
+  } else if (dim == "strings") {
+    conf.strings = n;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+
+// Write the growth exponent of each phase between the
+// first and last results.
+static void
+summarize(std::ostream& os, Bench_result_seq const& rs, std::vector<int> const& ns)
+{
+  if (rs.size() < 2)
+    return;
+  Bench_result const& a = rs.front();
+  Bench_result const& b = rs.back();
+  double dn = std::log(double(ns.back()) / ns.front());
+  os << std::left << std::setw(12) << "phase"
+     << std::setw(12) << "time exp"
+     << std::setw(12) << "memory exp" << '\n';
+  for (Phase const& p : a.phases) {
+    Phase const* q = b.phase(p.name);
+    if (!q || !p.ok || !q->ok)
+      continue;
+    os << std::setw(12) << p.name << std::setw(12) << std::setprecision(3);
+    if (p.seconds > 0 && q->seconds > 0)
+      os << std::log(q->seconds / p.seconds) / dn;
+    else
+      os << '-';
+    os << std::setw(12);
+    if (p.allocated && q->allocated)
+      os << std::log(double(q->allocated) / p.allocated) / dn;
+    else
+      os << '-';
+    os << '\n';
+  }
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  Synth_config base;
+
+  po::options_description opts("Scaling options");
+  opts.add_options()
+    ("help",        po::bool_switch(),                   "Print this message and exit.")
+    ("output,o",    po::value<String>(),                 "Write results to the given file.")
+    ("format,f",    po::value<String>()->default_value("json"),
+     "Specify the output format (json or csv).")
+    ("dimension,d", po::value<String>()->default_value("size"),
+     "The dimension to vary (size, overloads, depth, nesting, or strings).")
+    ("start",       po::value<int>()->default_value(16), "The first value of the dimension.")
+    ("factor",      po::value<int>()->default_value(2),  "Multiply the dimension by this at each step.")
+    ("steps",       po::value<int>()->default_value(6),  "The number of steps.")
+    ("repeat,r",    po::value<int>()->default_value(3),  "Run each phase this many times.")
+    ("functions",   po::value<int>(&base.functions)->default_value(base.functions),
+     "Number of functions, when fixed.")
+    ("nesting",     po::value<int>(&base.nesting)->default_value(base.nesting),
+     "Nesting depth of statements, when fixed.");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, opts), vm);
+    po::notify(vm);
+  } catch(std::exception& err) {
+    std::cerr << "error: " << err.what() << "\n\n";
+    usage(std::cerr, opts);
+    return -1;
+  }
+
+  if (vm["help"].as<bool>()) {
+    usage(std::cout, opts);
+    return 0;
+  }
+
+  String dim = vm["dimension"].as<String>();
+  String fmt = vm["format"].as<String>();
+  if (!configure(base, dim, 1)) {
+    std::cerr << "error: invalid dimension\n\n";
+    usage(std::cerr, opts);
+    return -1;
+  }
+  if (fmt != "json" && fmt != "csv") {
+    std::cerr << "error: invalid output format\n\n";
+    usage(std::cerr, opts);
+    return -1;
+  }
+
+  // Only the front end and code generator are measured.
+  Bench_config conf;
+  conf.repeat = std::max(1, vm["repeat"].as<int>());
+  conf.interpret = false;
+  conf.native = false;
+
+  // Run each step.
+  Bench_result_seq results;
+  std::vector<int> ns;
+  int n = std::max(1, vm["start"].as<int>());
+  for (int i = 0; i < vm["steps"].as<int>(); ++i) {
+    Synth_config c = base;
+    configure(c, dim, n);
+    String src = synthesize(c);
+    String name = dim + "=" + std::to_string(n);
+    std::cerr << "running " << name << " (" << src.size() << " bytes)\n";
+    results.push_back(run_benchmark(name, src, conf));
+    ns.push_back(n);
+    n *= std::max(2, vm["factor"].as<int>());
+  }
+
+  // Write the results.
+  std::ofstream ofs;
+  if (vm.count("output"))
+    ofs.open(vm["output"].as<String>());
+  std::ostream& os = ofs.is_open() ? ofs : std::cout;
+  if (fmt == "json")
+    write_json(os, results);
+  else
+    write_csv(os, results);
+
+  summarize(std::cerr, results, ns);
+  std::cerr << "peak memory: " << bench_memory().peak << " bytes\n";
+  return 0;
+}
@@ -0,0 +1,185 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/bench/synth.hpp"
+
+#include <iostream>
+#include <sstream>
+
+
+namespace
+{
+
+// An output stream that tracks indentation.
+struct Emitter
+{
+  Emitter(std::ostream& os)
+    : os(os), indent(0)
+  { }
+
+  // Start a new line at the current indentation.
+  std::ostream& line()
+  {
+    for (int i = 0; i < indent; ++i)
+      os << "  ";
+    return os;
+  }
+
+  void open()  { line() << "{\n"; ++indent; }
+  void close() { --indent; line() << "}\n"; }
+
+  std::ostream& os;
+  int           indent;
+};
+
+
+// Returns the name of the nth record in the given
+// hierarchy.
+String
+record_name(int h, int n)
+{
+  return "R" + std::to_string(h) + "d" + std::to_string(n);
+}
+
+
+// Emit a record hierarchy. Each record derives from the
+// previous, adds a field, and overrides a virtual method.
+void
+synthesize_records(Emitter& e, Synth_config const& conf, int h)
+{
+  for (int d = 0; d < conf.depth; ++d) {
+    e.line() << "struct " << record_name(h, d);
+    if (d)
+      e.os << " : " << record_name(h, d - 1);
+    e.os << '\n';
+    e.open();
+    e.line() << "virtual def id() -> int { return " << d << "; }\n";
+    e.line() << "f" << d << " : int;\n";
+    e.close();
+    e.os << '\n';
+  }
+}
+
+
+// Emit an overload set. Overloads are distinguished
+// by their number of parameters.
+void
+synthesize_overloads(Emitter& e, Synth_config const& conf, int s)
+{
+  for (int n = 1; n <= conf.overloads; ++n) {
+    e.line() << "def ovl" << s << '(';
+    for (int i = 0; i < n; ++i)
+      e.os << (i ? ", " : "") << 'a' << i << " : int";
+    e.os << ") -> int { return a0 + " << n << "; }\n";
+  }
+  e.os << '\n';
+}
+
+
+// Emit the statements at the innermost level of a
+// function. These call an overload, use a record,
+// and evaluate string literals.
+void
+synthesize_leaf(Emitter& e, Synth_config const& conf, int f)
+{
+  if (conf.sets && conf.overloads) {
+    int n = f % conf.overloads + 1;
+    e.line() << "r = r + ovl" << f % conf.sets << '(';
+    for (int i = 0; i < n; ++i)
+      e.os << (i ? ", " : "") << 'r';
+    e.os << ");\n";
+  }
+  if (conf.records && conf.depth) {
+    e.line() << "var o : " << record_name(f % conf.records, conf.depth - 1) << ";\n";
+    e.line() << "o.f0 = r;\n";
+    e.line() << "r = r + o.f0 + o.id();\n";
+  }
+
+  // String literals are drawn from a small pool, so most
+  // of them are duplicates.
+  for (int i = 0; i < conf.strings; ++i)
+    e.line() << "\"str" << (f + i) % (2 * conf.strings) << "\";\n";
+}
+
+
+// Emit a nested block of statements. Even levels are
+// conditionals and odd levels are loops.
+void
+synthesize_nest(Emitter& e, Synth_config const& conf, int f, int level)
+{
+  if (level == conf.nesting) {
+    synthesize_leaf(e, conf, f);
+    return;
+  }
+
+  String v = "v" + std::to_string(level);
+  if (level % 2 == 0) {
+    e.line() << "if (r < " << level + 10 << ")\n";
+    e.open();
+    e.line() << "var " << v << " : int = r + " << level << ";\n";
+    synthesize_nest(e, conf, f, level + 1);
+    e.line() << "r = r + " << v << ";\n";
+    e.close();
+  } else {
+    e.line() << "var " << v << " : int = 0;\n";
+    e.line() << "while (" << v << " < 2)\n";
+    e.open();
+    synthesize_nest(e, conf, f, level + 1);
+    e.line() << v << " = " << v << " + 1;\n";
+    e.close();
+  }
+}
+
+
+// Emit a function. Each function calls the previous
+// one, so the call graph is a chain.
+void
+synthesize_function(Emitter& e, Synth_config const& conf, int f)
+{
+  e.line() << "def fn" << f << "(x : int) -> int\n";
+  e.open();
+  if (f)
+    e.line() << "var r : int = fn" << f - 1 << "(x) % 100;\n";
+  else
+    e.line() << "var r : int = x;\n";
+  synthesize_nest(e, conf, f, 0);
+  e.line() << "return r;\n";
+  e.close();
+  e.os << '\n';
+}
+
+
+} // namespace
+
+
+// Write a synthesized module to the output stream.
+void
+synthesize(std::ostream& os, Synth_config const& conf)
+{
+  Emitter e(os);
+  os << "// Synthesized by beaker-synth.\n\n";
+  for (int i = 0; i < conf.records; ++i)
+    synthesize_records(e, conf, i);
+  for (int i = 0; i < conf.sets; ++i)
+    synthesize_overloads(e, conf, i);
+  for (int i = 0; i < conf.functions; ++i)
+    synthesize_function(e, conf, i);
+
+  e.line() << "def main() -> int\n";
+  e.open();
+  if (conf.functions)
+    e.line() << "return fn" << conf.functions - 1 << "(1) % 256;\n";
+  else
+    e.line() << "return 0;\n";
+  e.close();
+}
+
+
+// Returns the text of a synthesized module.
+String
+synthesize(Synth_config const& conf)
+{
+  std::stringstream ss;
+  synthesize(ss, conf);
+  return ss.str();
+}
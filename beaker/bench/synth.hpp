@@ -0,0 +1,33 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_BENCH_SYNTH_HPP
+#define BEAKER_BENCH_SYNTH_HPP
+
+// The synthesizer generates large, valid Beaker modules
+// for scaling tests. The shape of the module is
+// determined by a small number of counts.
+
+#include <beaker/prelude.hpp>
+
+#include <iosfwd>
+
+
+// Determines the shape of a synthesized module.
+struct Synth_config
+{
+  int functions = 10; // Number of ordinary functions
+  int overloads = 4;  // Number of functions in each overload set
+  int sets      = 2;  // Number of overload sets
+  int records   = 2;  // Number of record hierarchies
+  int depth     = 3;  // Depth of each record hierarchy
+  int nesting   = 2;  // Nesting depth of statements in each function
+  int strings   = 4;  // Number of string literals in each function
+};
+
+
+void synthesize(std::ostream&, Synth_config const&);
+String synthesize(Synth_config const&);
+
+
+#endif
@@ -0,0 +1,68 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// The beaker-synth program writes a synthesized Beaker
+// module whose shape is given on the command line.
+
+#include "beaker/bench/synth.hpp"
+#include "beaker/options.hpp"
+
+#include <fstream>
+#include <iostream>
+
+
+static void
+usage(std::ostream& os, po::options_description& desc)
+{
+  os << "usage: beaker-synth [options]\n";
+  os << desc << '\n';
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  Synth_config conf;
+
+  po::options_description opts("Synthesis options");
+  opts.add_options()
+    ("help",       po::bool_switch(),                              "Print this message and exit.")
+    ("output,o",   po::value<String>(),                            "Write the module to the given file.")
+    ("functions",  po::value<int>(&conf.functions)->default_value(conf.functions),
+     "Number of functions.")
+    ("overloads",  po::value<int>(&conf.overloads)->default_value(conf.overloads),
+     "Number of functions in each overload set.")
+    ("sets",       po::value<int>(&conf.sets)->default_value(conf.sets),
+     "Number of overload sets.")
+    ("records",    po::value<int>(&conf.records)->default_value(conf.records),
+     "Number of record hierarchies.")
+    ("depth",      po::value<int>(&conf.depth)->default_value(conf.depth),
+     "Depth of each record hierarchy.")
+    ("nesting",    po::value<int>(&conf.nesting)->default_value(conf.nesting),
+     "Nesting depth of statements.")
+    ("strings",    po::value<int>(&conf.strings)->default_value(conf.strings),
+     "Number of string literals in each function.");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, opts), vm);
+    po::notify(vm);
+  } catch(std::exception& err) {
+    std::cerr << "error: " << err.what() << "\n\n";
+    usage(std::cerr, opts);
+    return -1;
+  }
+
+  if (vm["help"].as<bool>()) {
+    usage(std::cout, opts);
+    return 0;
+  }
+
+  if (vm.count("output")) {
+    std::ofstream ofs(vm["output"].as<String>());
+    synthesize(ofs, conf);
+  } else {
+    synthesize(std::cout, conf);
+  }
+  return 0;
+}
@@ -0,0 +1,138 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// The beaker-threads program measures the throughput of
+// engines that share a single frozen module. The module
+// is loaded once. For each number of threads, every
+// thread creates its own engine over that module and
+// calls a function repeatedly. The total number of calls
+// per second and the speedup over a single thread are
+// reported.
+
+#include "beaker/bench/harness.hpp"
+#include "beaker/engine.hpp"
+#include "beaker/error.hpp"
+#include "beaker/options.hpp"
+
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+
+static void
+usage(std::ostream& os, po::options_description& desc)
+{
+  os << "usage: beaker-threads [options] input-file\n";
+  os << desc << '\n';
+}
+
+
+// Run n calls of the function named fn on each of k
+// threads, returning the number of calls per second.
+// Engines are created before the clock starts.
+static double
+run(Engine const& eng, String const& fn, int k, int n, std::atomic<Integer_value>& sum)
+{
+  std::atomic<int> ready(0);
+  std::atomic<bool> go(false);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < k; ++i) {
+    threads.emplace_back([&]() {
+      Engine e(&eng);
+      Function_handle f = e.function(fn);
+      ++ready;
+      while (!go)
+        std::this_thread::yield();
+      Integer_value s = 0;
+      for (int j = 0; j < n; ++j)
+        s += f.call<Integer_value>();
+      sum += s;
+    });
+  }
+  while (ready != k)
+    std::this_thread::yield();
+
+  Bench_timer t;
+  go = true;
+  for (std::thread& th : threads)
+    th.join();
+  return double(k) * n / t.elapsed();
+}
+
+
+int
+main(int argc, char* argv[])
+{
+  int hw = std::max(1u, std::thread::hardware_concurrency());
+
+  po::options_description opts("Thread options");
+  opts.add_options()
+    ("help",       po::bool_switch(),                       "Print this message and exit.")
+    ("input,i",    po::value<String>(),                     "Specify the input file.")
+    ("function,f", po::value<String>()->default_value("main"),
+     "The function to call. It must take no arguments and return an integer.")
+    ("threads,t",  po::value<int>()->default_value(hw),     "The largest number of threads.")
+    ("count,n",    po::value<int>()->default_value(10000),  "The number of calls per thread.");
+
+  po::positional_options_description positional_opts;
+  positional_opts.add("input", 1);
+
+  po::variables_map vm;
+  try {
+    po::store(
+      po::command_line_parser(argc, argv)
+        .options(opts)
+        .positional(positional_opts)
+        .run(),
+      vm);
+    po::notify(vm);
+  } catch(std::exception& err) {
+    std::cerr << "error: " << err.what() << "\n\n";
+    usage(std::cerr, opts);
+    return -1;
+  }
+  if (vm["help"].as<bool>()) {
+    usage(std::cout, opts);
+    return 0;
+  }
+  if (!vm.count("input")) {
+    std::cerr << "error: no input file\n\n";
+    usage(std::cerr, opts);
+    return -1;
+  }
+
+  String fn = vm["function"].as<String>();
+  int max = std::max(1, vm["threads"].as<int>());
+  int n = std::max(1, vm["count"].as<int>());
+
+  try {
+    Engine eng;
+    eng.load(vm["input"].as<String>());
+    eng.function(fn);
+
+    std::atomic<Integer_value> sum(0);
+    std::cout << std::left << std::setw(10) << "threads"
+              << std::setw(16) << "calls/s"
+              << "speedup" << '\n' << std::fixed;
+    double base = 0;
+    for (int k = 1; k <= max; k *= 2) {
+      double r = run(eng, fn, k, n, sum);
+      if (k == 1)
+        base = r;
+      std::cout << std::setw(10) << k
+                << std::setw(16) << std::setprecision(0) << r
+                << std::setprecision(2) << r / base << '\n';
+      if (k < max && k * 2 > max)
+        k = max / 2;
+    }
+    std::cerr << "checksum: " << sum << '\n';
+  } catch (Translation_error& err) {
+    diagnose(err);
+    return -1;
+  } catch (std::runtime_error& err) {
+    std::cerr << "error: " << err.what() << '\n';
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,460 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/bounds.hpp"
+#include "beaker/type.hpp"
+#include "beaker/expr.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/stmt.hpp"
+#include "beaker/value.hpp"
+
+#include <limits>
+#include <unordered_set>
+
+
+namespace
+{
+
+using Decl_set = std::unordered_set<Decl const*>;
+
+
+// -------------------------------------------------------------------------- //
+// Traversal
+
+// Calls f on each operand of e.
+template<typename F>
+void
+for_each_operand(Expr* e, F f)
+{
+  if (Unary_expr* u = as<Unary_expr>(e)) {
+    f(u->operand());
+  } else if (Binary_expr* b = as<Binary_expr>(e)) {
+    f(b->left());
+    f(b->right());
+  } else if (Call_expr* c = as<Call_expr>(e)) {
+    f(c->target());
+    for (Expr* a : c->arguments())
+      f(a);
+  } else if (Dot_expr* d = as<Dot_expr>(e)) {
+    f(d->container());
+  } else if (Index_expr* x = as<Index_expr>(e)) {
+    f(x->array());
+    f(x->index());
+  } else if (Vector_expr* v = as<Vector_expr>(e)) {
+    for (Expr* x : v->elements())
+      f(x);
+  } else if (Shuffle_expr* x = as<Shuffle_expr>(e)) {
+    f(x->vector());
+  } else if (Conv* c = as<Conv>(e)) {
+    f(c->source());
+  } else if (Copy_init* i = as<Copy_init>(e)) {
+    f(i->value());
+  } else if (Reference_init* i = as<Reference_init>(e)) {
+    f(i->object());
+  }
+}
+
+
+// Calls fe on each expression of s and fs on each
+// statement nested directly within s.
+template<typename F, typename G>
+void
+for_each_part(Stmt* s, F fe, G fs)
+{
+  if (Block_stmt* b = as<Block_stmt>(s)) {
+    for (Stmt* x : b->statements())
+      fs(x);
+  } else if (Assign_stmt* a = as<Assign_stmt>(s)) {
+    fe(a->object());
+    fe(a->value());
+  } else if (Return_stmt* r = as<Return_stmt>(s)) {
+    if (r->value())
+      fe(r->value());
+  } else if (If_then_stmt* i = as<If_then_stmt>(s)) {
+    fe(i->condition());
+    fs(i->body());
+  } else if (If_else_stmt* i = as<If_else_stmt>(s)) {
+    fe(i->condition());
+    fs(i->true_branch());
+    fs(i->false_branch());
+  } else if (Switch_stmt* w = as<Switch_stmt>(s)) {
+    fe(w->condition());
+    for (Switch_case const& k : w->cases())
+      fs(k.body());
+    if (w->default_case())
+      fs(w->default_case());
+  } else if (While_stmt* w = as<While_stmt>(s)) {
+    fe(w->condition());
+    fs(w->body());
+  } else if (For_stmt* l = as<For_stmt>(s)) {
+    fe(l->lower());
+    fe(l->upper());
+    fs(l->body());
+  } else if (Parallel_for_stmt* l = as<Parallel_for_stmt>(s)) {
+    fe(l->lower());
+    fe(l->upper());
+    fs(l->body());
+  } else if (Expression_stmt* x = as<Expression_stmt>(s)) {
+    fe(x->expression());
+  } else if (Declaration_stmt* d = as<Declaration_stmt>(s)) {
+    if (Variable_decl* v = as<Variable_decl>(d->declaration()))
+      if (v->init())
+        fe(v->init());
+  }
+}
+
+
+// Calls f on each index expression in e.
+template<typename F>
+void
+for_each_index(Expr* e, F f)
+{
+  if (Index_expr* x = as<Index_expr>(e))
+    f(x);
+  for_each_operand(e, [&](Expr* x) { for_each_index(x, f); });
+}
+
+
+// Calls f on each index expression in s.
+template<typename F>
+void
+for_each_index(Stmt* s, F f)
+{
+  for_each_part(s,
+    [&](Expr* e) { for_each_index(e, f); },
+    [&](Stmt* x) { for_each_index(x, f); });
+}
+
+
+// Calls f on each assignment in s.
+template<typename F>
+void
+for_each_assign(Stmt* s, F f)
+{
+  if (Assign_stmt* a = as<Assign_stmt>(s))
+    f(a);
+  for_each_part(s,
+    [](Expr*) { },
+    [&](Stmt* x) { for_each_assign(x, f); });
+}
+
+
+// -------------------------------------------------------------------------- //
+// Variables
+
+// Returns the variable or parameter named by e, or
+// nullptr if e does not name one.
+Decl const*
+as_variable(Expr const* e)
+{
+  if (Decl_expr const* d = as<Decl_expr>(e))
+    if (is<Variable_decl>(d->declaration()) || is<Parameter_decl>(d->declaration()))
+      return d->declaration();
+  return nullptr;
+}
+
+
+// Returns the variable whose value is read by e, or
+// nullptr if e does not read a variable.
+Decl const*
+as_value_of(Expr const* e)
+{
+  if (Value_conv const* c = as<Value_conv>(e))
+    return as_variable(c->source());
+  return nullptr;
+}
+
+
+// Returns true if e is an integer literal, and sets
+// n to its value.
+bool
+as_literal(Expr const* e, Integer_value& n)
+{
+  if (Literal_expr const* l = as<Literal_expr>(e)) {
+    if (l->value().is_integer()) {
+      n = l->value().get_integer();
+      return true;
+    }
+  }
+  return false;
+}
+
+
+// The variables of a function that are bound to
+// references, and those that are assigned.
+struct Function_vars
+{
+  Decl_set escaped;
+  Decl_set assigned;
+
+  void scan(Expr*);
+  void scan(Stmt*);
+
+  bool is_counter(Decl const*) const;
+  bool as_constant(Expr const*, Integer_value&) const;
+};
+
+
+// Record the variables named by e that are not only
+// read.
+void
+Function_vars::scan(Expr* e)
+{
+  if (as_value_of(e))
+    return;
+  if (Decl const* d = as_variable(e)) {
+    escaped.insert(d);
+    return;
+  }
+  for_each_operand(e, [&](Expr* x) { scan(x); });
+}
+
+
+void
+Function_vars::scan(Stmt* s)
+{
+  if (Assign_stmt* a = as<Assign_stmt>(s)) {
+    if (Decl const* d = as_variable(a->object()))
+      assigned.insert(d);
+    else
+      scan(a->object());
+    scan(a->value());
+    return;
+  }
+  for_each_part(s,
+    [&](Expr* e) { scan(e); },
+    [&](Stmt* x) { scan(x); });
+}
+
+
+// Returns true if d is an integer variable that can
+// only be modified by assigning to it. A global variable
+// can also be modified by any function that is called,
+// so it is never a counter or a constant.
+bool
+Function_vars::is_counter(Decl const* d) const
+{
+  if (!d || !is<Integer_type>(d->type()) || escaped.count(d))
+    return false;
+  Variable_decl const* v = as<Variable_decl>(d);
+  return !v || !is_global_variable(v);
+}
+
+
+// Returns true if e is a constant, and sets n to its
+// value.
+bool
+Function_vars::as_constant(Expr const* e, Integer_value& n) const
+{
+  if (as_literal(e, n))
+    return true;
+  Decl const* d = as_value_of(e);
+  if (!is_counter(d) || assigned.count(d) || !is<Variable_decl>(d))
+    return false;
+  Variable_decl const* v = cast<Variable_decl>(d);
+  Copy_init const* i = as<Copy_init>(v->init());
+  return i && as_literal(i->value(), n);
+}
+
+
+// -------------------------------------------------------------------------- //
+// Elision of checks
+
+// Returns the number of elements in the array or vector
+// indexed by e.
+inline Integer_value
+extent(Index_expr const* e)
+{
+  Type const* t = e->array()->type()->nonref();
+  if (Vector_type const* v = as<Vector_type>(t))
+    return v->size();
+  return cast<Array_type>(t)->size();
+}
+
+
+// Returns true if the statement s sets i to its initial
+// value, and sets n to that value.
+bool
+is_initializer(Stmt const* s, Decl const* i, Integer_value& n)
+{
+  if (Declaration_stmt const* d = as<Declaration_stmt>(s)) {
+    if (d->declaration() != i)
+      return false;
+    Copy_init const* c = as<Copy_init>(cast<Variable_decl>(i)->init());
+    return c && as_literal(c->value(), n);
+  }
+  if (Assign_stmt const* a = as<Assign_stmt>(s))
+    return as_variable(a->object()) == i && as_literal(a->value(), n);
+  return false;
+}
+
+
+// Returns true if s is the increment i = i + c, where
+// c is non-negative and no greater than max.
+bool
+is_increment(Assign_stmt const* s, Decl const* i, Integer_value max)
+{
+  Add_expr const* e = as<Add_expr>(s->value());
+  if (!e || as_value_of(e->left()) != i)
+    return false;
+  Integer_value c;
+  return as_literal(e->right(), c) && 0 <= c && c <= max;
+}
+
+
+// Returns true if s assigns to i.
+bool
+assigns(Stmt* s, Decl const* i)
+{
+  bool result = false;
+  for_each_assign(s, [&](Assign_stmt* a) {
+    if (as_variable(a->object()) == i)
+      result = true;
+  });
+  return result;
+}
+
+
+// Elide the checks of indexes by the counter of the
+// loop s, which is preceded by the statement p.
+void
+elide_counter(Function_vars const& vars, While_stmt* s, Stmt const* p)
+{
+  // The condition is i < n or i <= n.
+  Binary_expr const* c = as<Lt_expr>(s->condition());
+  if (!c)
+    c = as<Le_expr>(s->condition());
+  if (!c)
+    return;
+  Decl const* i = as_value_of(c->left());
+  if (!vars.is_counter(i))
+    return;
+  Integer_value n;
+  if (!vars.as_constant(c->right(), n))
+    return;
+  if (is<Le_expr>(c))
+    ++n;
+
+  // The counter starts at a non-negative value.
+  Integer_value first;
+  if (!is_initializer(p, i, first) || first < 0)
+    return;
+
+  // The counter is only incremented, and the increment
+  // cannot overflow.
+  Integer_value max = std::numeric_limits<int>::max() - n;
+  bool ok = true;
+  for_each_assign(s->body(), [&](Assign_stmt* a) {
+    if (as_variable(a->object()) == i && !is_increment(a, i, max))
+      ok = false;
+  });
+  if (!ok)
+    return;
+
+  // Elide the checks that precede the first increment.
+  auto elide = [&](Index_expr* x) {
+    if (as_value_of(x->index()) == i && n <= extent(x))
+      x->safe = true;
+  };
+  if (Block_stmt* b = as<Block_stmt>(s->body())) {
+    for (Stmt* x : b->statements()) {
+      if (assigns(x, i))
+        break;
+      for_each_index(x, elide);
+    }
+  } else if (!assigns(s->body(), i)) {
+    for_each_index(s->body(), elide);
+  }
+}
+
+
+// Elide the checks of indexes by the variable of the
+// range loop s (a for or parallel for loop). If the
+// variable is never assigned, it is within the bounds
+// of the loop.
+template<typename T>
+void
+elide_range(Function_vars const& vars, T* s)
+{
+  Variable_decl const* var = s->variable();
+  if (!vars.is_counter(var) || vars.assigned.count(var))
+    return;
+  Integer_value first, n;
+  if (!vars.as_constant(s->lower(), first) || first < 0)
+    return;
+  if (!vars.as_constant(s->upper(), n))
+    return;
+  for_each_index(s->body(), [&](Index_expr* x) {
+    if (as_value_of(x->index()) == var && n <= extent(x))
+      x->safe = true;
+  });
+}
+
+
+// Elide the checks of the counters of loops in s.
+void
+elide_counters(Function_vars const& vars, Stmt* s)
+{
+  if (For_stmt* l = as<For_stmt>(s))
+    elide_range(vars, l);
+  if (Parallel_for_stmt* l = as<Parallel_for_stmt>(s))
+    elide_range(vars, l);
+  if (Block_stmt* b = as<Block_stmt>(s)) {
+    Stmt const* p = nullptr;
+    for (Stmt* x : b->statements()) {
+      if (While_stmt* w = as<While_stmt>(x))
+        if (p)
+          elide_counter(vars, w, p);
+      elide_counters(vars, x);
+      p = x;
+    }
+    return;
+  }
+  for_each_part(s,
+    [](Expr*) { },
+    [&](Stmt* x) { elide_counters(vars, x); });
+}
+
+
+// Elide the checks of literal indexes in s.
+void
+elide_literals(Stmt* s)
+{
+  for_each_index(s, [](Index_expr* x) {
+    Integer_value n;
+    if (as_literal(x->index(), n) && 0 <= n && n < extent(x))
+      x->safe = true;
+  });
+}
+
+
+void
+elide_bounds_checks(Function_decl* f)
+{
+  if (!f->body())
+    return;
+  Function_vars vars;
+  vars.scan(f->body());
+  elide_literals(f->body());
+  elide_counters(vars, f->body());
+}
+
+
+} // namespace
+
+
+// Mark the indexes of the module that are known to be
+// within bounds.
+void
+elide_bounds_checks(Module_decl* m)
+{
+  for (Decl* d : m->declarations()) {
+    if (Function_decl* f = as<Function_decl>(d)) {
+      elide_bounds_checks(f);
+    } else if (Record_decl* r = as<Record_decl>(d)) {
+      for (Decl* x : r->members())
+        if (Function_decl* f = as<Function_decl>(x))
+          elide_bounds_checks(f);
+    }
+  }
+}
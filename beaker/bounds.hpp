@@ -0,0 +1,45 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_BOUNDS_HPP
+#define BEAKER_BOUNDS_HPP
+
+// The bounds module determines which array indexes are
+// known to be within the bounds of their arrays. The
+// evaluator and generator omit the bounds checks of
+// those indexes. An index is known to be in bounds when
+// it is:
+//
+// - an integer literal less than the extent of the
+//   array, or
+// - the counter i of a loop of the form
+//
+//      i = c;
+//      while (i < n) s
+//
+//   where c is non-negative, n is a constant no greater
+//   than the extent of the array, every assignment to i
+//   in s increments it by a constant, and the index
+//   occurs in s before the first statement that
+//   assigns to i, or
+// - the variable x of a loop of the form
+//
+//      for x in c .. n s
+//      parallel for x in c .. n s
+//
+//   where c is non-negative, n is a constant no greater
+//   than the extent of the array, and s does not assign
+//   to x.
+//
+// A constant is an integer literal or a variable that is
+// initialized with a literal and never assigned. Variables
+// that are bound to references are never considered, since
+// they can be modified through the reference.
+
+#include <beaker/prelude.hpp>
+
+
+void elide_bounds_checks(Module_decl*);
+
+
+#endif
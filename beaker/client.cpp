@@ -0,0 +1,47 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// The beaker-client program runs a compilation on a
+// compile server started by beaker-compile --server.
+// The arguments are the same as those of beaker-compile.
+// The output of the compilation is written to the
+// client's streams, and the client exits with the
+// status of the compilation.
+
+#include "beaker/server.hpp"
+
+#include <climits>
+#include <iostream>
+
+#include <unistd.h>
+
+
+int
+main(int argc, char* argv[])
+{
+  std::string path = default_server_socket();
+  int fd = connect_server(path);
+  if (fd < 0) {
+    std::cerr << "error: no compile server at '" << path << "'\n";
+    return -1;
+  }
+
+  char cwd[PATH_MAX];
+  if (!getcwd(cwd, sizeof(cwd))) {
+    std::cerr << "error: cannot determine the working directory\n";
+    return -1;
+  }
+
+  Server_request req;
+  req.cwd = cwd;
+  req.args.assign(argv, argv + argc);
+  req.out = STDOUT_FILENO;
+  req.err = STDERR_FILENO;
+
+  int status;
+  if (!send_request(fd, req) || !recv_status(fd, status)) {
+    std::cerr << "error: lost connection to the compile server\n";
+    return -1;
+  }
+  return status;
+}
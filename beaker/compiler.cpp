@@ -8,10 +8,21 @@
 #include "beaker/decl.hpp"
 #include "beaker/elaborator.hpp"
 #include "beaker/generator.hpp"
+#include "beaker/interface.hpp"
 #include "beaker/error.hpp"
+#include "beaker/server.hpp"
 
+#include <csignal>
+#include <cstdio>
 #include <iostream>
 #include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+
+#include <sys/socket.h>
+#include <unistd.h>
 
 // FIXME: It would be better if the generator hid all
 // of these details from us.
@@ -34,6 +45,7 @@ struct Config
   bool keep     = false;
   bool assemble = false;
   bool compile  = false;
+  bool checked  = false;
   Target target = program_tgt;
 };
 
@@ -46,7 +58,12 @@ usage(std::ostream& os, po::options_description& desc)
 }
 
 
-static bool parse(Path const&, Config const&);
+static int  compile(int, char*[]);
+static int  serve(String const&);
+static int  run_request(Server_request const&);
+
+static bool lex(Path const&, Token_stream&);
+static bool parse(Path const&, Location_map&, Module_decl&, Config const&);
 static bool parse(Path_seq const&, Path const&, Config const&);
 
 static bool lower(Path const&, Path const&, Config const&);
@@ -55,10 +72,23 @@ static bool executable(Path_seq const&, Path const&, Config const&);
 static bool module(Path_seq const&, Path const&, Config const&);
 
 
-// Global resources.
-Location_map locs; // Source code locations
+// The tokens of a source file. The file is kept with
+// its tokens, since their locations refer to it. A file
+// is lexed again only when its contents change.
+struct Source_tokens
+{
+  std::unique_ptr<File> file;
+  std::size_t           hash;
+  std::size_t           size;
+  std::vector<Token>    toks;
+};
+
+
+// Global resources. These persist between the
+// compilations run by the compile server.
 Symbol_table syms; // The symbol table
-Module_decl  mod;  // The translation module
+bool serving = false; // True when running as a server
+std::unordered_map<String, Source_tokens> sources; // Lexed files
 
 
 int
@@ -66,14 +96,23 @@ compiler_main(int argc, char* argv[])
 {
   init_colors();
   init_symbols(syms);
+  return compile(argc, argv);
+}
+
 
+// Run a compilation with the given command line.
+int
+compile(int argc, char* argv[])
+{
   po::options_description common_opts("Common options");
   common_opts.add_options()
     ("help",      po::bool_switch(),        "Print this message and exit.")
     ("version",   po::bool_switch(),        "Print version information and exit.")
     ("input,i",   po::value<String_seq>(),  "Specify input files.")
     ("output,o",  po::value<String>(),      "Specify the output file.")
-    ("keep,k",    po::bool_switch(),        "Keep temporary files.");
+    ("keep,k",    po::bool_switch(),        "Keep temporary files.")
+    ("server",    po::value<String>()->implicit_value(default_server_socket()),
+     "Run as a compile server listening on the given socket.");
 
   // FIXME: These really define the compilation mode.
   // Here are some rules:
@@ -84,6 +123,7 @@ compiler_main(int argc, char* argv[])
   compile_opts.add_options()
     ("assemble,s",  po::bool_switch(),  "Compile to native assembly.")
     ("compile,c",   po::bool_switch(),  "Compile but do not link.")
+    ("checked",     po::bool_switch(),  "Check array indexes at run time.")
     ("target,t",    po::value<String>()->default_value("program"),
      "Specify whether a program or module should be produced.");
 
@@ -120,10 +160,22 @@ compiler_main(int argc, char* argv[])
     return 0;
   }
 
+  // Run the server, if requested.
+  if (vm.count("server")) {
+    if (serving) {
+      std::cerr << "error: already running as a server\n";
+      return -1;
+    }
+    return serve(vm["server"].as<String>());
+  }
+
   // Check options.
   if (vm["compile"].as<bool>())
     conf.compile = true;
 
+  if (vm["checked"].as<bool>())
+    conf.checked = true;
+
   if (vm["assemble"].as<bool>()) {
     conf.assemble = true;
     conf.compile = true;
@@ -146,9 +198,18 @@ compiler_main(int argc, char* argv[])
     usage(std::cerr, all_opts);
     return -1;
   }
+  //
+  // Object files are passed through to the linker. This
+  // allows modules to be compiled separately and then
+  // linked together.
   Path_seq inputs;
-  for (String const& s : vm["input"].as<String_seq>())
-    inputs.push_back(s);
+  Path_seq objects;
+  for (String const& s : vm["input"].as<String_seq>()) {
+    if (get_file_kind(s) == object_file)
+      objects.push_back(s);
+    else
+      inputs.push_back(s);
+  }
 
   // Look for an output file. If not given, assume that
   // the end result is going to be a native binary. Note
@@ -168,46 +229,171 @@ compiler_main(int argc, char* argv[])
   // files to the next phase of translation.
   //
   // FIXME: Clean up temporary files.
-  Path ir = to_ir_file(output);
-  if (!parse(inputs, ir, conf))
-    return -1;
-
-  Path as = to_asm_file(output);
-  if (!lower(ir, as, conf))
-    return -1;
-  if (conf.assemble)
-    return 0;
-
-  Path obj = to_object_file(output);
-  if (!assemble(as, obj, conf))
-    return -1;
+  if (!inputs.empty()) {
+    Path ir = to_ir_file(output);
+    if (!parse(inputs, ir, conf))
+      return -1;
+
+    Path as = to_asm_file(output);
+    if (!lower(ir, as, conf))
+      return -1;
+    if (conf.assemble)
+      return 0;
+
+    Path obj = to_object_file(output);
+    if (!assemble(as, obj, conf))
+      return -1;
+    objects.push_back(obj);
+  }
   if (conf.compile)
     return 0;
 
   // Generate the linked result.
   if (conf.target == program_tgt)
-    return executable({obj}, output, conf);
+    return executable(objects, output, conf);
   if (conf.target == module_tgt)
-    return module({obj}, output, conf);
+    return module(objects, output, conf);
 
   return 0;
 }
 
 
-// Parse the input file into the module.
+// Run compilations for the clients of the server
+// listening on the socket at path. The server runs
+// until it is killed.
+int
+serve(String const& path)
+{
+  int fd = open_server(path);
+  if (fd < 0) {
+    std::cerr << "error: cannot listen on '" << path << "'\n";
+    return -1;
+  }
+  serving = true;
+
+  // A client that goes away must not stop the server.
+  std::signal(SIGPIPE, SIG_IGN);
+
+  while (true) {
+    int c = accept(fd, nullptr, nullptr);
+    if (c < 0)
+      continue;
+
+    // Compilations run as the server's user, so only
+    // that user can request them.
+    if (!is_same_user(c)) {
+      close(c);
+      continue;
+    }
+    Server_request req;
+    if (recv_request(c, req)) {
+      send_status(c, run_request(req));
+      close(req.out);
+      close(req.err);
+    }
+    close(c);
+  }
+}
+
+
+// Run the compilation requested by a client in its
+// working directory, writing to its streams. Errors
+// that escape the compilation are diagnosed here, so
+// that they do not stop the server.
+int
+run_request(Server_request const& req)
+{
+  std::cout.flush();
+  std::cerr.flush();
+  int out = dup(STDOUT_FILENO);
+  int err = dup(STDERR_FILENO);
+  dup2(req.out, STDOUT_FILENO);
+  dup2(req.err, STDERR_FILENO);
+
+  int status = -1;
+  if (chdir(req.cwd.c_str()) == 0) {
+    std::vector<char*> argv;
+    for (String const& s : req.args)
+      argv.push_back(const_cast<char*>(s.c_str()));
+    argv.push_back(nullptr);
+    try {
+      status = compile(argv.size() - 1, argv.data());
+    } catch (Translation_error& e) {
+      diagnose(e);
+    } catch (std::exception& e) {
+      std::cerr << "error: " << e.what() << '\n';
+    }
+  } else {
+    std::cerr << "error: cannot enter directory '" << req.cwd << "'\n";
+  }
+
+  std::cout.flush();
+  std::cerr.flush();
+  std::fflush(nullptr);
+  dup2(out, STDOUT_FILENO);
+  dup2(err, STDERR_FILENO);
+  close(out);
+  close(err);
+  return status;
+}
+
+
+// Lex the input file into the token stream. The tokens
+// of the file are saved, and reused until the contents
+// of the file change.
+//
+// Modification times are too coarse to detect a change,
+// since a file can be rewritten within one tick of the
+// clock, so the cache is keyed on a hash of the contents.
+// The contents are read before the file is lexed. If the
+// file changes in between, the hash does not match the
+// next time, and the file is lexed again.
 bool
-parse(Path const& in, Config const& conf)
+lex(Path const& in, Token_stream& ts)
 {
-  try {
-    // Read the input source.
-    File src = in.c_str();
-    Input_buffer buf = src;
+  std::ifstream ifs(in.c_str(), std::ios::binary);
+  if (!ifs) {
+    std::cerr << "error: cannot open '" << in.string() << "'\n";
+    return false;
+  }
+  String text(std::istreambuf_iterator<char>(ifs), {});
+  String key = fs::absolute(in).string();
+  std::size_t hash = std::hash<String>()(text);
+  std::size_t size = text.size();
+
+  Source_tokens& src = sources[key];
+  if (!src.file || src.file->path() != in || src.hash != hash || src.size != size) {
+    sources.erase(key);
 
     // Lex the input source.
-    Token_stream ts;
-    Location_map locs;
+    std::unique_ptr<File> file(new File(in.c_str()));
+    Input_buffer buf = *file;
+    Token_stream toks;
     Lexer lex(syms, buf);
-    if (!lex.lex(ts))
+    if (!lex.lex(toks))
+      return false;
+
+    Source_tokens& s = sources[key];
+    s.file = std::move(file);
+    s.hash = hash;
+    s.size = size;
+    while (!toks.eof())
+      s.toks.push_back(toks.get());
+  }
+
+  for (Token const& tok : sources[key].toks)
+    ts.put(tok);
+  return true;
+}
+
+
+// Parse the input file into the module.
+bool
+parse(Path const& in, Location_map& locs, Module_decl& mod, Config const& conf)
+{
+  try {
+    Token_stream ts;
+    if (!lex(in, ts))
       return false;
 
     // Parse the token stream.
@@ -233,10 +419,12 @@ parse(Path const& in, Config const& conf)
 bool
 parse(Path_seq const& in, Path const& out, Config const& conf)
 {
+  Location_map locs;
+  Module_decl mod;
   bool ok = true;
   for (Path const& p : in) {
     if (get_file_kind(p) == beaker_file)
-      ok &= parse(p, conf);
+      ok &= parse(p, locs, mod, conf);
     else {
       // FIXME: LLVM IR/BC or assembly could (should?) be
       // lowered and passed through to the link phase. That
@@ -254,7 +442,7 @@ parse(Path_seq const& in, Path const& out, Config const& conf)
   elab.elaborate(&mod);
 
   // Translate to LLVM.
-  Generator gen;
+  Generator gen(conf.checked);
   llvm::Module* ir = gen(&mod);
 
   // Write the output to an IR file, not the requested
@@ -265,6 +453,18 @@ parse(Path_seq const& in, Path const& out, Config const& conf)
   std::error_code err;
   llvm::raw_fd_ostream ofs(p.string(), err, llvm::sys::fs::F_None);
   ofs << *ir;
+
+  // When compiling a module that will be linked with
+  // others, write its interface next to the output.
+  if (conf.compile || conf.target == module_tgt) {
+    Path i = to_interface_file(out);
+    std::ofstream ifs(i.string(), std::ios::binary);
+    write_interface(ifs, &mod);
+    if (!ifs) {
+      std::cerr << "error: cannot write module interface '" << i.string() << "'\n";
+      return false;
+    }
+  }
   return true;
 }
 
@@ -298,9 +498,21 @@ assemble(Path const& in, Path const& out, Config const& conf)
 }
 
 
+// Add the runtime library and the libraries it needs to
+// the arguments of a link.
+static void
+add_runtime(String_seq& args)
+{
+  args.push_back(runtime_library());
+  if (*thread_library())
+    args.push_back(thread_library());
+}
+
+
 // Link a sequence of object files into an executable program.
 // Note that this uses the C compiler, so we implicitly link
-// against the C runtime.
+// against the C runtime. The Beaker runtime is linked after
+// the objects.
 //
 // TODO: Don't link against the C runtime!
 bool
@@ -311,6 +523,7 @@ executable(Path_seq const& in, Path const& out, Config const& conf)
   args.push_back(format("-o {}", out.string()));
   for (Path const& p : in)
     args.push_back(p.string());
+  add_runtime(args);
 
   // Build and run the job.
   Job job(native_linker(), args);
@@ -329,6 +542,7 @@ module(Path_seq const& in, Path const& out, Config const& conf)
   args.push_back(format("-o {}", out.string()));
   for (Path const& p : in)
     args.push_back(p.string());
+  add_runtime(args);
 
   // Build and run the job.
   Job job(native_linker(), args);
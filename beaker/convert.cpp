@@ -155,7 +155,7 @@ convert(Expr* e, Type const* t)
 
   // Try to apply a type promotion
   if (is_scalar(t) && !is<Boolean_type>(e->type())) {
-    c = promote(e,t);
+    c = promote(c, t);
     if (c->type() == t)
         return c;
   }
@@ -192,6 +192,70 @@ convert(Expr* e, Type const* t)
 }
 
 
+// Returns the number of derivations between the record
+// d and its base b.
+inline int
+base_distance(Record_decl const* d, Record_decl const* b)
+{
+  return d->depth() - b->depth();
+}
+
+
+// Returns the cost of converting an expression of type
+// s to type t, or invalid_cost if there is no such
+// conversion. This follows the same rules as convert(),
+// but does not build any conversion expressions.
+//
+// TODO: Conversions to bool are not yet supported,
+// and are never valid.
+int
+conversion_cost(Type const* s, Type const* t)
+{
+  if (s == t)
+    return exact_cost;
+
+  // Object-to-value conversion.
+  Type const* c = s;
+  if (!is<Reference_type>(t)) {
+    c = s->nonref();
+    if (c == t)
+      return value_cost;
+  }
+
+  // Array-to-block conversion.
+  if (is<Block_type>(t)) {
+    if (Array_type const* a = as<Array_type>(c))
+      if (get_block_type(a->type()) == t)
+        return block_cost;
+  }
+
+  if (is<Boolean_type>(t))
+    return invalid_cost;
+
+  // Scalar promotion.
+  if (is_scalar(t) && !is<Boolean_type>(s)) {
+    if (get_scalar_rank(t) > get_scalar_rank(c))
+      return promotion_cost;
+    return invalid_cost;
+  }
+
+  // Derived-to-base conversion. The cost increases
+  // with the distance to the base class.
+  if (Reference_type const* r = as<Reference_type>(t)) {
+    if (Record_type const* goal = as<Record_type>(r->type())) {
+      if (Record_type const* d = as<Record_type>(c->nonref())) {
+        Record_decl const* d1 = d->declaration();
+        Record_decl const* b1 = goal->declaration();
+        if (d1->is_derived_from(b1))
+          return base_cost + base_distance(d1, b1);
+      }
+    }
+  }
+
+  return invalid_cost;
+}
+
+
 // Convert a sequence of arguments to a corresponding
 // parameter type. The conversion is successful only
 // when all individual conversions are successful.
@@ -15,6 +15,23 @@ class Elaborator;
 Expr*    convert(Expr*, Type const*);
 Expr_seq convert(Expr_seq const&, Type_seq const&);
 
+
+// The cost of an implicit conversion. Costs are used to
+// rank candidates during overload resolution: lower costs
+// are better. A derived-to-base conversion costs one more
+// for each level of derivation.
+enum Conversion_cost
+{
+  invalid_cost = -1, // No conversion exists
+  exact_cost,        // No conversion is required
+  value_cost,        // Object-to-value conversion
+  block_cost,        // Array-to-block conversion
+  promotion_cost,    // Scalar promotion
+  base_cost,         // Derived-to-base conversion
+};
+
+int conversion_cost(Type const*, Type const*);
+
 Expr* convert_to_value(Expr*);
 Type const* get_promotion_target(Expr*, Expr*);
 Type const* get_promotion_target(Expr*);
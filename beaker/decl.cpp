@@ -18,19 +18,6 @@ Function_decl::return_type() const
 }
 
 
-// Returns the index of this field within its record
-// declaration.
-int
-Field_decl::index() const
-{
-  Decl_seq const& f = context()->fields();
-  for (std::size_t i = 0; i < f.size(); ++i)
-    if (f[i] == this)
-      return i;
-  lingo_unreachable();
-}
-
-
 // Returns the record's base class type.
 Record_type const*
 Record_decl::base() const
@@ -49,6 +36,37 @@ Record_decl::base_declaration() const
 }
 
 
+// Returns the overload set of members named by the
+// symbol, or nullptr if there is no such member. If
+// the member table has not been computed, this searches
+// each record in the base class chain.
+Overload*
+Record_decl::lookup(Symbol const* sym)
+{
+  if (flat_) {
+    auto iter = lookup_.find(sym);
+    return iter != lookup_.end() ? iter->second : nullptr;
+  }
+  Record_decl* d = this;
+  do {
+    if (Scope::Binding* bind = d->scope_.lookup(sym))
+      return &bind->second;
+    d = d->base_declaration();
+  } while (d);
+  return nullptr;
+}
+
+
+// Returns true if this record is b or is derived
+// from b. This is a constant time test.
+bool
+Record_decl::is_derived_from(Record_decl const* b) const
+{
+  int n = b->depth();
+  return n <= depth() && display_[n] == b;
+}
+
+
 // Returns true if the record has no members.
 bool
 Record_decl::is_empty() const
@@ -36,6 +36,7 @@ struct Decl
   // Declaration specifiers
   Specifier specifiers() const { return spec_; }
   bool      is_foreign() const { return spec_ & foreign_spec; }
+  bool      is_imported() const { return spec_ & imported_spec; }
 
   Symbol const* name() const { return name_; }
   Type const*   type() const { return type_; }
@@ -82,7 +83,9 @@ struct Decl::Mutator
 };
 
 
-// Represents variable declarations.
+// Represents variable declarations. The slot of a
+// variable is its position in the frame of its
+// function or, for a global variable, its module.
 struct Variable_decl : Decl
 {
   Variable_decl(Symbol const* n, Type const* t, Expr* e)
@@ -99,19 +102,24 @@ struct Variable_decl : Decl
   Expr const* init() const { return init_; }
   Expr*       init()       { return init_; }
 
+  int slot() const { return slot_; }
+
   Expr* init_;
+  int   slot_ = -1;
 };
 
 
-// Represents function declarations.
+// Represents function declarations. The frame size
+// is the number of parameters and local variables
+// of the function.
 struct Function_decl : Decl
 {
   Function_decl(Symbol const* n, Type const* t, Decl_seq const& p, Stmt* b)
-    : Decl(n, t), parms_(p), body_(b)
+    : Decl(n, t), parms_(p), body_(b), vparms_(nullptr)
   { }
 
   Function_decl(Specifier spec, Symbol const* n, Type const* t, Decl_seq const& p, Stmt* b)
-    : Decl(spec, n, t), parms_(p), body_(b)
+    : Decl(spec, n, t), parms_(p), body_(b), vparms_(nullptr)
   { }
 
   void accept(Visitor& v) const { v.visit(this); }
@@ -127,23 +135,28 @@ struct Function_decl : Decl
   Stmt const* body() const { return body_; }
   Stmt*       body()       { return body_; }
 
+  int frame_size() const { return frame_; }
+
   Decl_seq  parms_;
   Stmt*     body_;
   Decl_seq* vparms_;
+  int       frame_ = 0;
 };
 
 
 
-// Represents parameter declarations.
-//
-// TODO: Does a parameter also need to keep track of
-// its index?
+// Represents parameter declarations. The parameters
+// of a function occupy the first slots of its frame.
 struct Parameter_decl : Decl
 {
   using Decl::Decl;
 
   void accept(Visitor& v) const { v.visit(this); }
   void accept(Mutator& v)       { v.visit(this); }
+
+  int slot() const { return slot_; }
+
+  int slot_ = -1;
 };
 
 
@@ -158,11 +171,32 @@ struct Parameter_decl : Decl
 // A record declaration defines a scope. Declarations
 // within the record are cached here for use during
 // member lookup.
+//
+// When the record is defined, three tables are computed
+// to avoid walking the base class chain:
+//
+// - The layout is the sequence of all fields of the
+//   record, including those of its bases. The fields
+//   of a base precede those of the derived class, so
+//   the offset of a field is the same in every record
+//   derived from its own.
+// - The member table maps each name declared in the
+//   record or any of its bases to its innermost overload
+//   set. Names in the record hide those of its bases.
+// - The display is the sequence of base classes from
+//   the root of the hierarchy to the record itself. A
+//   record D derives from B iff B is in D's display at
+//   the position given by B's depth.
+//
+// These tables are empty until they are computed.
 struct Record_decl : Decl
 {
+  using Member_table = std::unordered_map<Symbol const*, Overload*>;
+  using Display = std::vector<Record_decl const*>;
+
   Record_decl(Symbol const* n, Decl_seq const& f, Decl_seq const& m, Type const* base)
     : Decl(n, nullptr), scope_(this), fields_(f), members_(m)
-    , base_(base), vref_(nullptr), vtbl_(nullptr)
+    , base_(base), vref_(nullptr), vtbl_(nullptr), flat_(false)
   { }
 
   void accept(Visitor& v) const { v.visit(this); }
@@ -173,6 +207,7 @@ struct Record_decl : Decl
 
   Decl_seq const& fields() const  { return fields_; }
   Decl_seq const& members() const { return members_; }
+  Decl_seq const& layout() const  { return layout_; }
 
   Scope const*    scope() const { return &scope_; }
   Scope*          scope()       { return &scope_; }
@@ -185,18 +220,30 @@ struct Record_decl : Decl
 
   bool is_empty() const;
 
+  Overload* lookup(Symbol const*);
+
+  int  depth() const { return (int)display_.size() - 1; }
+  bool is_derived_from(Record_decl const*) const;
+
   Scope          scope_;
   Decl_seq       fields_;
   Decl_seq       members_;
   const Type*    base_;
   Decl*          vref_;
   Decl_seq*      vtbl_;
+  Decl_seq       layout_;
+  Member_table   lookup_;
+  Display        display_;
+  bool           flat_;
 };
 
 
 // A member variable of a record.
 //
-// TODO: Cache the field index?
+// The index of the field is its position in the
+// fields of its record. The offset is its position
+// in the record's layout. Both are computed when
+// the record is defined.
 struct Field_decl : Decl
 {
   using Decl::Decl;
@@ -206,7 +253,11 @@ struct Field_decl : Decl
 
   Record_decl const* context() const { return cast<Record_decl>(cxt_); }
 
-  int index() const;
+  int index() const  { return index_; }
+  int offset() const { return offset_; }
+
+  int index_ = -1;
+  int offset_ = -1;
 };
 
 
@@ -231,6 +282,7 @@ struct Method_decl : Function_decl
 
 
 // A module is a sequence of top-level declarations.
+// The frame of a module holds its global variables.
 struct Module_decl : Decl
 {
   Module_decl()
@@ -246,10 +298,28 @@ struct Module_decl : Decl
 
   Decl_seq const& declarations() const { return decls_; }
 
+  int frame_size() const { return frame_; }
+
+  bool is_frozen() const { return frozen_; }
+
   Decl_seq decls_;
+  int      frame_  = 0;
+  bool     frozen_ = false;
 };
 
 
+// Freeze the module m. A frozen module is complete: it
+// is not parsed into or elaborated again, and nothing
+// modifies it or its declarations. Any number of
+// evaluators may read a frozen module concurrently
+// without synchronization.
+inline void
+freeze(Module_decl* m)
+{
+  m->frozen_ = true;
+}
+
+
 // -------------------------------------------------------------------------- //
 // Queries
 
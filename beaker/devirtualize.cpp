@@ -0,0 +1,85 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/devirtualize.hpp"
+#include "beaker/type.hpp"
+#include "beaker/expr.hpp"
+#include "beaker/decl.hpp"
+
+
+// Returns the dynamic type of the object referred to by
+// e, if it is known statically. Otherwise, returns nullptr.
+//
+// The dynamic type of an object is known when it is
+// a variable, parameter, field, or array element of
+// record type. A base class sub-object has the dynamic
+// type of its complete object.
+Record_decl const*
+dynamic_type(Expr const* e)
+{
+  if (Base_conv const* c = as<Base_conv>(e))
+    return dynamic_type(c->source());
+
+  Type const* t = nullptr;
+  if (Decl_expr const* d = as<Decl_expr>(e)) {
+    Decl const* decl = d->declaration();
+    if (is<Variable_decl>(decl) || is<Parameter_decl>(decl))
+      t = decl->type();
+  } else if (Field_expr const* f = as<Field_expr>(e)) {
+    t = f->field()->type();
+  } else if (Index_expr const* i = as<Index_expr>(e)) {
+    t = i->type()->nonref();
+  }
+
+  if (Record_type const* r = as<Record_type>(t))
+    return r->declaration();
+  return nullptr;
+}
+
+
+// Record the derivations of each record in the module.
+void
+Devirtualizer::add(Module_decl const* m)
+{
+  for (Decl const* d : m->declarations()) {
+    if (Record_decl const* r = as<Record_decl>(d)) {
+      for (Record_decl const* b = r->base_declaration(); b; b = b->base_declaration())
+        derived[b].push_back(r);
+    }
+  }
+}
+
+
+// Returns the method called by a virtual call to m with
+// the object e, if it is known statically. Otherwise,
+// returns nullptr.
+Decl const*
+Devirtualizer::operator()(Method_decl const* m, Expr const* e)
+{
+  if (Record_decl const* r = dynamic_type(e))
+    return (*r->vtable())[m->vtable_entry()];
+  Record_type const* t = cast<Record_type>(e->type()->nonref());
+  return final_overrider(t->declaration(), m->vtable_entry());
+}
+
+
+// Returns the final overrider of the nth virtual method
+// of r if no class derived from r overrides it. Otherwise,
+// returns nullptr.
+Decl const*
+Devirtualizer::final_overrider(Record_decl const* r, int n)
+{
+  auto ins = overriders.emplace(Overrider_key(r, n), nullptr);
+  if (!ins.second)
+    return ins.first->second;
+
+  Decl const* f = (*r->vtable())[n];
+  auto iter = derived.find(r);
+  if (iter != derived.end()) {
+    for (Record_decl const* d : iter->second)
+      if ((*d->vtable())[n] != f)
+        return nullptr;
+  }
+  ins.first->second = f;
+  return f;
+}
@@ -0,0 +1,48 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_DEVIRTUALIZE_HPP
+#define BEAKER_DEVIRTUALIZE_HPP
+
+// The devirtualize module determines when the target
+// of a virtual call is known statically. That is the
+// case when:
+//
+// - the dynamic type of the object is known, or
+// - no class derived from the static type of the object
+//   overrides the method.
+//
+// The second case requires knowledge of every record
+// in the program.
+
+#include <beaker/prelude.hpp>
+
+#include <map>
+#include <unordered_map>
+
+
+Record_decl const* dynamic_type(Expr const*);
+
+
+// Maintains the record hierarchies of a module and
+// the final overriders computed from them.
+struct Devirtualizer
+{
+  using Record_seq = std::vector<Record_decl const*>;
+  using Overrider_key = std::pair<Record_decl const*, int>;
+
+  void add(Module_decl const*);
+
+  Decl const* operator()(Method_decl const*, Expr const*);
+  Decl const* final_overrider(Record_decl const*, int);
+
+  // The records derived from each record.
+  std::unordered_map<Record_decl const*, Record_seq> derived;
+
+  // The final overrider of each virtual table entry,
+  // or nullptr if there is more than one.
+  std::map<Overrider_key, Decl const*> overriders;
+};
+
+
+#endif
@@ -0,0 +1,196 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/dispatch.hpp"
+#include "beaker/type.hpp"
+#include "beaker/decl.hpp"
+
+#include <map>
+
+
+namespace
+{
+
+// Returns the record accepted by the nth parameter
+// of f. The parameter shall be virtual.
+Record_decl const*
+parameter_record(Function_decl const* f, int n)
+{
+  Decl const* p = f->parameters()[n];
+  return cast<Record_type>(p->type()->nonref())->declaration();
+}
+
+
+// Returns true if f1 and f2 belong to the same multimethod.
+bool
+same_family(Function_decl const* f1, Function_decl const* f2)
+{
+  if (f1->name() != f2->name())
+    return false;
+  Decl_seq const& p1 = f1->parameters();
+  Decl_seq const& p2 = f2->parameters();
+  if (p1.size() != p2.size())
+    return false;
+  for (std::size_t i = 0; i < p1.size(); ++i) {
+    if (p1[i]->is_virtual() != p2[i]->is_virtual())
+      return false;
+    if (!p1[i]->is_virtual() && p1[i]->type() != p2[i]->type())
+      return false;
+  }
+  return true;
+}
+
+
+// Returns true if every virtual parameter of f1 accepts
+// only records accepted by the same parameter of f2.
+bool
+is_more_specialized(Dispatch_table const& t, Function_decl const* f1, Function_decl const* f2)
+{
+  for (int n : t.parms)
+    if (!parameter_record(f1, n)->is_derived_from(parameter_record(f2, n)))
+      return false;
+  return true;
+}
+
+
+// Returns the unique most specialized function among
+// the candidates, or nullptr if there is none.
+Function_decl const*
+most_specialized(Dispatch_table const& t, Dispatch_table::Function_seq const& cands)
+{
+  for (Function_decl const* f1 : cands) {
+    bool best = true;
+    for (Function_decl const* f2 : cands)
+      if (f1 != f2 && !is_more_specialized(t, f1, f2))
+        best = false;
+    if (best)
+      return f1;
+  }
+  return nullptr;
+}
+
+
+// Build the dispatch table of a multimethod. The
+// records are those of the module, indexed by id.
+void
+build_table(Dispatch_table& t, Dispatch_map::Record_seq const& rs)
+{
+  using Mask = std::vector<bool>;
+
+  Decl_seq const& ps = t.family.front()->parameters();
+  for (std::size_t i = 0; i < ps.size(); ++i)
+    if (ps[i]->is_virtual())
+      t.parms.push_back(i);
+
+  // For each virtual parameter, group the records
+  // by the set of functions that accept them. Each
+  // group is a column.
+  std::vector<std::vector<Mask>> masks;
+  std::size_t size = 1;
+  for (int n : t.parms) {
+    std::map<Mask, int> cols;
+    std::vector<Mask> ms;
+    Dispatch_table::Column_seq c(rs.size());
+    for (std::size_t i = 0; i < rs.size(); ++i) {
+      Mask m(t.family.size());
+      for (std::size_t j = 0; j < t.family.size(); ++j)
+        m[j] = rs[i]->is_derived_from(parameter_record(t.family[j], n));
+      auto ins = cols.emplace(m, ms.size());
+      if (ins.second)
+        ms.push_back(m);
+      c[i] = ins.first->second;
+    }
+    t.columns.push_back(c);
+    t.strides.push_back(size);
+    masks.push_back(ms);
+    size *= ms.size();
+  }
+
+  // Select the target of each entry.
+  t.entries.resize(size);
+  for (std::size_t e = 0; e < size; ++e) {
+    Dispatch_table::Function_seq cands;
+    for (std::size_t j = 0; j < t.family.size(); ++j) {
+      bool ok = true;
+      for (std::size_t k = 0; k < t.parms.size(); ++k) {
+        std::size_t col = e / t.strides[k] % masks[k].size();
+        ok = ok && masks[k][col][j];
+      }
+      if (ok)
+        cands.push_back(t.family[j]);
+    }
+    t.entries[e] = most_specialized(t, cands);
+  }
+}
+
+
+} // namespace
+
+
+// Returns the target of a call to the multimethod when
+// the virtual arguments have the records with the given
+// ids. Returns nullptr if there is no unique target.
+Function_decl const*
+Dispatch_table::select(std::vector<int> const& ids) const
+{
+  std::size_t e = 0;
+  for (std::size_t k = 0; k < ids.size(); ++k)
+    e += columns[k][ids[k]] * strides[k];
+  return entries[e];
+}
+
+
+// Number the polymorphic records of the module and
+// build a dispatch table for each multimethod. The
+// map shall contain only one module.
+void
+Dispatch_map::add(Module_decl const* m)
+{
+  lingo_assert(records.empty());
+
+  for (Decl const* d : m->declarations()) {
+    if (Record_decl const* r = as<Record_decl>(d)) {
+      if (r->is_polymorphic()) {
+        ids.emplace(r, records.size());
+        records.push_back(r);
+      }
+    }
+  }
+
+  for (Decl const* d : m->declarations()) {
+    Function_decl const* f = as<Function_decl>(d);
+    if (!f || !f->virtual_parameters())
+      continue;
+    Dispatch_table* t = nullptr;
+    for (Dispatch_table& t1 : families)
+      if (same_family(f, t1.family.front()))
+        t = &t1;
+    if (!t) {
+      families.emplace_back();
+      t = &families.back();
+    }
+    t->family.push_back(f);
+    tables[f] = t;
+  }
+
+  for (Dispatch_table& t : families)
+    build_table(t, records);
+}
+
+
+// Returns the id of a polymorphic record.
+int
+Dispatch_map::id(Record_decl const* r) const
+{
+  return ids.find(r)->second;
+}
+
+
+// Returns the dispatch table for f, or nullptr if f
+// is not a multimethod.
+Dispatch_table const*
+Dispatch_map::table(Function_decl const* f) const
+{
+  auto iter = tables.find(f);
+  return iter != tables.end() ? iter->second : nullptr;
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_DISPATCH_HPP
+#define BEAKER_DISPATCH_HPP
+
+// The dispatch module builds the tables used to select
+// the target of a call to a multimethod.
+//
+// A multimethod is a family of functions with the same
+// name and virtual parameters at the same positions.
+// Their non-virtual parameters have the same types. A
+// call to any member of the family is dispatched to the
+// most specialized member whose virtual parameters
+// accept the dynamic types of the arguments.
+//
+// The polymorphic records of a module are numbered
+// densely. For each virtual parameter, records that
+// are accepted by the same members of the family are
+// assigned the same column. The dispatch table has one
+// entry for each combination of columns, so selecting
+// a target requires only indexing.
+
+#include <beaker/prelude.hpp>
+
+#include <deque>
+#include <unordered_map>
+
+
+// The dispatch table of a multimethod.
+struct Dispatch_table
+{
+  using Function_seq = std::vector<Function_decl const*>;
+  using Column_seq = std::vector<int>;
+
+  Function_decl const* select(std::vector<int> const&) const;
+
+  Function_seq             family;  // The functions in the multimethod
+  std::vector<int>         parms;   // Positions of the virtual parameters
+  std::vector<Column_seq>  columns; // The column of each record, by id
+  std::vector<std::size_t> strides; // The stride of each column
+  Function_seq             entries; // The target of each combination
+};
+
+
+// The dispatch tables of a module.
+struct Dispatch_map
+{
+  using Record_seq = std::vector<Record_decl const*>;
+
+  void add(Module_decl const*);
+
+  int                   id(Record_decl const*) const;
+  Dispatch_table const* table(Function_decl const*) const;
+
+  Record_seq                                     records;
+  std::unordered_map<Record_decl const*, int>    ids;
+  std::deque<Dispatch_table>                     families;
+  std::unordered_map<Decl const*, Dispatch_table*> tables;
+};
+
+
+#endif
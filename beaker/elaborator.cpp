@@ -8,10 +8,12 @@
 #include "beaker/stmt.hpp"
 #include "beaker/convert.hpp"
 #include "beaker/evaluator.hpp"
+#include "beaker/bounds.hpp"
 #include "beaker/error.hpp"
 
 #include <algorithm>
 #include <iostream>
+#include <unordered_set>
 
 //
 // -------------------------------------------------------------------------- //
@@ -62,7 +64,7 @@ Elaborator::declare(Decl* d)
     return overload(bind->second, d);
 
   // Create a new overload set.
-  Scope::Binding& bind = scope.bind(d->name(), {});
+  Scope::Binding& bind = stack.bind(d->name(), {});
   Overload& ovl = bind.second;
   ovl.push_back(d);
 }
@@ -79,14 +81,13 @@ Elaborator::redeclare(Decl* d)
   if (Scope::Binding* bind = scope.lookup(d->name()))
     ovl = &bind->second;
   else
-    ovl = &scope.bind(d->name(), {}).second;
+    ovl = &stack.bind(d->name(), {}).second;
   ovl->push_back(d);
 }
 
 
 // Perform lookup of an unqualified identifier. This
-// will search enclosing scopes for the innermost
-// binding of the identifier.
+// finds the innermost binding of the identifier.
 Overload*
 Elaborator::unqualified_lookup(Symbol const* sym)
 {
@@ -115,15 +116,12 @@ Elaborator::qualified_lookup(Scope* s, Symbol const* sym)
 
 
 
+// Perform lookup of a member of a record. The name may
+// be declared in a base class.
 Overload*
 Elaborator::member_lookup(Record_decl* d, Symbol const* sym)
 {
-  do {
-    if (Scope::Binding* bind = d->scope()->lookup(sym))
-      return &bind->second;
-    d = d->base_declaration();
-  } while (d);
-  return nullptr;
+  return d->lookup(sym);
 }
 
 
@@ -187,6 +185,7 @@ Elaborator::elaborate(Type const* t)
     Type const* operator()(Function_type const* t) { return elab.elaborate(t); }
     Type const* operator()(Block_type const* t) { return elab.elaborate(t); }
     Type const* operator()(Array_type const* t) { return elab.elaborate(t); }
+    Type const* operator()(Vector_type const* t) { return elab.elaborate(t); }
     Type const* operator()(Reference_type const* t) { return elab.elaborate(t); }
     Type const* operator()(Record_type const* t) { return elab.elaborate(t); }
   };
@@ -293,6 +292,25 @@ Elaborator::elaborate(Array_type const* t)
   return get_array_type(t1, n);
 }
 
+// The elements of a vector shall have scalar type, and
+// the extent shall be a positive constant.
+Type const*
+Elaborator::elaborate(Vector_type const* t)
+{
+  Type const* t1 = elaborate(t->type());
+  if (!is_scalar(t1))
+    throw Type_error({}, format("invalid vector element type '{}'", *t1));
+  Expr* e = elaborate(t->extent());
+  Expr* n = reduce(e);
+  if (!n)
+    throw Type_error({}, "non-constant vector extent");
+  Value const& v = cast<Literal_expr>(n)->value();
+  if (!v.is_integer() || v.get_integer() <= 0)
+    throw Type_error({}, "vector extent is not a positive integer");
+  return get_vector_type(t1, n);
+}
+
+
 Type const*
 Elaborator::elaborate(Block_type const* t)
 {
@@ -355,6 +373,9 @@ Elaborator::elaborate(Expr* e)
     Expr* operator()(Field_expr* e) const { return elab.elaborate(e); }
     Expr* operator()(Method_expr* e) const { return elab.elaborate(e); }
     Expr* operator()(Index_expr* e) const { return elab.elaborate(e); }
+    Expr* operator()(Vector_expr* e) const { return elab.elaborate(e); }
+    Expr* operator()(Shuffle_expr* e) const { return elab.elaborate(e); }
+    Expr* operator()(Reduce_expr* e) const { return elab.elaborate(e); }
     Expr* operator()(Value_conv* e) const { return elab.elaborate(e); }
     Expr* operator()(Block_conv* e) const { return elab.elaborate(e); }
     Expr* operator()(Base_conv* e) const { return elab.elaborate(e); }
@@ -445,6 +466,7 @@ Elaborator::elaborate(Lambda_expr* e)
 {
   // Create the new lambda expression.
   Function_decl* f_decl = new Function_decl(e->symbol(), e->type(), e->parameters(), e->body());
+  f_decl->spec_ |= generated_spec;
   elaborate_decl(f_decl);
   elaborate_def(f_decl);
 
@@ -482,17 +504,123 @@ require_converted(Elaborator& elab, Expr* e, Type const* t)
 }
 
 
+// Returns the vector type of e, or nullptr if e does
+// not have vector type.
+inline Vector_type const*
+as_vector(Expr const* e)
+{
+  return e->type() ? as<Vector_type>(e->type()->nonref()) : nullptr;
+}
+
+
+// Returns true if the value of e is a numeric literal,
+// or the negation of one, and sets v to that value.
+bool
+as_constant(Expr const* e, Value& v)
+{
+  if (Neg_expr const* n = as<Neg_expr>(e)) {
+    if (!as_constant(n->operand(), v))
+      return false;
+    if (v.is_integer())
+      v = -v.get_integer();
+    else
+      v = -v.get_float();
+    return true;
+  }
+  if (Literal_expr const* l = as<Literal_expr>(e)) {
+    v = l->value();
+    return v.is_integer() || v.is_float();
+  }
+  return false;
+}
+
+
+// Convert e to the element type t of a vector. A numeric
+// constant is converted to any numeric element type, so
+// that, for example, 0.5 can be an element of a vector of
+// float. Returns nullptr if there is no such conversion.
+Expr*
+convert_to_element(Expr* e, Type const* t)
+{
+  if (Expr* c = convert(e, t))
+    return c;
+  Value v;
+  if (is<Boolean_type>(t) || !as_constant(e, v))
+    return nullptr;
+  if (is<Float_type>(t) || is<Double_type>(t)) {
+    if (v.is_integer())
+      v = Float_value(v.get_integer());
+    return new Literal_expr(t, v);
+  }
+  if (v.is_integer())
+    return new Literal_expr(t, v);
+  return nullptr;
+}
+
+
+// Convert e to the vector type t. A scalar is converted to
+// the element type and copied into each element.
+Expr*
+convert_to_vector(Expr* e, Vector_type const* t)
+{
+  if (as_vector(e))
+    return convert(e, t);
+  Expr* c = convert_to_element(e, t->type());
+  if (!c)
+    return nullptr;
+  return new Vector_expr(t, {c});
+}
+
+
+// If either operand of e has vector type, both operands
+// are converted to that type, and it is returned. The
+// elements of the vector shall not be bool unless the
+// operation is an equality comparison. Returns nullptr
+// if neither operand is a vector.
+Vector_type const*
+check_vector_operands(Binary_expr* e, Expr* e1, Expr* e2, bool boolean = false)
+{
+  Vector_type const* t = as_vector(e1);
+  if (!t)
+    t = as_vector(e2);
+  if (!t)
+    return nullptr;
+  if (!boolean && is<Boolean_type>(t->type()))
+    throw Type_error({}, format("invalid operands of type '{}'", *t));
+
+  Expr* c1 = convert_to_vector(e1, t);
+  Expr* c2 = convert_to_vector(e2, t);
+  if (!c1)
+    throw Type_error({}, format("left operand cannot be converted to '{}'", *t));
+  if (!c2)
+    throw Type_error({}, format("right operand cannot be converted to '{}'", *t));
+  e->first = c1;
+  e->second = c2;
+  return t;
+}
+
+
 // The operands of a binary arithmetic expression are
 // converted to rvalues. The converted operands shall have
 // type int. The result of an arithmetic expression is an
 // rvalue with type int.
+//
+// If either operand is a vector, the operation applies
+// to each pair of elements, and the result is a vector.
 template<typename T>
 Expr*
 check_binary_arithmetic_expr(Elaborator& elab, T* e)
 {
   Type const* t = get_promotion_target(e->first, e->second);
-  Expr* c1 = require_converted(elab, e->first, t);
-  Expr* c2 = require_converted(elab, e->second, t);
+  Expr* e1 = elab.elaborate(e->first);
+  Expr* e2 = elab.elaborate(e->second);
+  if (Vector_type const* v = check_vector_operands(e, e1, e2)) {
+    e->type_ = v;
+    return e;
+  }
+
+  Expr* c1 = convert(e1, t);
+  Expr* c2 = convert(e2, t);
   if (!c1)
     throw Type_error({}, "left operand cannot be converted");
   if (!c2)
@@ -517,7 +645,16 @@ check_unary_arithmetic_expr(Elaborator& elab, T* e)
 {
   // Apply conversions
   Type const* t = get_promotion_target(e->first);
-  Expr* c = require_converted(elab, e->first, t);
+  Expr* e1 = elab.elaborate(e->first);
+  if (Vector_type const* v = as_vector(e1)) {
+    if (is<Boolean_type>(v->type()))
+      throw Type_error({}, format("invalid operand of type '{}'", *v));
+    e->type_ = v;
+    e->first = convert_to_value(e1);
+    return e;
+  }
+
+  Expr* c = convert(e1, t);
   if (!c)
     throw Type_error({}, "operand cannot be converted");
 
@@ -598,6 +735,12 @@ check_equality_expr(Elaborator& elab, Binary_expr* e)
   Expr* e1 = require_value(elab, e->first);
   Expr* e2 = require_value(elab, e->second);
 
+  // Vectors are compared elementwise.
+  if (Vector_type const* v = check_vector_operands(e, e1, e2, true)) {
+    e->type_ = get_vector_type(b, v->extent());
+    return e;
+  }
+
   // Check types.
   if (e1->type() != e2->type())
     throw Type_error({}, "operands have different types");
@@ -641,8 +784,15 @@ check_ordering_expr(Elaborator& elab, Binary_expr* e)
   // Apply conversions.
   Type const* t = get_promotion_target(e->first, e->second);
   Type const* b = get_boolean_type();
-  Expr* c1 = require_converted(elab, e->first, t);
-  Expr* c2 = require_converted(elab, e->second, t);
+  Expr* e1 = elab.elaborate(e->first);
+  Expr* e2 = elab.elaborate(e->second);
+  if (Vector_type const* v = check_vector_operands(e, e1, e2)) {
+    e->type_ = get_vector_type(b, v->extent());
+    return e;
+  }
+
+  Expr* c1 = convert(e1, t);
+  Expr* c2 = convert(e2, t);
   if (!c1)
     throw Type_error({}, "left operand cannot be converted");
   if (!c2)
@@ -851,22 +1001,89 @@ Elaborator::call(Function_decl* d, Expr_seq const& args)
 }
 
 
+namespace
+{
+
+// Returns true if f can be called with the given
+// arguments. That is the case when each argument can
+// be converted to its corresponding parameter type.
+bool
+is_viable(Function_decl const* f, Expr_seq const& args)
+{
+  Type_seq const& parms = f->type()->parameter_types();
+  if (parms.size() != args.size())
+    return false;
+  for (std::size_t i = 0; i < args.size(); ++i)
+    if (conversion_cost(args[i]->type(), parms[i]) == invalid_cost)
+      return false;
+  return true;
+}
+
+
+// Returns true if the viable function f1 is a better
+// candidate than the viable function f2. No argument
+// of f1 requires a more expensive conversion than the
+// corresponding argument of f2, and at least one requires
+// a cheaper conversion.
+bool
+is_better(Function_decl const* f1, Function_decl const* f2, Expr_seq const& args)
+{
+  Type_seq const& p1 = f1->type()->parameter_types();
+  Type_seq const& p2 = f2->type()->parameter_types();
+  bool better = false;
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    int c1 = conversion_cost(args[i]->type(), p1[i]);
+    int c2 = conversion_cost(args[i]->type(), p2[i]);
+    if (c1 > c2)
+      return false;
+    if (c1 < c2)
+      better = true;
+  }
+  return better;
+}
+
+
+} // namespace
+
+
+// Select the best viable function in the overload set
+// for the given arguments. The best function must be
+// better than every other viable function. Otherwise
+// the call is ambiguous.
+//
+// Candidates are ranked by the cost of their argument
+// conversions, which does not build any expressions.
+// Only the call to the selected function is built.
+//
+// The result of resolution is cached for the overload
+// set and the argument types.
 Expr*
 Elaborator::resolve(Overload_expr* ovl, Expr_seq const& args)
 {
-  // Build a set of call expressions to the
-  // declarations in the overload set.
-  Expr_seq cands;
   Overload& decls = ovl->declarations();
-  cands.reserve(decls.size());
+
+  // Look for a previous resolution.
+  Resolution_key key {&decls, decls.size(), {}};
+  key.args.reserve(args.size());
+  for (Expr* a : args)
+    key.args.push_back(a->type());
+  auto iter = resolutions.find(key);
+  if (iter != resolutions.end())
+    return call(iter->second, args);
+
+  // Find the best candidate.
+  Function_decl* best = nullptr;
   for (Decl* d : decls) {
-    if (Expr* e = call(cast<Function_decl>(d), args))
-      cands.push_back(e);
+    Function_decl* f = cast<Function_decl>(d);
+    if (!is_viable(f, args))
+      continue;
+    if (!best || is_better(f, best, args))
+      best = f;
   }
 
   // FIXME: If the call is to a method, then write
   // out the method format for the call. Same as below.
-  if (cands.empty()) {
+  if (!best) {
     Location loc = locate(ovl);
     String msg = format("{}: no matching function for '{}'", loc, *ovl->name());
     std::cerr << msg << '\n';
@@ -877,16 +1094,26 @@ Elaborator::resolve(Overload_expr* ovl, Expr_seq const& args)
     throw Type_error(locate(ovl), msg);
   }
 
-  // TODO: Select the best candidate.
-  if (cands.size() > 1) {
-    String msg = format("call to function '{}' is ambiguous", *ovl->name());
+  // Make sure that the best candidate is better than
+  // every other viable function.
+  for (Decl* d : decls) {
+    Function_decl* f = cast<Function_decl>(d);
+    if (f != best && is_viable(f, args) && !is_better(best, f, args)) {
+      Location loc = locate(ovl);
+      String msg = format("{}: call to function '{}' is ambiguous", loc, *ovl->name());
+      std::cerr << msg << '\n';
+      std::cerr << loc << ": candidates are:\n";
+      std::cerr << format("{}: {}\n", locate(best), *best);
+      std::cerr << format("{}: {}\n", locate(f), *f);
+      throw Type_error(locate(ovl), msg);
+    }
   }
 
-  return cands.front();
+  resolutions.emplace(std::move(key), best);
+  return call(best, args);
 }
 
 
-
 // Resolve a function call. The target of a function
 // may be one of the following:
 //
@@ -960,7 +1187,7 @@ Elaborator::elaborate(Call_expr* e)
 
   // Handle the case where f is an overload set.
   if (Overload_expr* ovl = as<Overload_expr>(f)) {
-    return resolve(ovl, args);
+    return assign_cache_slot(resolve(ovl, args));
   } else {
     // If it's not an overload set, it has function type.
     Function_type const* t = cast<Function_type>(f->type());
@@ -995,6 +1222,20 @@ Elaborator::elaborate(Call_expr* e)
   //              is<Function_decl>(cast<Decl_expr>(f)->declaration()));
 
   // Update the call expression before returning.
+  return assign_cache_slot(e);
+}
+
+
+// If e is a call to a method, give it the next inline
+// cache slot. The evaluator keeps the caches of the call
+// sites in a vector indexed by their slots.
+Expr*
+Elaborator::assign_cache_slot(Expr* e)
+{
+  if (Call_expr* c = e ? as<Call_expr>(e) : nullptr)
+    if (Decl_expr* d = as<Decl_expr>(c->target()))
+      if (is<Method_decl>(d->declaration()))
+        c->slot = slots++;
   return e;
 }
 
@@ -1009,9 +1250,7 @@ void
 get_path(Record_decl* r, Field_decl* f, Field_path& p)
 {
   // Search the record for the given fields.
-  Decl_seq const& fs = r->fields();
-  auto iter = std::find(fs.begin(), fs.end(), f);
-  if (iter != fs.end()) {
+  if (f->context() == r) {
     // Compute the offset adjustment for this member.
     // A virtual table reference counts as a subobject, and
     // so does a base class sub-object.
@@ -1020,7 +1259,7 @@ get_path(Record_decl* r, Field_decl* f, Field_path& p)
       ++a;
     if (r->base())
       ++a;
-    p.push_back(std::distance(fs.begin(), iter) + a);
+    p.push_back(f->index() + a);
     return;
   }
 
@@ -1173,9 +1412,16 @@ Elaborator::elaborate(Index_expr* e)
   // We don't (yet?) have array literals, so I generally
   // expect that this *must* be a reference to an array.
   //
+  // The elements of a vector can also be indexed.
+  //
   // TODO: Allow block type.
-  Array_type const* t = as<Array_type>(e1->type()->nonref());
-  if (!t) {
+  Type const* t0 = e1->type()->nonref();
+  Type const* t;
+  if (Array_type const* a = as<Array_type>(t0))
+    t = a->type();
+  else if (Vector_type const* v = as<Vector_type>(t0))
+    t = v->type();
+  else {
     std::stringstream ss;
     ss << "object does not have array type";
     throw Type_error({}, ss.str());
@@ -1185,7 +1431,7 @@ Elaborator::elaborate(Index_expr* e)
   Expr* e2 = require_converted(*this, e->second, get_integer_type());
 
   // The result type shall be ref T.
-  e->type_ = get_reference_type(t->type());
+  e->type_ = get_reference_type(t);
   e->first = e1;
   e->second = e2;
 
@@ -1193,6 +1439,78 @@ Elaborator::elaborate(Index_expr* e)
 }
 
 
+// The type of a vector construction shall be a vector
+// type. There is either one initializer, which is copied
+// into each element, or one initializer per element.
+Expr*
+Elaborator::elaborate(Vector_expr* e)
+{
+  Vector_type const* t = as<Vector_type>(elaborate(e->type_));
+  if (!t)
+    throw Type_error({}, "invalid vector type");
+  Expr_seq& es = e->first;
+  if (es.size() != 1 && int(es.size()) != t->size())
+    throw Type_error({}, format("wrong number of initializers for '{}'", *t));
+  for (Expr*& x : es) {
+    Expr* c = convert_to_element(elaborate(x), t->type());
+    if (!c)
+      throw Type_error({}, format("initializer cannot be converted to '{}'", *t->type()));
+    x = c;
+  }
+  e->type_ = t;
+  return e;
+}
+
+
+// The operand of a shuffle shall be a vector, and each
+// index shall be a constant within its extent. The result
+// is a vector with one element per index.
+Expr*
+Elaborator::elaborate(Shuffle_expr* e)
+{
+  Expr* e1 = require_value(*this, e->first);
+  Vector_type const* t = as<Vector_type>(e1->type());
+  if (!t)
+    throw Type_error({}, "shuffle of a non-vector");
+  if (e->second.empty())
+    throw Type_error({}, "shuffle requires at least one index");
+  for (Expr*& x : e->second) {
+    Expr* n = reduce(elaborate(x));
+    if (!n || !cast<Literal_expr>(n)->value().is_integer())
+      throw Type_error({}, "non-constant shuffle index");
+    Integer_value i = cast<Literal_expr>(n)->value().get_integer();
+    if (i < 0 || i >= t->size())
+      throw Type_error({}, format("shuffle index {} out of range", i));
+    x = n;
+  }
+  e->type_ = get_vector_type(t->type(), int(e->second.size()));
+  e->first = e1;
+  return e;
+}
+
+
+// The operand of a reduction shall be a vector. The
+// operator of a logical reduction shall be && or ||, and
+// its elements shall be bool. Other reductions shall not
+// have bool elements. The result has the element type.
+Expr*
+Elaborator::elaborate(Reduce_expr* e)
+{
+  Expr* e1 = require_value(*this, e->first);
+  Vector_type const* t = as<Vector_type>(e1->type());
+  if (!t)
+    throw Type_error({}, "reduction of a non-vector");
+  bool logical = e->reduction() == all_reduction || e->reduction() == any_reduction;
+  if (logical && !is<Boolean_type>(t->type()))
+    throw Type_error({}, "logical reduction of a non-boolean vector");
+  if (!logical && is<Boolean_type>(t->type()))
+    throw Type_error({}, "arithmetic reduction of a boolean vector");
+  e->type_ = t->type();
+  e->first = e1;
+  return e;
+}
+
+
 // NOTE: Conversions are created after their source
 // expressions  have been elaborated. No action is
 // required.
@@ -1356,8 +1674,9 @@ Elaborator::elaborate(Variable_decl* d)
     d->type_ = d->type_->ref();
     cast<Init>(d->init_)->type_ = d->type_;
   }
-  // Declare the variable.
+  // Declare the variable and allocate its slot.
   declare(d);
+  d->slot_ = stack.function()->frame_++;
 
   // Elaborate the initializer. Note that the initializers
   // type must be the same as that of the declaration.
@@ -1396,6 +1715,7 @@ Elaborator::elaborate(Parameter_decl* d)
   declare(d);
 
   Function_decl* fn = stack.function();
+  d->slot_ = fn->frame_++;
 
   // Check for virtual parameters. A parameter can only be
   // declared virtual if t has polymorphic type (or is a reference
@@ -1412,10 +1732,8 @@ Elaborator::elaborate(Parameter_decl* d)
     // Mark the function as being virtual.
     fn->spec_ |= virtual_spec;
 
-    // Save virtual parameter.
-    //
-    // TODO: What are we actually going to do with
-    // this thing?
+    // Save virtual parameter. These determine the
+    // dispatch table of the multimethod.
     if (!fn->vparms_)
       fn->vparms_ = new Decl_seq {d};
     else
@@ -1455,6 +1773,7 @@ Elaborator::elaborate(Method_decl* d)
 Decl*
 Elaborator::elaborate(Module_decl* m)
 {
+  lingo_assert(!m->is_frozen());
   Scope_sentinel scope(*this, m);
   for (Decl*& d : m->decls_)
     d = elaborate_decl(d);
@@ -1464,6 +1783,9 @@ Elaborator::elaborate(Module_decl* m)
   for(auto && a : lambda_decls_)
     m->decls_.insert(m->decls_.begin(), a.second);
 
+  // Determine which array indexes need bounds checks.
+  elide_bounds_checks(m);
+
   return m;
 
 }
@@ -1507,6 +1829,7 @@ Elaborator::elaborate_decl(Variable_decl* d)
   }
   d->type_ = elaborate_type(d->type_);
   declare(d);
+  d->slot_ = stack.module()->frame_++;
   return d;
 }
 
@@ -1822,9 +2145,23 @@ Elaborator::elaborate_def(Record_decl* d)
   }
   Defining_sentinel def(*this, d);
 
-  // Elaborate base class.
-  if (d->base_)
+  // Elaborate base class. The base must be defined
+  // before the derived class. A base that is still being
+  // defined can be used once its member tables have been
+  // computed, since its member definitions may refer to
+  // this class. Before that, it is a cyclic definition.
+  //
+  // The virtual tables and final overriders of an
+  // imported record are computed by its own module, so
+  // it cannot be derived from.
+  if (d->base_) {
     d->base_ = elaborate(d->base_);
+    Record_decl* b = d->base_declaration();
+    if (b->is_imported() && !d->is_imported())
+      throw Type_error(locate(d), format("cannot derive from imported record '{}'", *b->name()));
+    if (!is_defining(b) || !b->flat_)
+      elaborate_def(b);
+  }
 
   // If the base class is polymorphic, then so is the
   // derived class. Propagate the virtual table to this
@@ -1843,6 +2180,11 @@ Elaborator::elaborate_def(Record_decl* d)
       d->vtbl_ = new Decl_seq(*base->vtable());
   }
 
+  // Compute the display.
+  if (base)
+    d->display_ = base->display_;
+  d->display_.push_back(d);
+
   // Elaborate member declarations, fields first.
   //
   // TODO: What are the lookup rules for default
@@ -1867,6 +2209,22 @@ Elaborator::elaborate_def(Record_decl* d)
   for (Decl*& m : d->members_)
     m = elaborate_decl(m);
 
+  // With all members declared, compute the layout and
+  // member table. These extend those of the base class.
+  if (base) {
+    d->layout_ = base->layout_;
+    d->lookup_ = base->lookup_;
+  }
+  for (std::size_t i = 0; i < d->fields_.size(); ++i) {
+    Field_decl* f = cast<Field_decl>(d->fields_[i]);
+    f->index_ = i;
+    f->offset_ = d->layout_.size();
+    d->layout_.push_back(f);
+  }
+  for (Scope::Binding& b : *d->scope())
+    d->lookup_[b.first] = &b.second;
+  d->flat_ = true;
+
   // Elaborate member definitions. See comments
   // above about handling member defintions.
   for (Decl*& m : d->members_)
@@ -1942,6 +2300,9 @@ Elaborator::elaborate(Stmt* s)
     Stmt* operator()(If_then_stmt* d) const { return elab.elaborate(d); }
     Stmt* operator()(If_else_stmt* d) const { return elab.elaborate(d); }
     Stmt* operator()(While_stmt* d) const { return elab.elaborate(d); }
+    Stmt* operator()(Switch_stmt* d) const { return elab.elaborate(d); }
+    Stmt* operator()(For_stmt* d) const { return elab.elaborate(d); }
+    Stmt* operator()(Parallel_for_stmt* d) const { return elab.elaborate(d); }
     Stmt* operator()(Break_stmt* d) const { return elab.elaborate(d); }
     Stmt* operator()(Continue_stmt* d) const { return elab.elaborate(d); }
     Stmt* operator()(Expression_stmt* d) const { return elab.elaborate(d); }
@@ -2057,6 +2418,42 @@ Elaborator::elaborate(If_else_stmt* s)
 }
 
 
+// The condition of a switch statement shall have integer
+// or character type. Each case label shall be a constant
+// expression that can be converted to the type of the
+// condition, and no two labels shall have the same value.
+// The labels are replaced by their values.
+Stmt*
+Elaborator::elaborate(Switch_stmt* s)
+{
+  Expr* c = require_value(*this, s->first);
+  Type const* t = c->type();
+  if (!is<Integer_type>(t) && !is<Character_type>(t))
+    throw Type_error(locate(s->first), "switch condition does not have integer or character type");
+
+  std::unordered_set<Integer_value> seen;
+  for (Switch_case& k : s->second) {
+    for (Expr*& e : k.first) {
+      Expr* l = require_converted(*this, e, t);
+      if (!l)
+        throw Type_error(locate(e), "case label does not have the type of the switch condition");
+      Expr* n = reduce(l);
+      if (!n)
+        throw Type_error(locate(e), "case label is not a constant");
+      if (!seen.insert(cast<Literal_expr>(n)->value().get_integer()).second)
+        throw Type_error(locate(e), "duplicate case label");
+      e = n;
+    }
+    k.second = elaborate(k.body());
+  }
+  if (s->third)
+    s->third = elaborate(s->default_case());
+
+  s->first = c;
+  return s;
+}
+
+
 Stmt*
 Elaborator::elaborate(While_stmt* s)
 {
@@ -2071,6 +2468,242 @@ Elaborator::elaborate(While_stmt* s)
 }
 
 
+// The bounds of a for loop shall have type int. The loop
+// variable is declared in a new scope, which encloses the
+// body. When both bounds are literals, the trip count of
+// the loop is known.
+Stmt*
+Elaborator::elaborate(For_stmt* s)
+{
+  Expr* lo = require_converted(*this, s->second, get_integer_type());
+  if (!lo)
+    throw Type_error(locate(s->variable()), "loop bound does not have type 'int'");
+  Expr* hi = require_converted(*this, s->third, get_integer_type());
+  if (!hi)
+    throw Type_error(locate(s->variable()), "loop bound does not have type 'int'");
+
+  Scope_sentinel scope = *this;
+  s->first = cast<Variable_decl>(elaborate(s->first));
+  s->second = lo;
+  s->third = hi;
+  s->fourth = elaborate(s->body());
+
+  Literal_expr const* l1 = as<Literal_expr>(lo);
+  Literal_expr const* l2 = as<Literal_expr>(hi);
+  if (l1 && l2) {
+    Integer_value n = l2->value().get_integer() - l1->value().get_integer();
+    s->trips = std::max<Integer_value>(n, 0);
+  }
+  return s;
+}
+
+
+namespace
+{
+
+// Rejects the obvious races in the body of a parallel
+// loop. The body shall not assign to objects declared
+// outside of the body, except for the elements of arrays
+// indexed by the loop variable, and it shall not return
+// or break out of the loop. Races through references,
+// and through the side effects of called functions, are
+// not detected.
+//
+// An array may be indexed by the loop variable plus or
+// minus a literal, but every element assigned in the
+// body of the same array must be at the same offset from
+// the loop variable. Otherwise, in a[i] = x; a[i + 1] = y;
+// iterations i and i + 1 both assign a[i + 1].
+struct Race_checker
+{
+  Race_checker(Elaborator& e, Parallel_for_stmt const* s)
+    : elab(e), loop(s)
+  { }
+
+  void stmt(Stmt const*);
+  void object(Expr const*);
+  void element(Expr const*, Integer_value);
+  bool indexed(Expr const*, Integer_value&) const;
+
+  [[noreturn]] void error(String const&);
+
+  Elaborator&                     elab;
+  Parallel_for_stmt const*        loop;
+  std::unordered_set<Decl const*> locals; // Declared in the body
+  int                             depth = 0; // Of nested loops and switches
+
+  // The offset from the loop variable of the elements
+  // assigned in each array, by the declaration of the
+  // object containing the array.
+  std::unordered_map<Decl const*, Integer_value> offsets;
+};
+
+
+void
+Race_checker::error(String const& msg)
+{
+  throw Type_error(elab.locate(loop->variable()), msg);
+}
+
+
+void
+Race_checker::stmt(Stmt const* s)
+{
+  if (Block_stmt const* b = as<Block_stmt>(s)) {
+    for (Stmt const* s1 : b->statements())
+      stmt(s1);
+  } else if (Assign_stmt const* a = as<Assign_stmt>(s)) {
+    object(a->object());
+  } else if (is<Return_stmt>(s)) {
+    error("return from a parallel loop");
+  } else if (If_then_stmt const* i = as<If_then_stmt>(s)) {
+    stmt(i->body());
+  } else if (If_else_stmt const* i = as<If_else_stmt>(s)) {
+    stmt(i->true_branch());
+    stmt(i->false_branch());
+  } else if (Switch_stmt const* w = as<Switch_stmt>(s)) {
+    ++depth;
+    for (Switch_case const& k : w->cases())
+      stmt(k.body());
+    if (w->default_case())
+      stmt(w->default_case());
+    --depth;
+  } else if (While_stmt const* w = as<While_stmt>(s)) {
+    ++depth;
+    stmt(w->body());
+    --depth;
+  } else if (For_stmt const* f = as<For_stmt>(s)) {
+    locals.insert(f->variable());
+    ++depth;
+    stmt(f->body());
+    --depth;
+  } else if (is<Break_stmt>(s)) {
+    if (!depth)
+      error("break out of a parallel loop");
+  } else if (Declaration_stmt const* d = as<Declaration_stmt>(s)) {
+    locals.insert(d->declaration());
+  }
+
+  // A nested parallel loop has already been checked,
+  // and it cannot assign to anything declared outside
+  // of its own body.
+}
+
+
+// Check the object of an assignment.
+void
+Race_checker::object(Expr const* e)
+{
+  if (Decl_expr const* d = as<Decl_expr>(e)) {
+    if (!locals.count(d->declaration()))
+      error(format("assignment to '{}' in a parallel loop", *d->declaration()->name()));
+  } else if (Field_expr const* f = as<Field_expr>(e)) {
+    object(f->container());
+  } else if (Index_expr const* i = as<Index_expr>(e)) {
+    Integer_value n;
+    if (indexed(i->index(), n))
+      element(i->array(), n);
+    else
+      object(i->array());
+  } else if (Conv const* c = as<Conv>(e)) {
+    object(c->source());
+  }
+}
+
+
+// Check the assignment of an element of the array a at
+// the offset n from the loop variable. Arrays are known
+// by the object that contains them, so the elements of
+// different arrays in one object must also be assigned
+// at the same offset.
+void
+Race_checker::element(Expr const* a, Integer_value n)
+{
+  Expr const* e = a;
+  while (!is<Decl_expr>(e)) {
+    if (Field_expr const* f = as<Field_expr>(e))
+      e = f->container();
+    else if (Index_expr const* i = as<Index_expr>(e))
+      e = i->array();
+    else if (Conv const* c = as<Conv>(e))
+      e = c->source();
+    else
+      return;
+  }
+  Decl const* d = cast<Decl_expr>(e)->declaration();
+  auto r = offsets.emplace(d, n);
+  if (!r.second && r.first->second != n)
+    error(format("elements of '{}' assigned at different offsets in a parallel loop", *d->name()));
+}
+
+
+// Returns true if e is the loop variable, or the loop
+// variable plus or minus a literal, and sets n to that
+// literal. Different iterations index different elements
+// with such an expression.
+bool
+Race_checker::indexed(Expr const* e, Integer_value& n) const
+{
+  if (Value_conv const* c = as<Value_conv>(e))
+    e = c->source();
+  if (Decl_expr const* d = as<Decl_expr>(e)) {
+    n = 0;
+    return d->declaration() == loop->variable();
+  }
+  if (Add_expr const* a = as<Add_expr>(e)) {
+    if (Literal_expr const* l = as<Literal_expr>(a->right())) {
+      if (!indexed(a->left(), n))
+        return false;
+      n += l->value().get_integer();
+      return true;
+    }
+    if (Literal_expr const* l = as<Literal_expr>(a->left())) {
+      if (!indexed(a->right(), n))
+        return false;
+      n += l->value().get_integer();
+      return true;
+    }
+    return false;
+  }
+  if (Sub_expr const* a = as<Sub_expr>(e)) {
+    if (Literal_expr const* l = as<Literal_expr>(a->right())) {
+      if (!indexed(a->left(), n))
+        return false;
+      n -= l->value().get_integer();
+      return true;
+    }
+  }
+  return false;
+}
+
+
+} // namespace
+
+
+// The bounds of a parallel loop shall have type int. The
+// loop variable is declared in a new scope, which encloses
+// the body.
+Stmt*
+Elaborator::elaborate(Parallel_for_stmt* s)
+{
+  Expr* lo = require_converted(*this, s->second, get_integer_type());
+  if (!lo)
+    throw Type_error(locate(s->variable()), "loop bound does not have type 'int'");
+  Expr* hi = require_converted(*this, s->third, get_integer_type());
+  if (!hi)
+    throw Type_error(locate(s->variable()), "loop bound does not have type 'int'");
+
+  Scope_sentinel scope = *this;
+  s->first = cast<Variable_decl>(elaborate(s->first));
+  s->second = lo;
+  s->third = hi;
+  s->fourth = elaborate(s->body());
+
+  Race_checker(*this, s).stmt(s->body());
+  return s;
+}
+
+
 Stmt*
 Elaborator::elaborate(Break_stmt* s)
 {
@@ -53,6 +53,7 @@ public:
   Type const* elaborate(Double_type const*);
   Type const* elaborate(Function_type const*);
   Type const* elaborate(Array_type const*);
+  Type const* elaborate(Vector_type const*);
   Type const* elaborate(Block_type const*);
   Type const* elaborate(Reference_type const*);
   Type const* elaborate(Record_type const*);
@@ -88,6 +89,9 @@ public:
   Expr* elaborate(Field_expr* e);
   Expr* elaborate(Method_expr* e);
   Expr* elaborate(Index_expr* e);
+  Expr* elaborate(Vector_expr* e);
+  Expr* elaborate(Shuffle_expr* e);
+  Expr* elaborate(Reduce_expr* e);
   Expr* elaborate(Value_conv* e);
   Expr* elaborate(Block_conv* e);
   Expr* elaborate(Base_conv* e);
@@ -133,6 +137,9 @@ public:
   Stmt* elaborate(If_then_stmt*);
   Stmt* elaborate(If_else_stmt*);
   Stmt* elaborate(While_stmt*);
+  Stmt* elaborate(Switch_stmt*);
+  Stmt* elaborate(For_stmt*);
+  Stmt* elaborate(Parallel_for_stmt*);
   Stmt* elaborate(Break_stmt*);
   Stmt* elaborate(Continue_stmt*);
   Stmt* elaborate(Expression_stmt*);
@@ -144,6 +151,7 @@ public:
 
   Expr* call(Function_decl*, Expr_seq const&);
   Expr* resolve(Overload_expr*, Expr_seq const&);
+  Expr* assign_cache_slot(Expr*);
 
   Overload* unqualified_lookup(Symbol const*);
   Overload* qualified_lookup(Scope*, Symbol const*);
@@ -165,6 +173,12 @@ private:
   Scope_stack   stack;
   Decl_set      defined;
   Decl_stack    defining;
+
+  // Memoized overload resolutions.
+  Resolution_cache resolutions;
+
+  // The number of inline cache slots assigned.
+  int slots = 0;
 };
 
 
@@ -0,0 +1,169 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/engine.hpp"
+#include "beaker/type.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/token.hpp"
+#include "beaker/lexer.hpp"
+#include "beaker/parser.hpp"
+#include "beaker/elaborator.hpp"
+#include "beaker/image.hpp"
+
+#include <stdexcept>
+
+
+namespace
+{
+
+// Returns true if the value v can be bound to a parameter
+// of type t. Only scalar parameters are checked; other
+// arguments must be values of the parameter type.
+inline bool
+accepts(Type const* t, Value const& v)
+{
+  if (is_integral(t))
+    return v.is_integer();
+  if (is<Float_type>(t) || is<Double_type>(t))
+    return v.is_float();
+  return true;
+}
+
+
+} // namespace
+
+
+// -------------------------------------------------------------------------- //
+// Function handles
+
+// Call the function with the n values in args. Throws an
+// exception if the number of arguments is wrong or if a
+// scalar argument has the wrong kind of value.
+Value
+Function_handle::invoke(Value const* args, std::size_t n) const
+{
+  Decl_seq const& parms = fn->parameters();
+  if (n != parms.size())
+    throw std::runtime_error(format("wrong number of arguments to '{}'", *fn->name()));
+  for (std::size_t i = 0; i < n; ++i) {
+    if (!accepts(parms[i]->type(), args[i]))
+      throw std::runtime_error(format("argument {} of '{}' has the wrong type", i + 1, *fn->name()));
+  }
+  return ev->call(fn, args, n);
+}
+
+
+// -------------------------------------------------------------------------- //
+// Engines
+
+Engine::Engine()
+{
+  init_symbols(syms);
+}
+
+
+// Create an engine that shares the module loaded by the
+// engine e. The globals of the module are evaluated again
+// for this engine, and are not shared with e. Throws an
+// exception if e has no module.
+Engine::Engine(Engine const* e)
+  : owner(e), mod(e->mod), main_(e->main_)
+{
+  if (!mod)
+    throw std::runtime_error("engine has no module");
+  lingo_assert(mod->is_frozen());
+  ev.eval(mod);
+}
+
+
+void
+Engine::check_unloaded() const
+{
+  if (mod)
+    throw std::runtime_error("engine already has a module");
+}
+
+
+// Translate the source file at path, freeze the module,
+// and evaluate its global variables. Lexical and syntax
+// errors are diagnosed as they are found, after which an
+// exception is thrown. Elaboration and evaluation errors
+// are thrown as translation errors.
+void
+Engine::load(String const& path)
+{
+  check_unloaded();
+
+  File src = path.c_str();
+  Input_buffer in = src;
+  Token_stream ts;
+  Lexer lex(syms, in);
+  if (!lex.lex(ts))
+    throw std::runtime_error(format("cannot load '{}'", path));
+
+  Module_decl* m = new Module_decl();
+  Location_map locs;
+  Parser parse(syms, ts, locs);
+  if (!parse.module(m))
+    throw std::runtime_error(format("cannot load '{}'", path));
+
+  Elaborator elab(locs, syms);
+  elab.elaborate(m);
+
+  freeze(m);
+  ev.eval(m);
+  mod = m;
+  main_ = elab.main;
+}
+
+
+// Load the program saved in the image at path. Its
+// global variables are restored, not evaluated.
+void
+Engine::load_image(String const& path)
+{
+  check_unloaded();
+
+  Image img = ::load_image(path, syms);
+  freeze(img.module);
+  ev.init(img.module, std::move(img.globals));
+  mod = img.module;
+  main_ = img.main;
+}
+
+
+// Save an image of the loaded module at path. The image
+// holds the current values of the global variables.
+void
+Engine::save_image(String const& path) const
+{
+  if (!mod)
+    throw std::runtime_error("engine has no module");
+  ::save_image(path, symbols(), mod, main_, ev.global_store());
+}
+
+
+// Returns a handle to the function with the given name.
+// Throws an exception if there is no such function or
+// if the function is overloaded.
+Function_handle
+Engine::function(String const& name)
+{
+  if (!mod)
+    throw std::runtime_error("engine has no module");
+
+  Function_decl const* fn = nullptr;
+  for (Decl const* d : mod->declarations()) {
+    Function_decl const* f = as<Function_decl>(d);
+    if (!f || f->name()->spelling() != name)
+      continue;
+    if (fn)
+      throw std::runtime_error(format("function '{}' is overloaded", name));
+    fn = f;
+  }
+  if (!fn)
+    throw std::runtime_error(format("no function named '{}'", name));
+  if (fn->is_imported())
+    throw std::runtime_error(format("function '{}' is not defined in this module", name));
+  return Function_handle(ev, fn);
+}
@@ -0,0 +1,164 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_ENGINE_HPP
+#define BEAKER_ENGINE_HPP
+
+// The engine module is the interface for embedding the
+// interpreter in another program. An engine loads a
+// module once, from source or from an image, and
+// evaluates its global variables. Functions of the
+// module are then called through function handles.
+//
+// A call through a handle evaluates only the body of
+// the function: the module is not elaborated again and
+// its globals are not re-evaluated. Global variables
+// keep their values from one call to the next.
+//
+// A loaded module is frozen, so it can be shared. An
+// engine created from another engine evaluates the
+// globals of that engine's module in its own store. An
+// engine is not thread safe, but engines that share a
+// module can be used concurrently, one per thread.
+
+#include <beaker/prelude.hpp>
+#include <beaker/symbol.hpp>
+#include <beaker/evaluator.hpp>
+
+
+// -------------------------------------------------------------------------- //
+// Marshalling
+
+// Returns the Beaker value of a C++ value. Integer and
+// boolean values are integers. Floating point values
+// are floats.
+inline Value to_value(int n)           { return Integer_value(n); }
+inline Value to_value(Integer_value n) { return n; }
+inline Value to_value(bool b)          { return Integer_value(b); }
+inline Value to_value(double d)        { return Float_value(d); }
+inline Value to_value(Value const& v)  { return v; }
+
+
+// Returns the C++ value of the Beaker value v. A reference
+// is seen through.
+template<typename T>
+T from_value(Value const&);
+
+
+template<>
+inline Value
+from_value<Value>(Value const& v)
+{
+  return v;
+}
+
+
+template<>
+inline Integer_value
+from_value<Integer_value>(Value const& v)
+{
+  return v.is_reference() ? v.get_reference()->get_integer() : v.get_integer();
+}
+
+
+template<>
+inline int
+from_value<int>(Value const& v)
+{
+  return from_value<Integer_value>(v);
+}
+
+
+template<>
+inline bool
+from_value<bool>(Value const& v)
+{
+  return from_value<Integer_value>(v);
+}
+
+
+template<>
+inline double
+from_value<double>(Value const& v)
+{
+  return v.is_reference() ? v.get_reference()->get_float() : v.get_float();
+}
+
+
+template<>
+inline void
+from_value<void>(Value const&)
+{ }
+
+
+// -------------------------------------------------------------------------- //
+// Function handles
+
+// A handle to a function of the module loaded by an
+// engine. A handle is valid as long as its engine.
+class Function_handle
+{
+public:
+  Function_handle(Evaluator& e, Function_decl const* f)
+    : ev(&e), fn(f)
+  { }
+
+  Function_decl const* declaration() const { return fn; }
+
+  template<typename R = Value, typename... Args>
+  R call(Args const&...) const;
+
+  Value invoke(Value const*, std::size_t) const;
+
+private:
+  Evaluator*           ev;
+  Function_decl const* fn;
+};
+
+
+// Call the function with the given arguments, returning
+// the result as a value of type R. Each argument is
+// converted to a Beaker value by to_value.
+template<typename R, typename... Args>
+inline R
+Function_handle::call(Args const&... args) const
+{
+  Value vs[sizeof...(Args) + 1] = { to_value(args)... };
+  return from_value<R>(invoke(vs, sizeof...(Args)));
+}
+
+
+// -------------------------------------------------------------------------- //
+// Engines
+
+class Engine
+{
+public:
+  Engine();
+  explicit Engine(Engine const*);
+  Engine(Engine const&) = delete;
+  Engine& operator=(Engine const&) = delete;
+
+  void load(String const&);
+  void load_image(String const&);
+  void save_image(String const&) const;
+
+  Function_handle function(String const&);
+  Function_decl*  main() const { return main_; }
+
+  Symbol_table const& symbols() const     { return owner ? owner->syms : syms; }
+  Module_decl const*  module() const      { return mod; }
+  Inline_cache_stats  cache_stats() const { return ev.cache_stats(); }
+
+private:
+  void check_unloaded() const;
+
+  Engine const*  owner = nullptr;
+  Symbol_table   syms;
+  Module_decl*   mod   = nullptr;
+  Function_decl* main_ = nullptr;
+  Evaluator      ev;
+};
+
+
+#endif
@@ -7,7 +7,10 @@
 #include "beaker/decl.hpp"
 #include "beaker/stmt.hpp"
 #include "beaker/error.hpp"
+#include "beaker/pool.hpp"
+#include "beaker/simd.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 
@@ -43,6 +46,9 @@ Evaluator::eval(Expr const* e)
     Value operator()(Field_expr const* e) { return ev.eval(e); }
     Value operator()(Method_expr const* e) { return ev.eval(e); }
     Value operator()(Index_expr const* e) { return ev.eval(e); }
+    Value operator()(Vector_expr const* e) { return ev.eval(e); }
+    Value operator()(Shuffle_expr const* e) { return ev.eval(e); }
+    Value operator()(Reduce_expr const* e) { return ev.eval(e); }
     Value operator()(Value_conv const* e) { return ev.eval(e); }
     Value operator()(Block_conv const* e) { return ev.eval(e); }
     Value operator()(Base_conv const* e) { return ev.eval(e); }
@@ -59,6 +65,73 @@ Evaluator::eval(Expr const* e)
 namespace
 {
 
+Value get_value(Type const*);
+
+
+// Returns the representation of an element of scalar
+// type t in a buffer.
+Element_kind
+element_kind(Type const* t)
+{
+  struct Fn
+  {
+    Element_kind operator()(Type const* t) { lingo_unreachable(); }
+    Element_kind operator()(Boolean_type const*) { return uint8_element; }
+    Element_kind operator()(Character_type const*) { return int8_element; }
+    Element_kind operator()(Float_type const*) { return float_element; }
+    Element_kind operator()(Double_type const*) { return double_element; }
+
+    Element_kind operator()(Integer_type const* t)
+    {
+      bool s = t->is_signed();
+      switch (t->precision()) {
+        case 8: return s ? int8_element : uint8_element;
+        case 16: return s ? int16_element : uint16_element;
+        case 32: return s ? int32_element : uint32_element;
+        default: return s ? int64_element : uint64_element;
+      }
+    }
+  };
+  return apply(t, Fn{});
+}
+
+
+// Returns true if e produces a new vector, whose storage
+// can be released once its value has been used.
+bool
+is_temporary(Expr const* e)
+{
+  if (!is<Vector_type>(e->type()))
+    return false;
+  return is<Binary_expr>(e)
+      || is<Neg_expr>(e)
+      || is<Vector_expr>(e)
+      || is<Shuffle_expr>(e);
+}
+
+
+// Release the value v of e if it is a temporary vector.
+inline void
+release(Expr const* e, Value const& v)
+{
+  if (is_temporary(e))
+    vector_release(v.get_buffer());
+}
+
+
+// Apply op to the elements of the vector operands of e.
+Value
+eval_vector(Evaluator& ev, Vector_op op, Binary_expr const* e)
+{
+  Value v1 = ev.eval(e->left());
+  Value v2 = ev.eval(e->right());
+  Buffer_value r = vector_binary(op, v1.get_buffer(), v2.get_buffer());
+  release(e->left(), v1);
+  release(e->right(), v2);
+  return r;
+}
+
+
 // Dispatch for eval_+init
 struct Eval_init_fn
 {
@@ -98,10 +171,44 @@ Evaluator::eval(Id_expr const* e)
 }
 
 
+// Returns the storage of a variable or parameter. Global
+// variables are stored in the module's frame, and all
+// others in the current frame.
+Value&
+Evaluator::storage(Decl const* d)
+{
+  int n;
+  Frame* f;
+  if (Variable_decl const* v = as<Variable_decl>(d)) {
+    n = v->slot();
+    f = is_global_variable(v) ? &global_frame() : nullptr;
+  } else {
+    n = cast<Parameter_decl>(d)->slot();
+    f = nullptr;
+  }
+  if (!f) {
+    if (stack.empty())
+      throw Evaluation_error({}, "reference to a variable outside of a function");
+    f = &stack.back();
+  }
+  return (*f)[n];
+}
+
+
 Value
 Evaluator::eval(Decl_expr const* e)
 {
-  return &stack.lookup(e->name())->second;
+  // Functions and methods denote themselves. Methods
+  // are never stored in a frame.
+  if (Function_decl const* f = as<Function_decl>(e->declaration()))
+    return f;
+
+  // A variable of reference type already holds the
+  // reference to its object.
+  Value& v = storage(e->declaration());
+  if (v.is_reference() || v.is_element())
+    return v;
+  return &v;
 }
 
 
@@ -109,6 +216,8 @@ Evaluator::eval(Decl_expr const* e)
 Value
 Evaluator::eval(Add_expr const* e)
 {
+  if (is<Vector_type>(e->type()))
+    return eval_vector(*this, vector_add, e);
   Value v1 = eval(e->left());
   Value v2 = eval(e->right());
   return v1.get_integer() + v2.get_integer();
@@ -119,6 +228,8 @@ Evaluator::eval(Add_expr const* e)
 Value
 Evaluator::eval(Sub_expr const* e)
 {
+  if (is<Vector_type>(e->type()))
+    return eval_vector(*this, vector_sub, e);
   Value v1 = eval(e->left());
   Value v2 = eval(e->right());
   return v1.get_integer() - v2.get_integer();
@@ -129,6 +240,8 @@ Evaluator::eval(Sub_expr const* e)
 Value
 Evaluator::eval(Mul_expr const* e)
 {
+  if (is<Vector_type>(e->type()))
+    return eval_vector(*this, vector_mul, e);
   Value v1 = eval(e->left());
   Value v2 = eval(e->right());
   return v1.get_integer() * v2.get_integer();
@@ -138,6 +251,8 @@ Evaluator::eval(Mul_expr const* e)
 Value
 Evaluator::eval(Div_expr const* e)
 {
+  if (is<Vector_type>(e->type()))
+    return eval_vector(*this, vector_div, e);
   Value v1 = eval(e->left());
   Value v2 = eval(e->right());
   if (v2.get_integer() == 0)
@@ -149,11 +264,13 @@ Evaluator::eval(Div_expr const* e)
 Value
 Evaluator::eval(Rem_expr const* e)
 {
+  if (is<Vector_type>(e->type()))
+    return eval_vector(*this, vector_rem, e);
   Value v1 = eval(e->left());
   Value v2 = eval(e->right());
   if (v2.get_integer() == 0)
     throw std::runtime_error("division by 0");
-  return v1.get_integer() / v2.get_integer();
+  return v1.get_integer() % v2.get_integer();
 }
 
 
@@ -161,6 +278,11 @@ Value
 Evaluator::eval(Neg_expr const* e)
 {
   Value v = eval(e->operand());
+  if (is<Vector_type>(e->type())) {
+    Buffer_value r = vector_negate(v.get_buffer());
+    release(e->operand(), v);
+    return r;
+  }
   return -v.get_integer();
 }
 
@@ -195,6 +317,8 @@ compare_equal(Value const& v1, Value const& v2, F fn)
 Value
 Evaluator::eval(Eq_expr const* e)
 {
+  if (is<Vector_type>(e->type()))
+    return eval_vector(*this, vector_eq, e);
   Value v1 = eval(e->left());
   Value v2 = eval(e->right());
   return compare_equal(v1, v2, std::equal_to<>());
@@ -205,6 +329,8 @@ Evaluator::eval(Eq_expr const* e)
 Value
 Evaluator::eval(Ne_expr const* e)
 {
+  if (is<Vector_type>(e->type()))
+    return eval_vector(*this, vector_ne, e);
   Value v1 = eval(e->left());
   Value v2 = eval(e->right());
   return compare_equal(v1, v2, std::not_equal_to<>());
@@ -230,6 +356,8 @@ compare_less(Value const& v1, Value const& v2, F fn)
 Value
 Evaluator::eval(Lt_expr const* e)
 {
+  if (is<Vector_type>(e->type()))
+    return eval_vector(*this, vector_lt, e);
   Value v1 = eval(e->left());
   Value v2 = eval(e->right());
   return compare_less(v1, v2, std::less<>());
@@ -239,6 +367,8 @@ Evaluator::eval(Lt_expr const* e)
 Value
 Evaluator::eval(Gt_expr const* e)
 {
+  if (is<Vector_type>(e->type()))
+    return eval_vector(*this, vector_gt, e);
   Value v1 = eval(e->left());
   Value v2 = eval(e->right());
   return compare_less(v1, v2, std::greater<>());
@@ -248,6 +378,8 @@ Evaluator::eval(Gt_expr const* e)
 Value
 Evaluator::eval(Le_expr const* e)
 {
+  if (is<Vector_type>(e->type()))
+    return eval_vector(*this, vector_le, e);
   Value v1 = eval(e->left());
   Value v2 = eval(e->right());
   return compare_less(v1, v2, std::less_equal<>());
@@ -257,6 +389,8 @@ Evaluator::eval(Le_expr const* e)
 Value
 Evaluator::eval(Ge_expr const* e)
 {
+  if (is<Vector_type>(e->type()))
+    return eval_vector(*this, vector_ge, e);
   Value v1 = eval(e->left());
   Value v2 = eval(e->right());
   return compare_less(v1, v2, std::greater_equal<>());
@@ -296,8 +430,11 @@ Evaluator::eval(Not_expr const* e)
 Value
 Evaluator::eval(Call_expr const* e)
 {
-  // Evaluate the function expression.
+  // Evaluate the function expression. A reference to
+  // a function object is seen through.
   Value v = eval(e->target());
+  if (v.is_reference())
+    v = *v.get_reference();
   Function_decl const* f = v.get_function();
 
   // Evaluate each argument in turn.
@@ -306,17 +443,56 @@ Evaluator::eval(Call_expr const* e)
   for (Expr const* a : e->arguments())
     args.push_back(eval(a));
 
-  // Build the new call frame by pushing bindings
-  // from each parameter to the corresponding argument.
+  // If f is a virtual method, select the overrider for
+  // the dynamic type of the object. If f is a multimethod,
+  // select the target from the dynamic types of the
+  // virtual arguments.
+  if (Method_decl const* m = as<Method_decl>(f)) {
+    if (m->is_polymorphic())
+      f = dispatch_virtual(e, m, args.front());
+  } else if (Dispatch_table const* t = dispatch_map().table(f)) {
+    std::vector<int> ids;
+    ids.reserve(t->parms.size());
+    for (int n : t->parms) {
+      Value a = args[n];
+      if (a.is_reference())
+        a = *a.get_reference();
+      ids.push_back(dispatch_map().id(a.get_tuple().record()));
+    }
+    f = t->select(ids);
+    if (!f)
+      throw Evaluation_error({}, "ambiguous or missing multimethod target");
+  }
+
+  return call(f, args.data(), args.size());
+}
+
+
+// Call the function f with the n argument values in args.
+// The arguments must match the parameters of f. The module
+// of f must have been evaluated.
+Value
+Evaluator::call(Function_decl const* f, Value const* args, std::size_t n)
+{
+  // Build the new call frame by storing each argument
+  // in the slot of the corresponding parameter.
   //
   // FIXME: Since everything type-checked, these *must*
   // happen to magically line up. However, it would be
   // a good idea to verify.
-  Store_sentinel frame(*this);
-  for (std::size_t i = 0; i < args.size(); ++i) {
-    Decl* p = f->parameters()[i];
-    Value& v = args[i];
-    stack.top().bind(p->name(), v);
+  //
+  // Aggregate arguments are copied into new objects
+  // of the parameter type.
+  Frame_sentinel frame(*this, f->frame_size());
+  for (std::size_t i = 0; i < n; ++i) {
+    Parameter_decl const* p = cast<Parameter_decl>(f->parameters()[i]);
+    Value& v = stack.back()[p->slot()];
+    if (args[i].is_tuple() || args[i].is_array() || args[i].is_buffer() || args[i].is_string()) {
+      v = get_value(p->type());
+      copy_value(v, args[i]);
+    } else {
+      v = args[i];
+    }
   }
 
   // Evaluate the function definition.
@@ -332,6 +508,28 @@ Evaluator::eval(Call_expr const* e)
 }
 
 
+// Returns the overrider of m for the object of a
+// virtual call. The inline cache of the call site is
+// consulted first. The caches are indexed by the slots
+// of their call sites, and grow as new sites are seen.
+Function_decl const*
+Evaluator::dispatch_virtual(Call_expr const* e, Method_decl const* m, Value const& obj)
+{
+  Value const* v = obj.is_reference() ? obj.get_reference() : &obj;
+  Record_decl const* r = v->get_tuple().record();
+  lingo_assert(e->cache_slot() >= 0);
+  std::size_t n = e->cache_slot();
+  if (n >= caches.size())
+    caches.resize(n + 1);
+  Inline_cache& ic = caches[n];
+  if (Function_decl const* f = ic.find(r))
+    return f;
+  Function_decl const* f = cast<Function_decl>((*r->vtable())[m->vtable_entry()]);
+  ic.insert(r, f);
+  return f;
+}
+
+
 Value
 Evaluator::eval(Dot_expr const* e)
 {
@@ -344,14 +542,16 @@ Evaluator::eval(Field_expr const* e)
 {
   Value obj = eval(e->container());
   Value* ref = obj.get_reference();
-  return &ref->get_tuple().data[e->field()->index()];
+  return &ref->get_tuple().data()[e->field()->offset()];
 }
 
 
+// The object of a method expression is the first
+// argument of the method call.
 Value
 Evaluator::eval(Method_expr const* e)
 {
-  lingo_unimplemented();
+  return eval(e->container());
 }
 
 
@@ -362,7 +562,68 @@ Evaluator::eval(Index_expr const* e)
   Value arr = eval(e->array());
   Value* ref = arr.get_reference();
   Value ix = eval(e->index());
-  return &ref->get_array().data[ix.get_integer()];
+
+  // An object bound directly to a string gets its own
+  // copy of the characters when it is first indexed.
+  if (ref->is_string())
+    *ref = make_array(ref->get_string());
+
+  // Check the index unless it is known to be in bounds.
+  Integer_value n = ix.get_integer();
+  if (!e->in_bounds()) {
+    std::size_t len = ref->is_buffer() ? ref->get_buffer().len() : ref->get_array().len();
+    if (n < 0 || std::size_t(n) >= len)
+      throw Evaluation_error({}, "array index out of bounds");
+  }
+
+  // Arrays of scalars refer to their elements directly.
+  if (ref->is_buffer())
+    return Element_value {ref->get_buffer().element(n)};
+  return &ref->get_array().data()[n];
+}
+
+
+// Construct a vector from its elements, or from a single
+// value copied into each element.
+Value
+Evaluator::eval(Vector_expr const* e)
+{
+  Vector_type const* t = cast<Vector_type>(e->type());
+  Element_kind k = element_kind(t->type());
+  Expr_seq const& es = e->elements();
+  if (e->is_splat())
+    return vector_splat(k, t->size(), eval(es[0]));
+  Buffer_value r(k, t->size());
+  for (std::size_t i = 0; i < es.size(); ++i)
+    store(k, r.element(i), eval(es[i]));
+  return r;
+}
+
+
+// Returns a new vector holding the selected elements
+// of the operand.
+Value
+Evaluator::eval(Shuffle_expr const* e)
+{
+  Value v = eval(e->vector());
+  Buffer_value a = v.get_buffer();
+  std::size_t n = e->indexes().size();
+  std::size_t size = element_size(a.kind());
+  Buffer_value r(a.kind(), n);
+  for (std::size_t i = 0; i < n; ++i)
+    std::memcpy(r.element(i), a.element(e->index(i)), size);
+  release(e->vector(), v);
+  return r;
+}
+
+
+Value
+Evaluator::eval(Reduce_expr const* e)
+{
+  Value v = eval(e->operand());
+  Value r = vector_reduce(e->reduction(), v.get_buffer());
+  release(e->operand(), v);
+  return r;
 }
 
 
@@ -373,6 +634,8 @@ Value
 Evaluator::eval(Value_conv const* e)
 {
   Value v = eval(e->source());
+  if (v.is_element())
+    return load(element_kind(e->type()), v.get_element().addr);
   return *v.get_reference();
 }
 
@@ -387,40 +650,38 @@ Evaluator::eval(Block_conv const* e)
 }
 
 // Apply a promotion
+// int   -> int
 // int   -> float
 // int   -> double
 // float -> double
+//
+// Note that the source may be an object, in which
+// case its value is promoted.
 Value
 Evaluator::eval(Promote_conv const* e)
 {
   const Type * t = e->target();
   Value v = eval(e->source());
-
-  if(is<Float_type>(t)) {
-    if(v.is_integer()) 
-    {
-      return new Value((float)(v.get_integer()));
-    }
-  }
-  else if(is<Double_type>(t)) {
-    if(v.is_integer()) 
-    {
-      return new Value((double)(v.get_integer()));
-    }
-    if(v.is_float())
-    {
-      return new Value((double)(v.get_float()));
-    }
+  if (v.is_reference())
+    v = *v.get_reference();
+  else if (v.is_element())
+    v = load(element_kind(e->source()->type()->nonref()), v.get_element().addr);
+
+  if (is<Float_type>(t) || is<Double_type>(t)) {
+    if (v.is_integer())
+      return Value((double)v.get_integer());
   }
-
-  return new Value(v);
-
+  return v;
 }
 
+// A record object contains the fields of its base
+// classes at the same offsets as in the base, so the
+// base sub-object is denoted by a reference to the
+// object itself.
 Value
 Evaluator::eval(Base_conv const* e)
 {
-  throw std::runtime_error("not implemented");
+  return eval(e->source());
 }
 
 
@@ -441,14 +702,16 @@ Evaluator::eval_init(Trivial_init const* e, Value& v)
 void
 Evaluator::eval_init(Copy_init const* e, Value& v)
 {
-  eval(e->value());
+  Value x = eval(e->value());
+  copy_value(v, x);
+  release(e->value(), x);
 }
 
 
 void
 Evaluator::eval_init(Reference_init const* e, Value& v)
 {
-  lingo_unimplemented();
+  v = eval(e->object());
 }
 
 
@@ -503,16 +766,26 @@ get_value(Type const* t)
     }
 
     // Recursively construct an array whose values are
-    // shaped by the element type.
+    // shaped by the element type. Arrays of scalars are
+    // stored in buffers.
     Value operator()(Array_type const* t)
     {
+      if (is_scalar(t->type()))
+        return Buffer_value(element_kind(t->type()), t->size());
       Array_value v(t->size());
-      for (std::size_t i = 0; i < v.len; ++i)
-        v.data[i] = get_value(t->type());
+      for (std::size_t i = 0; i < v.len(); ++i)
+        v.data()[i] = get_value(t->type());
       return v;
     }
 
 
+    // Vectors are always stored in buffers.
+    Value operator()(Vector_type const* t)
+    {
+      return Buffer_value(element_kind(t->type()), t->size());
+    }
+
+
     // FIXME: What kind of value is this?
     Value operator()(Block_type const*)
     {
@@ -529,10 +802,11 @@ get_value(Type const* t)
     Value operator()(Record_type const* t)
     {
       Record_decl const* d = t->declaration();
-      Decl_seq const& f = d->fields();
+      Decl_seq const& f = d->layout();
       Tuple_value v(f.size());
-      for (std::size_t i = 0; i < v.len; ++i)
-        v.data[i] = get_value(f[i]->type());
+      v.rep->record = d;
+      for (std::size_t i = 0; i < v.len(); ++i)
+        v.data()[i] = get_value(f[i]->type());
       return v;
     }
   };
@@ -545,22 +819,21 @@ get_value(Type const* t)
 void
 Evaluator::eval(Variable_decl const* d)
 {
-  // Create an uninitialized object and bind it
-  // to the symbol. Keep a reference so we can
-  // initialize it directly.
-  Value v0 = get_value(d->type());
-  Value& v1 = stack.top().bind(d->name(), v0).second;
-
-  // Handle initialization.
-  eval_init(d->init(), v1);
+  // Create an uninitialized object in the variable's
+  // slot, and initialize it directly.
+  Value& v = storage(d);
+  v = get_value(d->type());
+  eval_init(d->init(), v);
 }
 
 
-// Bind the symbol to a function value.
+// Functions are not bound in the store since they
+// denote themselves. Note that overloaded functions
+// share a name.
 void
 Evaluator::eval(Function_decl const* d)
 {
-  stack.top().bind(d->name(), d);
+  return;
 }
 
 
@@ -600,9 +873,24 @@ Evaluator::eval(Method_decl const*)
 void
 Evaluator::eval(Module_decl const* d)
 {
-  Store_sentinel store(*this);
+  globals.assign(d->frame_size(), Value());
+  dispatch.add(d);
   for (Decl const* d1 : d->declarations())
     eval(d1);
+  ready = true;
+}
+
+
+// Establish the evaluation context of the module d
+// from the global store g, which was saved after the
+// declarations of d were evaluated. The store is moved,
+// not copied, so references to its objects remain valid.
+void
+Evaluator::init(Module_decl const* d, Frame&& g)
+{
+  globals = std::move(g);
+  dispatch.add(d);
+  ready = true;
 }
 
 
@@ -627,7 +915,10 @@ Evaluator::eval(Stmt const* s, Value& r)
     Control operator()(Return_stmt const* s) { return ev.eval(s, r); }
     Control operator()(If_then_stmt const* s) { return ev.eval(s, r); }
     Control operator()(If_else_stmt const* s) { return ev.eval(s, r); }
+    Control operator()(Switch_stmt const* s) { return ev.eval(s, r); }
     Control operator()(While_stmt const* s) { return ev.eval(s, r); }
+    Control operator()(For_stmt const* s) { return ev.eval(s, r); }
+    Control operator()(Parallel_for_stmt const* s) { return ev.eval(s, r); }
     Control operator()(Break_stmt const* s) { return ev.eval(s, r); }
     Control operator()(Continue_stmt const* s) { return ev.eval(s, r); }
     Control operator()(Expression_stmt const* s) { return ev.eval(s, r); }
@@ -648,7 +939,6 @@ Evaluator::eval(Empty_stmt const* s, Value& r)
 Control
 Evaluator::eval(Block_stmt const* s, Value& r)
 {
-  Store_sentinel store(*this);
   for (Stmt const* s1 : s->statements()) {
 
     // Evaluate each statement in turn. If the
@@ -671,7 +961,11 @@ Evaluator::eval(Assign_stmt const* s, Value& r)
 {
   Value lhs = eval(s->object());
   Value rhs = eval(s->value());
-  *lhs.get_reference() = rhs;
+  if (lhs.is_element())
+    store(element_kind(s->object()->type()->nonref()), lhs.get_element().addr, rhs);
+  else
+    copy_value(*lhs.get_reference(), rhs);
+  release(s->value(), rhs);
   return next_ctl;
 }
 
@@ -712,11 +1006,159 @@ Evaluator::eval(If_else_stmt const* s, Value& r)
 }
 
 
+namespace
+{
+
+// A switch whose labels span no more than this many
+// values per label uses a dense table.
+constexpr Integer_value max_sparsity = 4;
+
+} // namespace
+
+
+Switch_table::Switch_table(Switch_stmt const* s)
+{
+  std::vector<std::pair<Integer_value, int>> labels;
+  for (std::size_t i = 0; i < s->cases().size(); ++i) {
+    for (Expr const* e : s->cases()[i].labels())
+      labels.emplace_back(cast<Literal_expr>(e)->value().get_integer(), i);
+  }
+  if (labels.empty())
+    return;
+
+  auto cmp = [](auto const& a, auto const& b) { return a.first < b.first; };
+  Integer_value lo = std::min_element(labels.begin(), labels.end(), cmp)->first;
+  Integer_value hi = std::max_element(labels.begin(), labels.end(), cmp)->first;
+  std::uint64_t span = std::uint64_t(hi) - std::uint64_t(lo) + 1;
+  if (span <= std::uint64_t(max_sparsity) * labels.size()) {
+    first = lo;
+    dense.assign(span, -1);
+    for (auto const& l : labels)
+      dense[std::uint64_t(l.first) - std::uint64_t(lo)] = l.second;
+  } else {
+    for (auto const& l : labels)
+      sparse.emplace(l.first, l.second);
+  }
+}
+
+
+// Evaluate the case selected by the condition through
+// the dispatch table of the switch, which is built on
+// first use. A break statement leaves the switch.
+Control
+Evaluator::eval(Switch_stmt const* s, Value& r)
+{
+  auto iter = switches.find(s);
+  if (iter == switches.end())
+    iter = switches.emplace(s, Switch_table(s)).first;
+  int n = iter->second.find(eval(s->condition()).get_integer());
+  Stmt const* b = n < 0 ? s->default_case() : s->cases()[n].body();
+  if (!b)
+    return next_ctl;
+  Control ctl = eval(b, r);
+  return ctl == break_ctl ? next_ctl : ctl;
+}
+
+
+// Returns the kernel for the loop s, matching it on
+// the first use.
+template<typename T>
+Loop_kernel const&
+Evaluator::get_kernel(T const* s)
+{
+  auto ins = kernels.emplace(s, Loop_kernel());
+  if (ins.second)
+    ins.first->second = match_kernel(s);
+  return ins.first->second;
+}
+
+
+// Evaluate a loop as a kernel, if possible. Returns
+// false if the loop is not a kernel, or if its arrays
+// are not integer buffers that hold every element
+// indexed by the loop.
+bool
+Evaluator::eval_kernel(While_stmt const* s)
+{
+  Loop_kernel const& k = get_kernel(s);
+  if (!k.ok)
+    return false;
+
+  Value& i = storage(k.index);
+  Kernel_frame f;
+  f.first = i.get_integer();
+  f.last = eval(k.bound).get_integer();
+  if (f.first >= f.last)
+    return true;
+  if (!eval_kernel(k, f))
+    return false;
+  i = f.last;
+  return true;
+}
+
+
+// Evaluate the iterations [first, last) of a for loop as
+// a kernel, if possible.
+bool
+Evaluator::eval_kernel(For_stmt const* s, Integer_value first, Integer_value last)
+{
+  Loop_kernel const& k = get_kernel(s);
+  if (!k.ok)
+    return false;
+
+  Kernel_frame f;
+  f.first = first;
+  f.last = last;
+  return eval_kernel(k, f);
+}
+
+
+// Run the kernel k over the indexes of the frame f.
+bool
+Evaluator::eval_kernel(Loop_kernel const& k, Kernel_frame& f)
+{
+  // Returns the array if it is an integer buffer
+  // containing the indexed elements.
+  auto buffer = [&](Expr const* e) -> Value* {
+    Value* v = eval(e).get_reference();
+    if (!v->is_buffer())
+      return nullptr;
+    Buffer_value b = v->get_buffer();
+    if (f.first < 0 || f.last > (Integer_value)b.len() || !is_integer_element(b.kind()))
+      return nullptr;
+    return v;
+  };
+
+  for (Expr const* e : k.arrays) {
+    Value* v = buffer(e);
+    if (!v)
+      return false;
+    f.arrays.push_back(v->get_buffer());
+  }
+  for (Expr const* e : k.invariants)
+    f.invariants.push_back(eval(e).get_integer());
+
+  if (k.target) {
+    Value* v = buffer(k.target);
+    if (!v)
+      return false;
+    run_kernel(k, f, v->get_buffer());
+  } else {
+    Value& sum = storage(k.accum);
+    sum = sum.get_integer() + run_kernel(k, f);
+  }
+  return true;
+}
+
+
 // Continue evaluationg the body while the condition
 // evaluates to true.
 Control
 Evaluator::eval(While_stmt const* s, Value& r)
 {
+  if (eval_kernel(s))
+    return next_ctl;
+
   while (true) {
     Value c = eval(s->condition());
     if (!c.get_integer())
@@ -735,6 +1177,68 @@ Evaluator::eval(While_stmt const* s, Value& r)
 }
 
 
+// Evaluate the body once for each value of the counter.
+// The bounds are evaluated once, and the loop variable is
+// assigned from the counter, so there is no condition to
+// evaluate between iterations.
+Control
+Evaluator::eval(For_stmt const* s, Value& r)
+{
+  Integer_value first = eval(s->lower()).get_integer();
+  Integer_value last = eval(s->upper()).get_integer();
+  if (first >= last || eval_kernel(s, first, last))
+    return next_ctl;
+
+  Value& x = storage(s->variable());
+  for (Integer_value i = first; i < last; ++i) {
+    x = i;
+    Control ctl = eval(s->body(), r);
+    if (ctl == break_ctl)
+      break;
+    if (ctl == return_ctl)
+      return ctl;
+  }
+  return next_ctl;
+}
+
+
+// Create an evaluator for the iterations of a parallel
+// loop. It shares the globals and dispatch tables of the
+// evaluator r, but has its own stack and caches, so that
+// it can run on another thread.
+Evaluator::Evaluator(Evaluator* r)
+  : root(r), ready(true)
+{ }
+
+
+// Evaluate the iterations of a parallel loop on the
+// threads of the parallel pool. Each chunk of iterations
+// is evaluated in a copy of the current frame, so that
+// the variables declared in the body are not shared.
+// Aggregates share storage when copied, so the arrays
+// declared outside of the loop are shared.
+Control
+Evaluator::eval(Parallel_for_stmt const* s, Value& r)
+{
+  Integer_value first = eval(s->lower()).get_integer();
+  Integer_value last = eval(s->upper()).get_integer();
+  Frame const& frame = stack.back();
+  int slot = s->variable()->slot();
+  Evaluator* g = root ? root : this;
+  parallel_pool().run(first, last, [&](Integer_value lo, Integer_value hi) {
+    Evaluator ev(g);
+    ev.stack.push_back(frame);
+    Value& x = ev.stack.back()[slot];
+    for (Integer_value i = lo; i < hi; ++i) {
+      x = i;
+      Value r1;
+      ev.eval(s->body(), r1);
+    }
+  });
+  return next_ctl;
+}
+
+
 Control
 Evaluator::eval(Break_stmt const* s, Value& r)
 {
@@ -799,13 +1303,14 @@ Value
 Evaluator::exec(Function_decl const* fn)
 {
   // Evaluate all of the top-level declarations in
-  // order to re-establish the evaluation context.
-  Store_sentinel store(*this);
+  // order to re-establish the evaluation context,
+  // unless that has already been done.
   Module_decl const* m = cast<Module_decl>(fn->context());
-  for (Decl const* d : m->declarations())
-    eval(d);
+  if (!ready)
+    eval(m);
 
   // TODO: Check the result code.
+  Frame_sentinel frame(*this, fn->frame_size());
   Value result;
   Control ctl = eval(fn->body(), result);
   if (ctl != return_ctl)
@@ -813,3 +1318,22 @@ Evaluator::exec(Function_decl const* fn)
 
   return result;
 }
+
+
+// Returns the sum of the counters of the inline caches
+// of all virtual call sites evaluated so far.
+Inline_cache_stats
+Evaluator::cache_stats() const
+{
+  Inline_cache_stats st;
+  for (Inline_cache const& ic : caches) {
+    if (ic.hits == 0 && ic.misses == 0)
+      continue;
+    ++st.sites;
+    if (ic.count == Inline_cache::size && ic.misses > std::size_t(ic.count))
+      ++st.megamorphic;
+    st.hits += ic.hits;
+    st.misses += ic.misses;
+  }
+  return st;
+}
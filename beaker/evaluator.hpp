@@ -6,21 +6,114 @@
 
 #include <beaker/prelude.hpp>
 #include <beaker/value.hpp>
-#include <beaker/environment.hpp>
+#include <beaker/dispatch.hpp>
+#include <beaker/kernel.hpp>
 
+#include <unordered_map>
 
-// Dynamic binding of symbols to their values.
-using Store = Environment<Symbol const*, Value>;
 
+// A frame holds the values of the parameters and
+// local variables of a function call. Each is stored
+// in the slot assigned to it during elaboration.
+using Frame = std::vector<Value>;
 
-// The store stack maintains the dynamic binding
-// between symbols and their values. Each time
-// a new binding environment is entered (e.g., a
-// block scope), a new frame is created to store
-// bindings.
-//
-// This is also the call stack.
-using Store_stack = Stack<Store>;
+
+// The call stack. Each function call pushes a new
+// frame. Frames are not copied when the stack grows,
+// so references to their values remain valid.
+using Frame_stack = std::vector<Frame>;
+
+
+// An inline cache for a virtual call site. The cache
+// holds the targets selected for the receiver types
+// most recently seen at the site. A site that sees more
+// receiver types than the cache can hold is megamorphic;
+// its misses are resolved through the virtual table
+// of the receiver.
+struct Inline_cache
+{
+  static constexpr int size = 4;
+
+  struct Entry
+  {
+    Record_decl const*   record;
+    Function_decl const* target;
+  };
+
+  Function_decl const* find(Record_decl const*);
+  void                 insert(Record_decl const*, Function_decl const*);
+
+  Entry       entries[size];
+  int         count  = 0;
+  std::size_t hits   = 0;
+  std::size_t misses = 0;
+};
+
+
+// Returns the cached target for the receiver type r, or
+// nullptr if there is none.
+inline Function_decl const*
+Inline_cache::find(Record_decl const* r)
+{
+  for (int i = 0; i < count; ++i) {
+    if (entries[i].record == r) {
+      ++hits;
+      return entries[i].target;
+    }
+  }
+  ++misses;
+  return nullptr;
+}
+
+
+// Add a target to the cache, unless the cache is full.
+inline void
+Inline_cache::insert(Record_decl const* r, Function_decl const* f)
+{
+  if (count < size)
+    entries[count++] = {r, f};
+}
+
+
+// The sum of the counters of all inline caches.
+struct Inline_cache_stats
+{
+  std::size_t sites       = 0;
+  std::size_t megamorphic = 0;
+  std::size_t hits        = 0;
+  std::size_t misses      = 0;
+};
+
+
+// The dispatch table of a switch statement. It maps the
+// value of the condition to the index of the selected
+// case, or to -1 if the default case is selected. When
+// the labels are dense, the table is an array indexed by
+// the value less the smallest label. Otherwise, the
+// labels are hashed.
+struct Switch_table
+{
+  explicit Switch_table(Switch_stmt const*);
+
+  int find(Integer_value) const;
+
+  Integer_value                          first = 0;
+  std::vector<int>                       dense;
+  std::unordered_map<Integer_value, int> sparse;
+};
+
+
+// Returns the index of the case labeled n.
+inline int
+Switch_table::find(Integer_value n) const
+{
+  if (!dense.empty()) {
+    std::uint64_t i = std::uint64_t(n) - std::uint64_t(first);
+    return i < dense.size() ? dense[i] : -1;
+  }
+  auto iter = sparse.find(n);
+  return iter == sparse.end() ? -1 : iter->second;
+}
 
 
 // Represents the evaluation of a statement.
@@ -39,8 +132,10 @@ enum Control
 // of a program as a value.
 class Evaluator
 {
-  struct Store_sentinel;
+  struct Frame_sentinel;
 public:
+  Evaluator() = default;
+
   Value eval(Expr const*);
   Value eval(Literal_expr const*);
   Value eval(Id_expr const*);
@@ -66,6 +161,9 @@ public:
   Value eval(Field_expr const*);
   Value eval(Method_expr const*);
   Value eval(Index_expr const*);
+  Value eval(Vector_expr const*);
+  Value eval(Shuffle_expr const*);
+  Value eval(Reduce_expr const*);
   Value eval(Value_conv const*);
   Value eval(Block_conv const*);
   Value eval(Base_conv const*);
@@ -93,31 +191,62 @@ public:
   Control eval(Return_stmt const*, Value&);
   Control eval(If_then_stmt const*, Value&);
   Control eval(If_else_stmt const*, Value&);
+  Control eval(Switch_stmt const*, Value&);
   Control eval(While_stmt const*, Value&);
+  Control eval(For_stmt const*, Value&);
+  Control eval(Parallel_for_stmt const*, Value&);
   Control eval(Break_stmt const*, Value&);
   Control eval(Continue_stmt const*, Value&);
   Control eval(Expression_stmt const*, Value&);
   Control eval(Declaration_stmt const*, Value&);
 
+  void  init(Module_decl const*, Frame&&);
   Value exec(Function_decl const*);
+  Value call(Function_decl const*, Value const*, std::size_t);
+
+  Frame const& global_store() const { return globals; }
+
+  Inline_cache_stats cache_stats() const;
 
 private:
-  Store_stack stack;
+  explicit Evaluator(Evaluator*);
+
+  Value&               storage(Decl const*);
+  Function_decl const* dispatch_virtual(Call_expr const*, Method_decl const*, Value const&);
+  bool                 eval_kernel(While_stmt const*);
+  bool                 eval_kernel(For_stmt const*, Integer_value, Integer_value);
+  bool                 eval_kernel(Loop_kernel const&, Kernel_frame&);
+
+  template<typename T>
+  Loop_kernel const&   get_kernel(T const*);
+
+  Frame&              global_frame()       { return root ? root->globals : globals; }
+  Dispatch_map const& dispatch_map() const { return root ? root->dispatch : dispatch; }
+
+  Evaluator*   root = nullptr; // Owns the globals, if this runs a parallel loop
+  Frame        globals;
+  bool         ready = false;
+  Frame_stack  stack;
+  Dispatch_map dispatch;
+
+  std::vector<Inline_cache>                            caches;
+  std::unordered_map<Stmt const*, Loop_kernel>         kernels;
+  std::unordered_map<Switch_stmt const*, Switch_table> switches;
 };
 
 
 // A helper class for managing stack frames.
-struct Evaluator::Store_sentinel
+struct Evaluator::Frame_sentinel
 {
-  Store_sentinel(Evaluator& e)
+  Frame_sentinel(Evaluator& e, std::size_t n)
     : eval(e)
   {
-    eval.stack.push();
+    eval.stack.emplace_back(n);
   }
 
-  ~Store_sentinel()
+  ~Frame_sentinel()
   {
-    eval.stack.pop();
+    eval.stack.pop_back();
   }
 
   Evaluator& eval;
@@ -62,6 +62,15 @@ Method_expr::method() const
 }
 
 
+// Returns the nth index of the shuffle. Elaboration
+// reduces each index to a literal.
+int
+Shuffle_expr::index(std::size_t n) const
+{
+  return cast<Literal_expr>(second[n])->value().get_integer();
+}
+
+
 // Return true if e is an expression that be used
 // as the target of a function call.
 bool
@@ -74,6 +74,9 @@ struct Expr::Visitor
   virtual void visit(Field_expr const*) = 0;
   virtual void visit(Method_expr const*) = 0;
   virtual void visit(Index_expr const*) = 0;
+  virtual void visit(Vector_expr const*) = 0;
+  virtual void visit(Shuffle_expr const*) = 0;
+  virtual void visit(Reduce_expr const*) = 0;
   virtual void visit(Value_conv const*) = 0;
   virtual void visit(Block_conv const*) = 0;
   virtual void visit(Base_conv const*) = 0;
@@ -119,6 +122,9 @@ struct Expr::Mutator
   virtual void visit(Field_expr*) = 0;
   virtual void visit(Method_expr*) = 0;
   virtual void visit(Index_expr*) = 0;
+  virtual void visit(Vector_expr*) = 0;
+  virtual void visit(Shuffle_expr*) = 0;
+  virtual void visit(Reduce_expr*) = 0;
   virtual void visit(Value_conv*) = 0;
   virtual void visit(Block_conv*) = 0;
   virtual void visit(Base_conv*) = 0;
@@ -427,26 +433,31 @@ struct Not_expr : Unary_expr
 // resolved to a declaration. Should we subclass this
 // to provide resolution hints? Note that we guarantee
 // that the target is a decl-expr referring to a function.
+//
+// A call to a method is given the slot of its inline
+// cache during elaboration. Other calls have no slot.
 struct Call_expr : Expr
 {
   Call_expr(Expr* f, Expr_seq const& a)
-    : first(f), second(a)
+    : first(f), second(a), slot(-1)
   { }
 
     Call_expr(Type const* t, Expr* f, Expr_seq const& a)
-    : Expr(t), first(f), second(a)
+    : Expr(t), first(f), second(a), slot(-1)
   { }
 
 
   void accept(Visitor& v) const { v.visit(this); }
   void accept(Mutator& v)       { v.visit(this); }
 
-  Expr*           target() const    { return first; }
-  Expr_seq const& arguments() const { return second; }
-  Expr_seq&       arguments()       { return second; }
+  Expr*           target() const     { return first; }
+  Expr_seq const& arguments() const  { return second; }
+  Expr_seq&       arguments()        { return second; }
+  int             cache_slot() const { return slot; }
 
   Expr*    first;
   Expr_seq second;
+  int      slot;
 };
 
 
@@ -531,20 +542,103 @@ struct Method_expr : Dot_expr
 
 // Represents the expression e1[e2] where e1
 // has array type.
+//
+// The index is checked against the bounds of the
+// array unless it is known to be in bounds. See
+// bounds.hpp.
 struct Index_expr : Expr
 {
   Index_expr(Expr* e1, Expr* e2)
-    : first(e1), second(e2)
+    : first(e1), second(e2), safe(false)
   { }
 
   void accept(Visitor& v) const { v.visit(this); }
   void accept(Mutator& v)       { v.visit(this); }
 
-  Expr* array() const   { return first; }
-  Expr* index() const   { return second; }
+  Expr* array() const     { return first; }
+  Expr* index() const     { return second; }
+  bool  in_bounds() const { return safe; }
 
   Expr* first;
   Expr* second;
+  bool  safe;
+};
+
+
+// -------------------------------------------------------------------------- //
+// Vector expressions
+
+// Represents the expression vec<T, N>(e1, ..., en), which
+// creates a vector from the values of its elements. With a
+// single argument, the value is copied into each element.
+//
+// The type of the expression is the vector type.
+struct Vector_expr : Expr
+{
+  Vector_expr(Type const* t, Expr_seq const& a)
+    : Expr(t), first(a)
+  { }
+
+  void accept(Visitor& v) const { v.visit(this); }
+  void accept(Mutator& v)       { v.visit(this); }
+
+  Expr_seq const& elements() const { return first; }
+  bool            is_splat() const { return first.size() == 1; }
+
+  Expr_seq first;
+};
+
+
+// Represents the expression shuffle(e, i1, ..., in), which
+// creates a vector of n elements whose kth element is the
+// element ik of the vector e. Each index is a constant.
+struct Shuffle_expr : Expr
+{
+  Shuffle_expr(Expr* e, Expr_seq const& ix)
+    : first(e), second(ix)
+  { }
+
+  void accept(Visitor& v) const { v.visit(this); }
+  void accept(Mutator& v)       { v.visit(this); }
+
+  Expr*           vector() const  { return first; }
+  Expr_seq const& indexes() const { return second; }
+  int             index(std::size_t) const;
+
+  Expr*    first;
+  Expr_seq second;
+};
+
+
+// The operators that reduce the elements of a vector
+// to a single value.
+enum Reduction
+{
+  sum_reduction,     // reduce(+, v)
+  product_reduction, // reduce(*, v)
+  min_reduction,     // reduce(<, v)
+  max_reduction,     // reduce(>, v)
+  all_reduction,     // reduce(&&, v)
+  any_reduction,     // reduce(||, v)
+};
+
+
+// Represents the expression reduce(op, e), which combines
+// the elements of the vector e with op. The least and
+// greatest elements are selected by < and >, and the
+// logical operators apply to vectors of bool.
+struct Reduce_expr : Unary_expr
+{
+  Reduce_expr(Reduction r, Expr* e)
+    : Unary_expr(e), op(r)
+  { }
+
+  void accept(Visitor& v) const { v.visit(this); }
+  void accept(Mutator& v)       { v.visit(this); }
+
+  Reduction reduction() const { return op; }
+
+  Reduction op;
 };
 
 
@@ -751,6 +845,9 @@ struct Generic_expr_visitor : Expr::Visitor, lingo::Generic_visitor<F, T>
   void visit(Field_expr const* e) { this->invoke(e); }
   void visit(Method_expr const* e) { this->invoke(e); }
   void visit(Index_expr const* e) { this->invoke(e); }
+  void visit(Vector_expr const* e) { this->invoke(e); }
+  void visit(Shuffle_expr const* e) { this->invoke(e); }
+  void visit(Reduce_expr const* e) { this->invoke(e); }
   void visit(Value_conv const* e) { this->invoke(e); }
   void visit(Block_conv const* e) { this->invoke(e); }
   void visit(Base_conv const* e) { this->invoke(e); }
@@ -812,6 +909,9 @@ struct Generic_expr_mutator : Expr::Mutator, lingo::Generic_mutator<F, T>
   void visit(Field_expr* e) { this->invoke(e); }
   void visit(Method_expr* e) { this->invoke(e); }
   void visit(Index_expr* e) { this->invoke(e); }
+  void visit(Vector_expr* e) { this->invoke(e); }
+  void visit(Shuffle_expr* e) { this->invoke(e); }
+  void visit(Reduce_expr* e) { this->invoke(e); }
   void visit(Value_conv* e) { this->invoke(e); }
   void visit(Block_conv* e) { this->invoke(e); }
   void visit(Base_conv* e) { this->invoke(e); }
@@ -17,6 +17,8 @@ get_file_kind(Path const& p)
   Path ext = p.extension();
   if (ext == ".bkr")
     return beaker_file;
+  if (ext == ".bki")
+    return interface_file;
   if (ext == ".ll")
     return ir_file;
   if (ext == ".bc")
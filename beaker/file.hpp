@@ -46,6 +46,7 @@ enum File_kind
 
   // Input languages
   beaker_file,     // Beaker source text
+  interface_file,  // Beaker module interface
   
   // Intermediate languages
   ir_file,         // LLVM source text
@@ -106,4 +107,13 @@ to_object_file(Path p)
 }
 
 
+// Return a new path by replacing the extension of
+// the output of a module with a .bki extension.
+inline Path
+to_interface_file(Path p)
+{
+  return p.replace_extension(".bki");
+}
+
+
 #endif
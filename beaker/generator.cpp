@@ -15,6 +15,8 @@
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/MDBuilder.h"
 
 #include <iostream>
 
@@ -48,9 +50,15 @@ Generator::get_name(Decl const* d)
 // its correspondiong LLVM type.
 
 
+// Returns the LLVM type corresponding to t. Each type
+// is lowered once; later requests reuse the result.
 llvm::Type*
 Generator::get_type(Type const* t)
 {
+  auto iter = lowered.find(t);
+  if (iter != lowered.end())
+    return iter->second;
+
   struct Fn
   {
     Generator& g;
@@ -62,11 +70,14 @@ Generator::get_type(Type const* t)
     llvm::Type* operator()(Double_type const* t) const { return g.get_type(t); }
     llvm::Type* operator()(Function_type const* t) const { return g.get_type(t); }
     llvm::Type* operator()(Array_type const* t) const { return g.get_type(t); }
+    llvm::Type* operator()(Vector_type const* t) const { return g.get_type(t); }
     llvm::Type* operator()(Block_type const* t) const { return g.get_type(t); }
     llvm::Type* operator()(Reference_type const* t) const { return g.get_type(t); }
     llvm::Type* operator()(Record_type const* t) const { return g.get_type(t); }
   };
-  return apply(t, Fn{*this});
+  llvm::Type* r = apply(t, Fn{*this});
+  lowered.emplace(t, r);
+  return r;
 }
 
 
@@ -146,8 +157,16 @@ llvm::Type*
 Generator::get_type(Array_type const* t)
 {
   llvm::Type* t1 = get_type(t->type());
-  Value v = evaluate(t->extent());
-  return llvm::ArrayType::get(t1, v.get_integer());
+  return llvm::ArrayType::get(t1, t->size());
+}
+
+
+// Return a vector type.
+llvm::Type*
+Generator::get_type(Vector_type const* t)
+{
+  llvm::Type* t1 = get_type(t->type());
+  return llvm::VectorType::get(t1, t->size());
 }
 
 
@@ -229,6 +248,9 @@ Generator::gen(Expr const* e)
     llvm::Value* operator()(Field_expr const* e) const { return g.gen(e); }
     llvm::Value* operator()(Method_expr const* e) const { return g.gen(e); }
     llvm::Value* operator()(Index_expr const* e) const { return g.gen(e); }
+    llvm::Value* operator()(Vector_expr const* e) const { return g.gen(e); }
+    llvm::Value* operator()(Shuffle_expr const* e) const { return g.gen(e); }
+    llvm::Value* operator()(Reduce_expr const* e) const { return g.gen(e); }
     llvm::Value* operator()(Value_conv const* e) const { return g.gen(e); }
     llvm::Value* operator()(Promote_conv const* e) const { return g.gen(e); }
     llvm::Value* operator()(Block_conv const* e) const { return g.gen(e); }
@@ -283,22 +305,27 @@ Generator::gen(Literal_expr const* e)
   if (t == get_integer_type())
     return build.getInt32(v.get_integer());
 
+  // Literals of other numeric types are the elements
+  // of vectors.
+  if (is<Integer_type>(t))
+    return llvm::ConstantInt::get(get_type(t), v.get_integer(), true);
+  if (is<Float_type>(t) || is<Double_type>(t))
+    return llvm::ConstantFP::get(get_type(t), v.get_float());
+
   // FIXME: How should we generate array literals? Are
   // these global constants or are they local alloca
   // objects. Does it depend on context?
 
   // A string literal produces a new global string constant.
   // and returns a pointer to an array of N characters.
+  //
+  // String values refer to the string pool, so equal
+  // strings are unified by their address.
   if (is_string(t)) {
-    Array_value a = v.get_array();
-    String s = a.get_string();
-
-    // FIXME: This does not unify equivalent strings.
-    // Maybe we needt maintain a mapping in order to
-    // avoid redunancies.
+    String_value s = v.get_string();
     auto iter = strings.find(s);
     if (iter == strings.end()) {
-      llvm::Value* v = build.CreateGlobalString(s);
+      llvm::Value* v = build.CreateGlobalString(*s);
       iter = strings.emplace(s, v).first;
     }
     return iter->second;
@@ -332,11 +359,39 @@ Generator::gen(Decl_expr const* e)
 }
 
 
+namespace
+{
+
+// Returns true if t is a vector of floating point
+// numbers.
+inline bool
+has_float_elements(Type const* t)
+{
+  Type const* t1 = get_element_type(t);
+  return t1 && (is<Float_type>(t1) || is<Double_type>(t1));
+}
+
+
+// Returns true if t is a vector of unsigned integers.
+inline bool
+has_unsigned_elements(Type const* t)
+{
+  Type const* t1 = get_element_type(t);
+  Integer_type const* i = t1 ? as<Integer_type>(t1) : nullptr;
+  return i && !i->is_signed();
+}
+
+
+} // namespace
+
+
 llvm::Value*
 Generator::gen(Add_expr const* e)
 {
   llvm::Value* l = gen(e->left());
   llvm::Value* r = gen(e->right());
+  if (has_float_elements(e->type()))
+    return build.CreateFAdd(l, r);
   return build.CreateAdd(l, r);
 }
 
@@ -346,6 +401,8 @@ Generator::gen(Sub_expr const* e)
 {
   llvm::Value* l = gen(e->left());
   llvm::Value* r = gen(e->right());
+  if (has_float_elements(e->type()))
+    return build.CreateFSub(l, r);
   return build.CreateSub(l, r);
 }
 
@@ -355,6 +412,8 @@ Generator::gen(Mul_expr const* e)
 {
   llvm::Value* l = gen(e->left());
   llvm::Value* r = gen(e->right());
+  if (has_float_elements(e->type()))
+    return build.CreateFMul(l, r);
   return build.CreateMul(l, r);
 }
 
@@ -364,6 +423,10 @@ Generator::gen(Div_expr const* e)
 {
   llvm::Value* l = gen(e->left());
   llvm::Value* r = gen(e->right());
+  if (has_float_elements(e->type()))
+    return build.CreateFDiv(l, r);
+  if (has_unsigned_elements(e->type()))
+    return build.CreateUDiv(l, r);
   return build.CreateSDiv(l, r);
 }
 
@@ -375,6 +438,10 @@ Generator::gen(Rem_expr const* e)
 {
   llvm::Value* l = gen(e->left());
   llvm::Value* r = gen(e->right());
+  if (has_float_elements(e->type()))
+    return build.CreateFRem(l, r);
+  if (is<Vector_type>(e->type()) && !has_unsigned_elements(e->type()))
+    return build.CreateSRem(l, r);
   return build.CreateURem(l, r);
 }
 
@@ -382,6 +449,12 @@ Generator::gen(Rem_expr const* e)
 llvm::Value*
 Generator::gen(Neg_expr const* e)
 {
+  if (is<Vector_type>(e->type())) {
+    llvm::Value* val = gen(e->operand());
+    if (has_float_elements(e->type()))
+      return build.CreateFNeg(val);
+    return build.CreateNeg(val);
+  }
   llvm::Value* zero = build.getInt32(0);
   llvm::Value* val = gen(e->operand());
   return build.CreateSub(zero, val);
@@ -400,6 +473,9 @@ Generator::gen(Eq_expr const* e)
 {
   llvm::Value* l = gen(e->left());
   llvm::Value* r = gen(e->right());
+  Type const* t = e->left()->type();
+  if (has_float_elements(t))
+    return build.CreateFCmpOEQ(l, r);
   return build.CreateICmpEQ(l, r);
 }
 
@@ -409,6 +485,9 @@ Generator::gen(Ne_expr const* e)
 {
   llvm::Value* l = gen(e->left());
   llvm::Value* r = gen(e->right());
+  Type const* t = e->left()->type();
+  if (has_float_elements(t))
+    return build.CreateFCmpUNE(l, r);
   return build.CreateICmpNE(l, r);
 }
 
@@ -418,6 +497,11 @@ Generator::gen(Lt_expr const* e)
 {
   llvm::Value* l = gen(e->left());
   llvm::Value* r = gen(e->right());
+  Type const* t = e->left()->type();
+  if (has_float_elements(t))
+    return build.CreateFCmpOLT(l, r);
+  if (has_unsigned_elements(t))
+    return build.CreateICmpULT(l, r);
   return build.CreateICmpSLT(l, r);
 }
 
@@ -427,6 +511,11 @@ Generator::gen(Gt_expr const* e)
 {
   llvm::Value* l = gen(e->left());
   llvm::Value* r = gen(e->right());
+  Type const* t = e->left()->type();
+  if (has_float_elements(t))
+    return build.CreateFCmpOGT(l, r);
+  if (has_unsigned_elements(t))
+    return build.CreateICmpUGT(l, r);
   return build.CreateICmpSGT(l, r);
 }
 
@@ -436,6 +525,11 @@ Generator::gen(Le_expr const* e)
 {
   llvm::Value* l = gen(e->left());
   llvm::Value* r = gen(e->right());
+  Type const* t = e->left()->type();
+  if (has_float_elements(t))
+    return build.CreateFCmpOLE(l, r);
+  if (has_unsigned_elements(t))
+    return build.CreateICmpULE(l, r);
   return build.CreateICmpSLE(l, r);
 }
 
@@ -445,6 +539,11 @@ Generator::gen(Ge_expr const* e)
 {
   llvm::Value* l = gen(e->left());
   llvm::Value* r = gen(e->right());
+  Type const* t = e->left()->type();
+  if (has_float_elements(t))
+    return build.CreateFCmpOGE(l, r);
+  if (has_unsigned_elements(t))
+    return build.CreateICmpUGE(l, r);
   return build.CreateICmpSGE(l, r);
 }
 
@@ -525,6 +624,19 @@ calls_virtual_method(Call_expr const* e)
 }
 
 
+// Returns a function declaration if e calls a function
+// with virtual parameters. Otherwise, returns nullptr.
+inline Function_decl const*
+calls_multimethod(Call_expr const* e)
+{
+  if (Decl_expr const* d = as<Decl_expr>(e->target()))
+    if (Function_decl const* f = as<Function_decl>(d->declaration()))
+      if (f->virtual_parameters())
+        return f;
+  return nullptr;
+}
+
+
 } // namespace
 
 
@@ -543,32 +655,56 @@ Generator::gen(Call_expr const* e)
   // where n is the offset of the f in the virtual table
   // of x's type.
   //
+  // The object x is generated once. Its virtual table is
+  // found through the same value that is passed as the
+  // first argument.
+  //
+  // If the target of the call is known statically (see
+  // the devirtualize module), call it directly. The
+  // overrider is cast to the type of the called method,
+  // since its implicit object parameter may differ.
+  //
+  // A call to a multimethod is dispatched through its
+  // dispatch table (see the dispatch module).
+  //
   // TODO: Consider representing virtual calls separately
   // within the AST. That would help simplify the code
   // generation a bit.
-  //
-  // TODO: If x refers to a variable of non-reference type,
-  // then we can call the method directly, since x's dynamic
-  // type is known.
-  llvm::Value* fn;
+  llvm::Value* fn = nullptr;
+  std::vector<llvm::Value*> args;
   if (Method_decl const* m = calls_virtual_method(e)) {
-    Expr_seq const& args = e->arguments();
+    Expr const* obj = e->arguments().front();
+    for (Expr const* a : e->arguments())
+      args.push_back(gen(a));
+    if (Decl const* f = devirt(m, obj)) {
+      if (auto const* bind = stack.lookup(f)) {
+        llvm::Type* t = llvm::PointerType::getUnqual(get_type(m->type()));
+        fn = build.CreateBitCast(bind->second, t);
+      }
+    }
 
-    // Get (and load) the virtual function pointer.
-    llvm::Value* vptr = gen_vptr(args.front());
-    llvm::Value* a[] = {
-      build.getInt32(0),
-      build.getInt32(m->vtable_entry())
-    };
-    llvm::Value* vfpp = build.CreateInBoundsGEP(vptr, a);
-    fn = build.CreateLoad(vfpp);
+    // Otherwise, get (and load) the virtual function pointer.
+    if (!fn) {
+      Record_type const* t = cast<Record_type>(obj->type()->nonref());
+      llvm::Value* vptr = gen_vptr(t->declaration(), args.front());
+      llvm::Value* a[] = {
+        build.getInt32(0),
+        build.getInt32(m->vtable_entry() + 1)
+      };
+      llvm::Value* vfpp = build.CreateInBoundsGEP(vptr, a);
+      fn = build.CreateLoad(vfpp);
+    }
   } else {
-    fn = gen(e->target());
+    Function_decl const* f = calls_multimethod(e);
+    Dispatch_table const* t = f ? dispatch.table(f) : nullptr;
+    if (t) {
+      fn = gen_dispatch(f, t, e->arguments(), args);
+    } else {
+      fn = gen(e->target());
+      for (Expr const* a : e->arguments())
+        args.push_back(gen(a));
+    }
   }
-
-  std::vector<llvm::Value*> args;
-  for (Expr const* a : e->arguments())
-    args.push_back(gen(a));
   return build.CreateCall(fn, args);
 }
 
@@ -615,11 +751,162 @@ Generator::gen(Index_expr const* e)
 {
   llvm::Value* arr = gen(e->array());
   llvm::Value* ix = gen(e->index());
+
+  // Index with 64-bit values so that the address
+  // computation does not need to be widened inside
+  // loops. The index is within the bounds of the array,
+  // either by check or by proof, so the address is
+  // inbounds.
+  if (ix->getType() != build.getInt64Ty())
+    ix = build.CreateSExt(ix, build.getInt64Ty());
+  if (checked && !e->in_bounds())
+    gen_bounds_check(e, ix);
   std::vector<llvm::Value*> args {
-    build.getInt32(0), // 0th element from base
+    build.getInt64(0), // 0th element from base
     ix                 // requested index
   };
-  return build.CreateGEP(arr, args);
+  return build.CreateInBoundsGEP(arr, args);
+}
+
+
+// A vector with one initializer copies it into each
+// element. Otherwise, each element is inserted in turn.
+llvm::Value*
+Generator::gen(Vector_expr const* e)
+{
+  Vector_type const* t = cast<Vector_type>(e->type());
+  Expr_seq const& es = e->elements();
+  if (e->is_splat())
+    return build.CreateVectorSplat(t->size(), gen(es[0]));
+  llvm::Value* v = llvm::UndefValue::get(get_type(t));
+  for (std::size_t i = 0; i < es.size(); ++i)
+    v = build.CreateInsertElement(v, gen(es[i]), build.getInt32(i));
+  return v;
+}
+
+
+namespace
+{
+
+// Returns the shuffle mask selecting the n elements
+// starting at first.
+llvm::Constant*
+get_mask(llvm::IRBuilder<>& build, int first, int n)
+{
+  std::vector<llvm::Constant*> ix;
+  for (int i = 0; i < n; ++i)
+    ix.push_back(build.getInt32(first + i));
+  return llvm::ConstantVector::get(ix);
+}
+
+
+// Combine a and b, which are elements or vectors of
+// elements of type t, by the operator of the reduction r.
+llvm::Value*
+combine(llvm::IRBuilder<>& build, Reduction r, Type const* t, llvm::Value* a, llvm::Value* b)
+{
+  bool fp = is<Float_type>(t) || is<Double_type>(t);
+  bool u = is<Integer_type>(t) && !cast<Integer_type>(t)->is_signed();
+  switch (r) {
+    case sum_reduction:
+      return fp ? build.CreateFAdd(a, b) : build.CreateAdd(a, b);
+    case product_reduction:
+      return fp ? build.CreateFMul(a, b) : build.CreateMul(a, b);
+    case min_reduction: {
+      llvm::Value* c = fp ? build.CreateFCmpOLT(b, a)
+                     : u ? build.CreateICmpULT(b, a)
+                     : build.CreateICmpSLT(b, a);
+      return build.CreateSelect(c, b, a);
+    }
+    case max_reduction: {
+      llvm::Value* c = fp ? build.CreateFCmpOLT(a, b)
+                     : u ? build.CreateICmpULT(a, b)
+                     : build.CreateICmpSLT(a, b);
+      return build.CreateSelect(c, b, a);
+    }
+    case all_reduction:
+      return build.CreateAnd(a, b);
+    case any_reduction:
+      return build.CreateOr(a, b);
+  }
+  lingo_unreachable();
+}
+
+
+} // namespace
+
+
+llvm::Value*
+Generator::gen(Shuffle_expr const* e)
+{
+  llvm::Value* v = gen(e->vector());
+  std::vector<llvm::Constant*> ix;
+  for (std::size_t i = 0; i < e->indexes().size(); ++i)
+    ix.push_back(build.getInt32(e->index(i)));
+  llvm::Value* u = llvm::UndefValue::get(v->getType());
+  return build.CreateShuffleVector(v, u, llvm::ConstantVector::get(ix));
+}
+
+
+// While the number of elements is even, the lower half
+// of the vector is combined with the upper half. The
+// remaining elements are combined in order. The
+// evaluator reduces vectors in the same order.
+llvm::Value*
+Generator::gen(Reduce_expr const* e)
+{
+  Vector_type const* t = cast<Vector_type>(e->operand()->type());
+  Reduction r = e->reduction();
+  llvm::Value* v = gen(e->operand());
+  int n = t->size();
+  while (n > 1 && n % 2 == 0) {
+    n /= 2;
+    llvm::Value* u = llvm::UndefValue::get(v->getType());
+    llvm::Value* lo = build.CreateShuffleVector(v, u, get_mask(build, 0, n));
+    llvm::Value* hi = build.CreateShuffleVector(v, u, get_mask(build, n, n));
+    v = combine(build, r, t->type(), lo, hi);
+  }
+  llvm::Value* x = build.CreateExtractElement(v, build.getInt32(0));
+  for (int i = 1; i < n; ++i)
+    x = combine(build, r, t->type(), x, build.CreateExtractElement(v, build.getInt32(i)));
+  return x;
+}
+
+
+// Branch to the trap block of the current function if
+// the index ix is not within the bounds of the array
+// indexed by e. Negative indexes compare as large
+// unsigned values.
+void
+Generator::gen_bounds_check(Index_expr const* e, llvm::Value* ix)
+{
+  Type const* t = e->array()->type()->nonref();
+  int n;
+  if (Vector_type const* v = as<Vector_type>(t))
+    n = v->size();
+  else
+    n = cast<Array_type>(t)->size();
+  llvm::Value* ok = build.CreateICmpULT(ix, build.getInt64(n));
+  llvm::BasicBlock* pass = llvm::BasicBlock::Create(cxt, "index.ok", fn);
+  llvm::MDNode* weights = llvm::MDBuilder(cxt).createBranchWeights(1 << 20, 1);
+  build.CreateCondBr(ok, pass, get_trap_block(), weights);
+  build.SetInsertPoint(pass);
+}
+
+
+// Returns the block that aborts the current function
+// when a check fails. The block is shared by all checks
+// in the function.
+llvm::BasicBlock*
+Generator::get_trap_block()
+{
+  if (!trap) {
+    trap = llvm::BasicBlock::Create(cxt, "trap", fn);
+    llvm::IRBuilder<> tmp(trap);
+    tmp.CreateCall(llvm::Intrinsic::getDeclaration(mod, llvm::Intrinsic::trap));
+    tmp.CreateUnreachable();
+  }
+  return trap;
 }
 
 
@@ -698,6 +985,10 @@ Generator::gen_init(llvm::Value* ptr, Default_init const* e)
   if (is_aggregate(t))
     init = llvm::ConstantAggregateZero::get(type);
 
+  // Vectors are zero initialized.
+  if (is<Vector_type>(t))
+    init = llvm::ConstantAggregateZero::get(type);
+
   if (init != nullptr) {
     build.CreateStore(init, ptr);
     return;
@@ -747,7 +1038,10 @@ Generator::gen(Stmt const* s)
     void operator()(Return_stmt const* s) { g.gen(s); }
     void operator()(If_then_stmt const* s) { g.gen(s); }
     void operator()(If_else_stmt const* s) { g.gen(s); }
+    void operator()(Switch_stmt const* s) { g.gen(s); }
     void operator()(While_stmt const* s) { g.gen(s); }
+    void operator()(For_stmt const* s) { g.gen(s); }
+    void operator()(Parallel_for_stmt const* s) { g.gen(s); }
     void operator()(Break_stmt const* s) { g.gen(s); }
     void operator()(Continue_stmt const* s) { g.gen(s); }
     void operator()(Expression_stmt const* s) { g.gen(s); }
@@ -851,6 +1145,60 @@ Generator::gen(If_else_stmt const* s)
 }
 
 
+// A switch statement is emitted as a switch instruction,
+// which is lowered to a jump table, a binary search, or
+// a sequence of compares, depending on the labels. Each
+// case branches to the end of the switch, which is also
+// the target of break statements. Continue statements
+// still branch to the latch of the enclosing loop.
+void
+Generator::gen(Switch_stmt const* s)
+{
+  Loop_sentinel loop(*this);
+
+  llvm::Value* cond = gen(s->condition());
+  bottom = llvm::BasicBlock::Create(cxt, "switch.done", fn);
+  llvm::BasicBlock* other = bottom;
+  if (s->default_case())
+    other = llvm::BasicBlock::Create(cxt, "switch.default", fn, bottom);
+
+  std::size_t n = 0;
+  for (Switch_case const& k : s->cases())
+    n += k.labels().size();
+  llvm::SwitchInst* sw = build.CreateSwitch(cond, other, n);
+
+  // Emit the cases.
+  llvm::IntegerType* type = llvm::cast<llvm::IntegerType>(cond->getType());
+  for (Switch_case const& k : s->cases()) {
+    llvm::BasicBlock* b = llvm::BasicBlock::Create(cxt, "switch.case", fn, other);
+    for (Expr const* e : k.labels()) {
+      Integer_value v = cast<Literal_expr>(e)->value().get_integer();
+      sw->addCase(llvm::ConstantInt::get(type, v, true), b);
+    }
+    build.SetInsertPoint(b);
+    gen(k.body());
+    if (!build.GetInsertBlock()->getTerminator())
+      build.CreateBr(bottom);
+  }
+
+  // Emit the default case.
+  if (s->default_case()) {
+    build.SetInsertPoint(other);
+    gen(s->default_case());
+    if (!build.GetInsertBlock()->getTerminator())
+      build.CreateBr(bottom);
+  }
+
+  build.SetInsertPoint(bottom);
+}
+
+
+// Loops are emitted in rotated form: the condition is
+// tested once before entering the loop and again in a
+// single latch block at the bottom of the body. This is
+// the form expected by the loop optimizers. The latch is
+// the target of continue statements, and its back edge
+// carries the loop's metadata.
 void
 Generator::gen(While_stmt const* s)
 {
@@ -859,28 +1207,295 @@ Generator::gen(While_stmt const* s)
   Loop_sentinel loop(*this);
 
   // Create the new loop blocks.
-  top = llvm::BasicBlock::Create(cxt, "while.top", fn);
+  top = llvm::BasicBlock::Create(cxt, "while.latch", fn);
   bottom = llvm::BasicBlock::Create(cxt, "while.bottom", fn);
-  llvm::BasicBlock* body = llvm::BasicBlock::Create(cxt, "while.body", fn, bottom);
-  build.CreateBr(top);
+  llvm::BasicBlock* body = llvm::BasicBlock::Create(cxt, "while.body", fn, top);
+
+  // Emit the guard.
+  llvm::Value* guard = gen(s->condition());
+  build.CreateCondBr(guard, body, bottom);
 
-  // Emit the condition test.
+  // Emit the loop body.
+  build.SetInsertPoint(body);
+  gen(s->body());
+  if (!build.GetInsertBlock()->getTerminator())
+    build.CreateBr(top);
+
+  // Emit the latch.
   build.SetInsertPoint(top);
   llvm::Value* cond = gen(s->condition());
-  build.CreateCondBr(cond, body, bottom);
+  llvm::BranchInst* br = build.CreateCondBr(cond, body, bottom);
+  br->setMetadata("llvm.loop", gen_loop_id(s->vectorize()));
 
-  // Emit the loop body.
+  // Emit the bottom block.
+  build.SetInsertPoint(bottom);
+}
+
+
+// A counted loop is emitted in canonical form. The trip
+// count n is computed once, and the induction variable k
+// counts from 0 to n by 1:
+//
+//    preheader:
+//      br body
+//    body:
+//      k = phi [0, preheader], [k1, latch]
+//      x = e1 + k
+//      ...
+//    latch:
+//      k1 = k + 1
+//      br (k1 != n), body, bottom
+//
+// The preheader is guarded by e1 < e2, unless the trip
+// count is known to be positive. The latch is the target
+// of continue statements. The loop variable has its own
+// storage, which is set from k in each iteration.
+void
+Generator::gen(For_stmt const* s)
+{
+  Loop_sentinel loop(*this);
+
+  // Create the loop variable at the beginning of the
+  // function, like other locals.
+  Variable_decl const* var = s->variable();
+  llvm::BasicBlock& b = fn->getEntryBlock();
+  llvm::IRBuilder<> tmp(&b, b.begin());
+  llvm::Type* type = get_type(var->type());
+  llvm::Value* x = tmp.CreateAlloca(type, nullptr, var->name()->spelling());
+  stack.top().bind(var, x);
+
+  // Create the new loop blocks.
+  top = llvm::BasicBlock::Create(cxt, "for.latch", fn);
+  bottom = llvm::BasicBlock::Create(cxt, "for.bottom", fn);
+  llvm::BasicBlock* pre = llvm::BasicBlock::Create(cxt, "for.preheader", fn, top);
+  llvm::BasicBlock* body = llvm::BasicBlock::Create(cxt, "for.body", fn, top);
+
+  // Emit the guard and the preheader.
+  llvm::Value* lo = gen(s->lower());
+  llvm::Value* hi = gen(s->upper());
+  if (s->trip_count() > 0)
+    build.CreateBr(pre);
+  else
+    build.CreateCondBr(build.CreateICmpSLT(lo, hi), pre, bottom);
+  build.SetInsertPoint(pre);
+  llvm::Value* n = build.CreateSub(hi, lo, "n");
+  build.CreateBr(body);
+
+  // Emit the loop body. The values of x are in [e1, e2),
+  // so computing x does not overflow.
   build.SetInsertPoint(body);
+  llvm::PHINode* k = build.CreatePHI(type, 2, "k");
+  k->addIncoming(llvm::ConstantInt::get(type, 0), pre);
+  build.CreateStore(build.CreateNSWAdd(lo, k), x);
   gen(s->body());
-  body = build.GetInsertBlock();
-  if (!body->getTerminator())
+  if (!build.GetInsertBlock()->getTerminator())
     build.CreateBr(top);
 
+  // Emit the latch. The count is unsigned, so that the
+  // loop runs the full range even when e2 - e1 overflows.
+  build.SetInsertPoint(top);
+  llvm::Value* k1 = build.CreateNUWAdd(k, llvm::ConstantInt::get(type, 1), "k.next");
+  k->addIncoming(k1, top);
+  llvm::BranchInst* br = build.CreateCondBr(build.CreateICmpNE(k1, n), body, bottom);
+  br->setMetadata("llvm.loop", gen_loop_id(s->vectorize()));
+
   // Emit the bottom block.
   build.SetInsertPoint(bottom);
 }
 
 
+// Returns the loop identifier attached to the back edge
+// of the loop. The identifier is a distinct node whose
+// first operand refers to itself. When the loop has the
+// vectorize hint, the identifier also requests that the
+// loop be vectorized.
+llvm::MDNode*
+Generator::gen_loop_id(bool vectorize)
+{
+  std::vector<llvm::Metadata*> ops { nullptr };
+  if (vectorize) {
+    llvm::Metadata* hint[] {
+      llvm::MDString::get(cxt, "llvm.loop.vectorize.enable"),
+      llvm::ConstantAsMetadata::get(build.getTrue())
+    };
+    ops.push_back(llvm::MDNode::get(cxt, hint));
+  }
+  llvm::MDNode* id = llvm::MDNode::getDistinct(cxt, ops);
+  id->replaceOperandWith(0, id);
+  return id;
+}
+
+
+// A parallel loop is outlined: its body becomes an
+// internal function that runs the iterations in [lo, hi),
+//
+//    void f.parallel(i8* env, i64 lo, i64 hi)
+//
+// and the loop is replaced by a call to the runtime,
+// which divides the iterations among its threads (see
+// runtime/parallel.c). The locals and parameters of the
+// enclosing function are passed by address in env, which
+// is a struct allocated in the caller's frame.
+void
+Generator::gen(Parallel_for_stmt const* s)
+{
+  // Collect the variables of the enclosing function, or
+  // of the enclosing loop bodies. The bottom of the stack
+  // holds the module's declarations, which are visible to
+  // the outlined function anyway.
+  std::vector<Decl const*> vars;
+  std::vector<llvm::Type*> types;
+  for (std::size_t i = 1; i < stack.size(); ++i) {
+    for (auto const& bind : *stack[i]) {
+      if (llvm::isa<llvm::GlobalValue>(bind.second))
+        continue;
+      if (stack.lookup(bind.first)->second != bind.second)
+        continue;
+      vars.push_back(bind.first);
+      types.push_back(bind.second->getType());
+    }
+  }
+  llvm::StructType* type = llvm::StructType::get(cxt, types);
+
+  // Store the addresses of the variables in the
+  // environment.
+  llvm::BasicBlock& b = fn->getEntryBlock();
+  llvm::IRBuilder<> tmp(&b, b.begin());
+  llvm::Value* env = tmp.CreateAlloca(type, nullptr, "env");
+  for (std::size_t i = 0; i < vars.size(); ++i) {
+    llvm::Value* a[] = { build.getInt32(0), build.getInt32(i) };
+    build.CreateStore(stack.lookup(vars[i])->second, build.CreateInBoundsGEP(env, a));
+  }
+
+  llvm::Value* lo = build.CreateSExt(gen(s->lower()), build.getInt64Ty());
+  llvm::Value* hi = build.CreateSExt(gen(s->upper()), build.getInt64Ty());
+  llvm::Function* body = gen_parallel_body(s, vars, type);
+  llvm::Value* args[] {
+    body,
+    build.CreateBitCast(env, build.getInt8PtrTy()),
+    lo,
+    hi
+  };
+  build.CreateCall(get_parallel_runtime(), args);
+}
+
+
+// Generate the outlined body of the parallel loop s. The
+// variables in vars are loaded from the environment, whose
+// type is env, and bound over those of the caller. The
+// iterations are a rotated loop, like a while loop.
+llvm::Function*
+Generator::gen_parallel_body(Parallel_for_stmt const* s, std::vector<Decl const*> const& vars, llvm::StructType* env)
+{
+  // Save the state of the enclosing function.
+  Loop_sentinel loop(*this);
+  llvm::Function*   fn0 = fn;
+  llvm::Value*      ret0 = ret;
+  llvm::BasicBlock* entry0 = entry;
+  llvm::BasicBlock* exit0 = exit;
+  llvm::BasicBlock* trap0 = trap;
+  llvm::BasicBlock* insert0 = build.GetInsertBlock();
+
+  llvm::Type* parms[] {
+    build.getInt8PtrTy(),
+    build.getInt64Ty(),
+    build.getInt64Ty()
+  };
+  llvm::FunctionType* ftype = llvm::FunctionType::get(build.getVoidTy(), parms, false);
+  fn = llvm::Function::Create(
+    ftype,
+    llvm::Function::InternalLinkage,
+    fn0->getName() + ".parallel",
+    mod);
+  auto ai = fn->arg_begin();
+  llvm::Value* ptr = &*ai++;
+  llvm::Value* lo = &*ai++;
+  llvm::Value* hi = &*ai++;
+
+  entry = llvm::BasicBlock::Create(cxt, "entry", fn);
+  exit = llvm::BasicBlock::Create(cxt, "exit", fn);
+  ret = nullptr;
+  trap = nullptr;
+  build.SetInsertPoint(entry);
+
+  // Rebind the variables of the caller.
+  Symbol_sentinel scope(*this);
+  ptr = build.CreateBitCast(ptr, llvm::PointerType::getUnqual(env));
+  for (std::size_t i = 0; i < vars.size(); ++i) {
+    llvm::Value* a[] = { build.getInt32(0), build.getInt32(i) };
+    stack.top().bind(vars[i], build.CreateLoad(build.CreateInBoundsGEP(ptr, a)));
+  }
+
+  // The counter is separate from the loop variable, so
+  // that the body sees an int.
+  Variable_decl const* var = s->variable();
+  llvm::Value* n = build.CreateAlloca(build.getInt64Ty(), nullptr, "n");
+  llvm::Value* x = build.CreateAlloca(get_type(var->type()), nullptr, var->name()->spelling());
+  stack.top().bind(var, x);
+  build.CreateStore(lo, n);
+
+  top = llvm::BasicBlock::Create(cxt, "parallel.latch", fn);
+  bottom = exit;
+  llvm::BasicBlock* body = llvm::BasicBlock::Create(cxt, "parallel.body", fn, top);
+  build.CreateCondBr(build.CreateICmpSLT(lo, hi), body, bottom);
+
+  // Emit the loop body.
+  build.SetInsertPoint(body);
+  llvm::Value* i = build.CreateLoad(n);
+  build.CreateStore(build.CreateTrunc(i, x->getType()->getPointerElementType()), x);
+  gen(s->body());
+  if (!build.GetInsertBlock()->getTerminator())
+    build.CreateBr(top);
+
+  // Emit the latch.
+  build.SetInsertPoint(top);
+  llvm::Value* next = build.CreateAdd(build.CreateLoad(n), build.getInt64(1));
+  build.CreateStore(next, n);
+  build.CreateCondBr(build.CreateICmpSLT(next, hi), body, bottom);
+
+  exit->moveAfter(top);
+  build.SetInsertPoint(exit);
+  build.CreateRetVoid();
+
+  // Restore the enclosing function.
+  llvm::Function* result = fn;
+  fn = fn0;
+  ret = ret0;
+  entry = entry0;
+  exit = exit0;
+  trap = trap0;
+  build.SetInsertPoint(insert0);
+  return result;
+}
+
+
+// Returns the declaration of the runtime function that
+// runs parallel loops.
+//
+//    void __beaker_parallel_for(void (*)(i8*, i64, i64), i8*, i64, i64)
+llvm::Function*
+Generator::get_parallel_runtime()
+{
+  char const* name = "__beaker_parallel_for";
+  if (llvm::Function* f = mod->getFunction(name))
+    return f;
+  llvm::Type* parms[] {
+    build.getInt8PtrTy(),
+    build.getInt64Ty(),
+    build.getInt64Ty()
+  };
+  llvm::FunctionType* body = llvm::FunctionType::get(build.getVoidTy(), parms, false);
+  llvm::Type* args[] {
+    llvm::PointerType::getUnqual(body),
+    build.getInt8PtrTy(),
+    build.getInt64Ty(),
+    build.getInt64Ty()
+  };
+  llvm::FunctionType* type = llvm::FunctionType::get(build.getVoidTy(), args, false);
+  return llvm::Function::Create(type, llvm::Function::ExternalLinkage, name, mod);
+}
+
+
 // Branch to the bottom of the current loop.
 void
 Generator::gen(Break_stmt const* s)
@@ -889,7 +1504,7 @@ Generator::gen(Break_stmt const* s)
 }
 
 
-// Branch to the top of the current loop.
+// Branch to the latch of the current loop.
 void
 Generator::gen(Continue_stmt const* s)
 {
@@ -990,8 +1605,11 @@ Generator::gen_global(Variable_decl const* d)
   // FIXME: If the initializer can be reduced to a value,
   // then generate that constant. If not, we need dynamic
   // initialization of global variables.
+  //
+  // Foreign and imported variables are defined in
+  // other modules.
   llvm::Constant* init = nullptr;
-  if (!d->is_foreign())
+  if (!d->is_foreign() && !d->is_imported())
     init = llvm::Constant::getNullValue(type);
 
 
@@ -1079,6 +1697,7 @@ Generator::gen(Function_decl const* d)
   // Build the entry and exit blocks for the function.
   entry = llvm::BasicBlock::Create(cxt, "entry", fn);
   exit = llvm::BasicBlock::Create(cxt, "exit");
+  trap = nullptr;
   build.SetInsertPoint(entry);
 
   // Build the return value.
@@ -1197,10 +1816,18 @@ Generator::gen(Module_decl const* d)
   assert(!mod);
   mod = new llvm::Module("a.ll", cxt);
 
+  // Collect the record hierarchies of the module.
+  devirt.add(d);
+  dispatch.add(d);
+
   // Generate all top-level declarations.
   for (Decl const* d1 : d->declarations())
     gen(d1);
 
+  // Fill the dispatch tables now that every function
+  // has been declared.
+  gen_dispatch_entries();
+
   // TODO: Make a second pass to generate global
   // constructors for initializers.
 }
@@ -1215,9 +1842,12 @@ Generator::gen_vtable(Record_decl const* d)
   // of character pointers. The call expression re-casts
   // to the appropriate static type.
   //
+  // The first entry is the class id of the record, which
+  // is used to index dispatch tables.
+  //
   // TODO: The type is unnamed. Does this actually matter?
-  std::vector<llvm::Type*> types;
-  std::vector<llvm::Constant*> values;
+  std::vector<llvm::Type*> types { build.getInt32Ty() };
+  std::vector<llvm::Constant*> values { build.getInt32(dispatch.id(d)) };
   for (Decl const* d : vtbl) {
     llvm::Type* t = llvm::PointerType::getUnqual(get_type(d->type()));
     types.push_back(t);
@@ -1235,6 +1865,11 @@ Generator::gen_vtable(Record_decl const* d)
   llvm::StructType* vtt = llvm::StructType::create(cxt, types, vttn);
   llvm::Constant* vti = llvm::ConstantStruct::get(vtt, values);
 
+  // The vtable of an imported record is defined by the
+  // module that exports it.
+  if (d->is_imported())
+    vti = nullptr;
+
   // Generate the vtable global.
   llvm::GlobalVariable* ret = new llvm::GlobalVariable(
     *mod,                                  // owning module
@@ -1249,21 +1884,6 @@ Generator::gen_vtable(Record_decl const* d)
 }
 
 
-// Generate an expression that accesses the virtual
-// table within the object. Here, expr is the first
-// argument of the function call.
-llvm::Value*
-Generator::gen_vptr(Expr const* e)
-{
-  Decl_expr const* d = cast<Decl_expr>(e);
-  llvm::Value* obj = gen(d);
-
-  Record_type const* t = cast<Record_type>(d->type()->nonref());
-  Record_decl const* r = t->declaration();
-  return gen_vptr(r, obj);
-}
-
-
 // Returns the vtable pointer.
 llvm::Value*
 Generator::gen_vptr(Record_decl const* r, llvm::Value* obj)
@@ -1293,6 +1913,119 @@ Generator::gen_vref(Record_decl const* r, llvm::Value* obj)
 }
 
 
+// Generate the selection of the target of a call to the
+// multimethod f. The class id of each virtual argument
+// selects a column, and the columns select an entry in
+// the dispatch table.
+//
+// The arguments are generated into vals. Each object is
+// generated once, and its class id is loaded through the
+// same value that is passed (or loaded) as the argument.
+llvm::Value*
+Generator::gen_dispatch(Function_decl const* f, Dispatch_table const* t, Expr_seq const& args, std::vector<llvm::Value*>& vals)
+{
+  // Generate the arguments, remembering the object of
+  // each virtual argument.
+  std::vector<llvm::Value*> objs(args.size(), nullptr);
+  for (int n : t->parms) {
+    Expr const* arg = args[n];
+    if (Value_conv const* c = as<Value_conv>(arg))
+      arg = c->source();
+    objs[n] = gen(arg);
+  }
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    if (!objs[i])
+      vals.push_back(gen(args[i]));
+    else if (is<Value_conv>(args[i]))
+      vals.push_back(build.CreateLoad(objs[i]));
+    else
+      vals.push_back(objs[i]);
+  }
+
+  Dispatch_globals& g = get_dispatch_globals(t);
+  llvm::Value* ent = build.getInt32(0);
+  for (std::size_t k = 0; k < t->parms.size(); ++k) {
+    int n = t->parms[k];
+    Record_type const* r = cast<Record_type>(args[n]->type()->nonref());
+    llvm::Value* vptr = gen_vptr(r->declaration(), objs[n]);
+    llvm::Value* z[] = { build.getInt32(0), build.getInt32(0) };
+    llvm::Value* id = build.CreateLoad(build.CreateInBoundsGEP(vptr, z));
+    llvm::Value* a[] = { build.getInt32(0), id };
+    llvm::Value* col = build.CreateLoad(build.CreateInBoundsGEP(g.columns[k], a));
+    llvm::Value* off = build.CreateMul(col, build.getInt32(t->strides[k]));
+    ent = build.CreateAdd(ent, off);
+  }
+  llvm::Value* a[] = { build.getInt32(0), ent };
+  llvm::Value* p = build.CreateLoad(build.CreateInBoundsGEP(g.entries, a));
+  return build.CreateBitCast(p, llvm::PointerType::getUnqual(get_type(f->type())));
+}
+
+
+// Returns the globals of the dispatch table, creating
+// them as needed. The entries refer to functions that
+// may not have been generated yet, so they are not
+// initialized until the end of the module.
+Dispatch_globals&
+Generator::get_dispatch_globals(Dispatch_table const* t)
+{
+  auto iter = dtables.find(t);
+  if (iter != dtables.end())
+    return iter->second;
+
+  String base = "_DT_" + mangle(t->family.front());
+  Dispatch_globals g;
+  for (std::size_t k = 0; k < t->columns.size(); ++k) {
+    std::vector<llvm::Constant*> cols;
+    for (int c : t->columns[k])
+      cols.push_back(build.getInt32(c));
+    llvm::ArrayType* type = llvm::ArrayType::get(build.getInt32Ty(), cols.size());
+    g.columns.push_back(new llvm::GlobalVariable(
+      *mod,
+      type,
+      true,
+      llvm::GlobalVariable::InternalLinkage,
+      llvm::ConstantArray::get(type, cols),
+      base + "_C" + std::to_string(k)
+    ));
+  }
+
+  llvm::ArrayType* type = llvm::ArrayType::get(build.getInt8PtrTy(), t->entries.size());
+  g.entries = new llvm::GlobalVariable(
+    *mod,
+    type,
+    true,
+    llvm::GlobalVariable::InternalLinkage,
+    nullptr,
+    base
+  );
+  return dtables.emplace(t, g).first->second;
+}
+
+
+// Initialize the entries of each dispatch table. A missing
+// or ambiguous target is a null pointer.
+void
+Generator::gen_dispatch_entries()
+{
+  for (auto& x : dtables) {
+    Dispatch_table const* t = x.first;
+    llvm::GlobalVariable* g = x.second.entries;
+    llvm::PointerType* type = build.getInt8PtrTy();
+    std::vector<llvm::Constant*> ents;
+    for (Function_decl const* f : t->entries) {
+      if (f) {
+        llvm::Function* fn = llvm::cast<llvm::Function>(stack.lookup(f)->second);
+        ents.push_back(llvm::ConstantExpr::getBitCast(fn, type));
+      } else {
+        ents.push_back(llvm::ConstantPointerNull::get(type));
+      }
+    }
+    llvm::ArrayType* at = llvm::ArrayType::get(type, ents.size());
+    g->setInitializer(llvm::ConstantArray::get(at, ents));
+  }
+}
+
+
 llvm::Module*
 Generator::operator()(Decl const* d)
 {
@@ -8,6 +8,8 @@
 
 #include <beaker/prelude.hpp>
 #include <beaker/environment.hpp>
+#include <beaker/devirtualize.hpp>
+#include <beaker/dispatch.hpp>
 
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/IRBuilder.h>
@@ -35,10 +37,15 @@ using Symbol_stack = Stack<Symbol_env>;
 using Type_env = Environment<Decl const*, llvm::Type*>;
 
 
+// Associates types with their lowered LLVM types.
+// Types are unique, so they are keyed by address.
+using Type_map = std::unordered_map<Type const*, llvm::Type*>;
+
+
 // A global string table, used to unify string
-// declarations. This maps strings to global string
-// variables.
-using String_env = Environment<String, llvm::Value*>;
+// declarations. This maps strings in the string pool
+// to global string variables.
+using String_env = Environment<String const*, llvm::Value*>;
 
 
 // Associates record declarations with their vtables.
@@ -46,9 +53,24 @@ using String_env = Environment<String, llvm::Value*>;
 using Vtable_map = std::unordered_map<Decl const*, llvm::GlobalVariable*>;
 
 
+// The globals that hold the dispatch table of a
+// multimethod: one array of columns for each virtual
+// parameter, indexed by class id, and an array of
+// entries.
+struct Dispatch_globals
+{
+  std::vector<llvm::GlobalVariable*> columns;
+  llvm::GlobalVariable*              entries;
+};
+
+
+// Associates dispatch tables with their globals.
+using Dispatch_global_map = std::unordered_map<Dispatch_table const*, Dispatch_globals>;
+
+
 struct Generator
 {
-  Generator();
+  explicit Generator(bool = false);
 
   llvm::Module* operator()(Decl const*);
 
@@ -63,6 +85,7 @@ struct Generator
   llvm::Type* get_type(Double_type const*);
   llvm::Type* get_type(Function_type const*);
   llvm::Type* get_type(Array_type const*);
+  llvm::Type* get_type(Vector_type const*);
   llvm::Type* get_type(Block_type const*);
   llvm::Type* get_type(Reference_type const*);
   llvm::Type* get_type(Record_type const*);
@@ -92,6 +115,9 @@ struct Generator
   llvm::Value* gen(Field_expr const*);
   llvm::Value* gen(Method_expr const*);
   llvm::Value* gen(Index_expr const*);
+  llvm::Value* gen(Vector_expr const*);
+  llvm::Value* gen(Shuffle_expr const*);
+  llvm::Value* gen(Reduce_expr const*);
   llvm::Value* gen(Value_conv const*);
   llvm::Value* gen(Block_conv const*);
   llvm::Value* gen(Base_conv const*);
@@ -110,7 +136,10 @@ struct Generator
   void gen(Return_stmt const*);
   void gen(If_then_stmt const*);
   void gen(If_else_stmt const*);
+  void gen(Switch_stmt const*);
   void gen(While_stmt const*);
+  void gen(For_stmt const*);
+  void gen(Parallel_for_stmt const*);
   void gen(Break_stmt const*);
   void gen(Continue_stmt const*);
   void gen(Expression_stmt const*);
@@ -129,10 +158,21 @@ struct Generator
   void gen_global(Variable_decl const*);
 
   llvm::Value* gen_vtable(Record_decl const*);
-  llvm::Value* gen_vptr(Expr const*);
   llvm::Value* gen_vptr(Record_decl const*, llvm::Value*);
   llvm::Value* gen_vref(Record_decl const*, llvm::Value*);
 
+  llvm::Value*      gen_dispatch(Function_decl const*, Dispatch_table const*, Expr_seq const&, std::vector<llvm::Value*>&);
+  Dispatch_globals& get_dispatch_globals(Dispatch_table const*);
+  void              gen_dispatch_entries();
+
+  llvm::MDNode* gen_loop_id(bool);
+
+  llvm::Function* gen_parallel_body(Parallel_for_stmt const*, std::vector<Decl const*> const&, llvm::StructType*);
+  llvm::Function* get_parallel_runtime();
+
+  void              gen_bounds_check(Index_expr const*, llvm::Value*);
+  llvm::BasicBlock* get_trap_block();
+
   llvm::LLVMContext cxt;
   llvm::IRBuilder<> build;
 
@@ -144,23 +184,33 @@ struct Generator
   llvm::Value*      ret;
   llvm::BasicBlock* entry;  // Function entry
   llvm::BasicBlock* exit;   // Function exit
-  llvm::BasicBlock* top;    // Loop top
+  llvm::BasicBlock* top;    // Loop latch
   llvm::BasicBlock* bottom; // Loop bottom
+  llvm::BasicBlock* trap;   // Failed checks
+
+  // Options.
+  bool checked; // Check array indexes
 
   // Environment.
   Symbol_stack      stack;
   Type_env          types;
+  Type_map          lowered;
   String_env        strings;
   Vtable_map        vtables;
+  Devirtualizer     devirt;
+  Dispatch_map      dispatch;
+  Dispatch_global_map dtables;
 
   struct Symbol_sentinel;
   struct Loop_sentinel;
 };
 
 
+// When c is true, array indexes that are not known to
+// be in bounds are checked at run time.
 inline
-Generator::Generator()
-  : cxt(), build(cxt), mod(nullptr)
+Generator::Generator(bool c)
+  : cxt(), build(cxt), mod(nullptr), checked(c)
 { }
 
 
@@ -184,8 +234,8 @@ struct Generator::Symbol_sentinel
 
 
 // An RAII class that manages the top and bottom
-// blocks of loops. These are the current jump
-// targets for the break and continue statements.
+// blocks of loops and switches. These are the current
+// jump targets for the break and continue statements.
 struct Generator::Loop_sentinel
 {
   Loop_sentinel(Generator& g)
@@ -0,0 +1,1826 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/image.hpp"
+#include "beaker/type.hpp"
+#include "beaker/expr.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/stmt.hpp"
+#include "beaker/token.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+// An image starts with a magic number and a version,
+// and a checksum of the rest of the image. It is
+// followed by:
+//
+// - the kind and name of each declaration,
+// - the global store,
+// - the contents of each declaration, and
+// - the entry point.
+//
+// Declarations are written in the order in which they
+// are found by walking the module, and refer to each
+// other by their position in that order. Each kind of
+// node is written as a tag followed by its operands.
+//
+// The storage of aggregates and buffers is numbered
+// in the order in which it is written, so values that
+// share storage still share it when loaded. References
+// and buffer elements are written as the number of
+// the storage they refer to and their position within
+// it. The number -1 denotes the global store.
+//
+// Integers are written in the representation of the
+// host.
+
+namespace
+{
+
+char const magic[] = { 'B', 'K', 'M', 3 };
+
+
+// Returns the FNV-1a hash of the bytes in [first, last).
+// Each step is a bijection of the hash, so an image
+// that differs in one byte has a different checksum.
+std::uint64_t
+checksum(char const* first, char const* last)
+{
+  std::uint64_t h = 14695981039346656037ull;
+  for (; first != last; ++first) {
+    h ^= std::uint8_t(*first);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+
+enum Decl_tag : std::uint8_t
+{
+  variable_tag,
+  function_tag,
+  parameter_tag,
+  record_tag,
+  field_tag,
+  method_tag,
+  module_tag,
+};
+
+
+enum Type_tag : std::uint8_t
+{
+  no_type,
+  boolean_type,
+  character_type,
+  integer_type,
+  float_type,
+  double_type,
+  function_type,
+  array_type,
+  block_type,
+  reference_type,
+  record_type,
+  vector_type,
+};
+
+
+enum Expr_tag : std::uint8_t
+{
+  no_expr,
+  literal_expr,
+  decl_expr,
+  add_expr,
+  sub_expr,
+  mul_expr,
+  div_expr,
+  rem_expr,
+  neg_expr,
+  pos_expr,
+  eq_expr,
+  ne_expr,
+  lt_expr,
+  gt_expr,
+  le_expr,
+  ge_expr,
+  and_expr,
+  or_expr,
+  not_expr,
+  call_expr,
+  field_expr,
+  method_expr,
+  index_expr,
+  value_conv,
+  block_conv,
+  base_conv,
+  promote_conv,
+  default_init,
+  trivial_init,
+  copy_init,
+  reference_init,
+  vector_expr,
+  shuffle_expr,
+  reduce_expr,
+};
+
+
+enum Stmt_tag : std::uint8_t
+{
+  no_stmt,
+  empty_stmt,
+  block_stmt,
+  assign_stmt,
+  return_stmt,
+  if_then_stmt,
+  if_else_stmt,
+  while_stmt,
+  break_stmt,
+  continue_stmt,
+  expression_stmt,
+  declaration_stmt,
+  parallel_for_stmt,
+  for_stmt,
+  switch_stmt,
+};
+
+
+// Returns the tag of the declaration d.
+Decl_tag
+get_tag(Decl const* d)
+{
+  struct Fn
+  {
+    Decl_tag operator()(Variable_decl const*)  { return variable_tag; }
+    Decl_tag operator()(Function_decl const*)  { return function_tag; }
+    Decl_tag operator()(Parameter_decl const*) { return parameter_tag; }
+    Decl_tag operator()(Record_decl const*)    { return record_tag; }
+    Decl_tag operator()(Field_decl const*)     { return field_tag; }
+    Decl_tag operator()(Method_decl const*)    { return method_tag; }
+    Decl_tag operator()(Module_decl const*)    { return module_tag; }
+  };
+  return apply(d, Fn{});
+}
+
+
+[[noreturn]] void
+unsaveable(char const* what)
+{
+  throw std::runtime_error(format("cannot save {} in an image", what));
+}
+
+
+// -------------------------------------------------------------------------- //
+// Writing
+
+struct Writer
+{
+  using Location = std::pair<int, std::int64_t>;
+
+  Writer(std::ostream&, Symbol_table const&);
+
+  void byte(int n)                          { os.put(char(n)); }
+  void bytes(void const* p, std::size_t n)  { os.write(static_cast<char const*>(p), n); }
+  void word(std::int32_t n)                 { bytes(&n, sizeof(n)); }
+  void size(std::uint64_t n)                { bytes(&n, sizeof(n)); }
+  void string(String const&);
+
+  void collect(Decl const*);
+  void collect(Stmt const*);
+  void locate(Frame const&);
+  void locate(Value const&);
+  int  storage(void const*);
+
+  void ref(Decl const*);
+  void refs(Decl_seq const&);
+  void name(Symbol const*);
+  void type(Type const*);
+  void value(Value const&);
+  void aggregate(Aggregate_value const&);
+  void expr(Expr const*);
+  void stmt(Stmt const*);
+  void decl(Decl const*);
+
+  std::ostream& os;
+
+  // The spelling of each string in the string pool.
+  std::unordered_map<String const*, String const*> strings;
+
+  // The position of each declaration.
+  std::unordered_map<Decl const*, int> ids;
+  std::vector<Decl const*>             decls;
+
+  // The number of each aggregate and buffer, and the
+  // number of those already written.
+  std::unordered_map<void const*, int> reps;
+  int                                  written = 0;
+
+  // The location of each object in the global store,
+  // and the buffers that hold elements.
+  std::unordered_map<Value const*, Location> objects;
+  std::vector<std::pair<Buffer_value, int>>  buffers;
+};
+
+
+Writer::Writer(std::ostream& os, Symbol_table const& syms)
+  : os(os)
+{
+  for (auto const& x : syms)
+    if (String_sym const* s = as<String_sym>(x.second))
+      strings.emplace(&s->value(), &x.first);
+}
+
+
+void
+Writer::string(String const& s)
+{
+  size(s.size());
+  bytes(s.data(), s.size());
+}
+
+
+// Number the declarations in d.
+void
+Writer::collect(Decl const* d)
+{
+  if (!d || !ids.emplace(d, decls.size()).second)
+    return;
+  decls.push_back(d);
+  if (Function_decl const* f = as<Function_decl>(d)) {
+    for (Decl const* p : f->parameters())
+      collect(p);
+    collect(f->body());
+  } else if (Record_decl const* r = as<Record_decl>(d)) {
+    for (Decl const* x : r->fields())
+      collect(x);
+    for (Decl const* x : r->members())
+      collect(x);
+    collect(r->vref());
+  } else if (Module_decl const* m = as<Module_decl>(d)) {
+    for (Decl const* x : m->declarations())
+      collect(x);
+  }
+}
+
+
+// Number the local variables declared in s.
+void
+Writer::collect(Stmt const* s)
+{
+  if (Block_stmt const* b = as<Block_stmt>(s)) {
+    for (Stmt const* x : b->statements())
+      collect(x);
+  } else if (If_then_stmt const* i = as<If_then_stmt>(s)) {
+    collect(i->body());
+  } else if (If_else_stmt const* i = as<If_else_stmt>(s)) {
+    collect(i->true_branch());
+    collect(i->false_branch());
+  } else if (Switch_stmt const* w = as<Switch_stmt>(s)) {
+    for (Switch_case const& k : w->cases())
+      collect(k.body());
+    if (w->default_case())
+      collect(w->default_case());
+  } else if (While_stmt const* w = as<While_stmt>(s)) {
+    collect(w->body());
+  } else if (For_stmt const* l = as<For_stmt>(s)) {
+    collect(l->variable());
+    collect(l->body());
+  } else if (Parallel_for_stmt const* l = as<Parallel_for_stmt>(s)) {
+    collect(l->variable());
+    collect(l->body());
+  } else if (Declaration_stmt const* d = as<Declaration_stmt>(s)) {
+    collect(d->declaration());
+  }
+}
+
+
+// Returns the number of the storage p, numbering it if
+// it has not been seen.
+int
+Writer::storage(void const* p)
+{
+  return reps.emplace(p, reps.size()).first->second;
+}
+
+
+// Record the location of each object in the global
+// store. Storage is numbered in the order that it will
+// be written.
+void
+Writer::locate(Frame const& g)
+{
+  for (std::size_t i = 0; i < g.size(); ++i) {
+    objects.emplace(&g[i], Location(-1, i));
+    locate(g[i]);
+  }
+}
+
+
+void
+Writer::locate(Value const& v)
+{
+  if (v.is_array() || v.is_tuple()) {
+    Aggregate_value a = v.is_array() ? Aggregate_value(v.get_array()) : v.get_tuple();
+    std::size_t n = reps.size();
+    int id = storage(a.rep);
+    if (id != int(n))
+      return;
+    for (std::size_t i = 0; i < a.len(); ++i) {
+      objects.emplace(a.data() + i, Location(id, i));
+      locate(a.data()[i]);
+    }
+  } else if (v.is_buffer()) {
+    std::size_t n = reps.size();
+    int id = storage(v.get_buffer().rep);
+    if (id == int(n))
+      buffers.emplace_back(v.get_buffer(), id);
+  }
+}
+
+
+void
+Writer::ref(Decl const* d)
+{
+  if (!d) {
+    word(-1);
+    return;
+  }
+  auto iter = ids.find(d);
+  if (iter == ids.end())
+    unsaveable("a reference to an undeclared entity");
+  word(iter->second);
+}
+
+
+void
+Writer::refs(Decl_seq const& ds)
+{
+  size(ds.size());
+  for (Decl const* d : ds)
+    ref(d);
+}
+
+
+void
+Writer::name(Symbol const* s)
+{
+  byte(s != nullptr);
+  if (s)
+    string(s->spelling());
+}
+
+
+void
+Writer::type(Type const* t)
+{
+  struct Fn
+  {
+    Writer& w;
+
+    void operator()(Id_type const* t)        { unsaveable("an unresolved type"); }
+    void operator()(Boolean_type const* t)   { w.byte(boolean_type); }
+    void operator()(Character_type const* t) { w.byte(character_type); }
+    void operator()(Float_type const* t)     { w.byte(float_type); }
+    void operator()(Double_type const* t)    { w.byte(double_type); }
+
+    void operator()(Integer_type const* t)
+    {
+      w.byte(integer_type);
+      w.byte(t->is_signed());
+      w.word(t->precision());
+    }
+
+    void operator()(Function_type const* t)
+    {
+      w.byte(function_type);
+      w.size(t->parameter_types().size());
+      for (Type const* p : t->parameter_types())
+        w.type(p);
+      w.type(t->return_type());
+    }
+
+    void operator()(Array_type const* t)
+    {
+      w.byte(array_type);
+      w.type(t->type());
+      w.size(t->size());
+    }
+
+    void operator()(Vector_type const* t)
+    {
+      w.byte(vector_type);
+      w.type(t->type());
+      w.size(t->size());
+    }
+
+    void operator()(Block_type const* t)
+    {
+      w.byte(block_type);
+      w.type(t->type());
+    }
+
+    void operator()(Reference_type const* t)
+    {
+      w.byte(reference_type);
+      w.type(t->type());
+    }
+
+    void operator()(Record_type const* t)
+    {
+      w.byte(record_type);
+      w.ref(t->declaration());
+    }
+  };
+
+  if (!t)
+    byte(no_type);
+  else
+    apply(t, Fn{*this});
+}
+
+
+void
+Writer::value(Value const& v)
+{
+  byte(v.kind());
+  switch (v.kind()) {
+  case error_value:
+    return;
+
+  case integer_value: {
+    Integer_value n = v.get_integer();
+    return bytes(&n, sizeof(n));
+  }
+
+  case float_value: {
+    Float_value n = v.get_float();
+    return bytes(&n, sizeof(n));
+  }
+
+  case function_value:
+    return ref(v.get_function());
+
+  case reference_value: {
+    Location loc(-2, 0);
+    if (Value const* p = v.get_reference()) {
+      auto iter = objects.find(p);
+      if (iter == objects.end())
+        unsaveable("a reference to a temporary object");
+      loc = iter->second;
+    }
+    word(loc.first);
+    return size(loc.second);
+  }
+
+  case array_value:
+    return aggregate(v.get_array());
+
+  case tuple_value:
+    aggregate(v.get_tuple());
+    return ref(v.get_tuple().record());
+
+  case string_value: {
+    String const* s = v.get_string();
+    auto iter = strings.find(s);
+    string(iter != strings.end() ? *iter->second : '"' + *s + '"');
+    return string(*s);
+  }
+
+  case buffer_value: {
+    Buffer_value b = v.get_buffer();
+    int id = storage(b.rep);
+    word(id);
+    if (id == written) {
+      ++written;
+      byte(b.kind());
+      size(b.len());
+      bytes(b.data(), b.len() * element_size(b.kind()));
+    }
+    return;
+  }
+
+  case element_value: {
+    char const* p = static_cast<char const*>(v.get_element().addr);
+    for (auto const& x : buffers) {
+      Buffer_value b = x.first;
+      if (b.data() <= p && p < b.data() + b.len() * element_size(b.kind())) {
+        word(x.second);
+        return size(p - b.data());
+      }
+    }
+    unsaveable("a reference to a temporary buffer");
+  }
+  }
+}
+
+
+// Write the storage of an aggregate, or its number if
+// it has already been written.
+void
+Writer::aggregate(Aggregate_value const& a)
+{
+  int id = storage(a.rep);
+  word(id);
+  if (id != written)
+    return;
+  ++written;
+  size(a.len());
+  for (std::size_t i = 0; i < a.len(); ++i)
+    value(a.data()[i]);
+}
+
+
+void
+Writer::expr(Expr const* e)
+{
+  struct Fn
+  {
+    Writer& w;
+
+    void unary(Expr_tag k, Unary_expr const* e)
+    {
+      w.byte(k);
+      w.type(e->type());
+      w.expr(e->operand());
+    }
+
+    void binary(Expr_tag k, Binary_expr const* e)
+    {
+      w.byte(k);
+      w.type(e->type());
+      w.expr(e->left());
+      w.expr(e->right());
+    }
+
+    void conv(Expr_tag k, Conv const* e)
+    {
+      w.byte(k);
+      w.type(e->type());
+      w.expr(e->source());
+    }
+
+    void operator()(Id_expr const* e)       { unsaveable("an unresolved name"); }
+    void operator()(Lambda_expr const* e)   { unsaveable("an unresolved lambda"); }
+    void operator()(Overload_expr const* e) { unsaveable("an unresolved name"); }
+    void operator()(Dot_expr const* e)      { unsaveable("an unresolved member"); }
+
+    void operator()(Literal_expr const* e)
+    {
+      w.byte(literal_expr);
+      w.type(e->type());
+      w.value(e->value());
+    }
+
+    void operator()(Decl_expr const* e)
+    {
+      w.byte(decl_expr);
+      w.type(e->type());
+      w.ref(e->declaration());
+    }
+
+    void operator()(Add_expr const* e) { binary(add_expr, e); }
+    void operator()(Sub_expr const* e) { binary(sub_expr, e); }
+    void operator()(Mul_expr const* e) { binary(mul_expr, e); }
+    void operator()(Div_expr const* e) { binary(div_expr, e); }
+    void operator()(Rem_expr const* e) { binary(rem_expr, e); }
+    void operator()(Neg_expr const* e) { unary(neg_expr, e); }
+    void operator()(Pos_expr const* e) { unary(pos_expr, e); }
+    void operator()(Eq_expr const* e)  { binary(eq_expr, e); }
+    void operator()(Ne_expr const* e)  { binary(ne_expr, e); }
+    void operator()(Lt_expr const* e)  { binary(lt_expr, e); }
+    void operator()(Gt_expr const* e)  { binary(gt_expr, e); }
+    void operator()(Le_expr const* e)  { binary(le_expr, e); }
+    void operator()(Ge_expr const* e)  { binary(ge_expr, e); }
+    void operator()(And_expr const* e) { binary(and_expr, e); }
+    void operator()(Or_expr const* e)  { binary(or_expr, e); }
+    void operator()(Not_expr const* e) { unary(not_expr, e); }
+
+    void operator()(Call_expr const* e)
+    {
+      w.byte(call_expr);
+      w.type(e->type());
+      w.word(e->cache_slot());
+      w.expr(e->target());
+      w.size(e->arguments().size());
+      for (Expr const* a : e->arguments())
+        w.expr(a);
+    }
+
+    void operator()(Field_expr const* e)
+    {
+      w.byte(field_expr);
+      w.type(e->type());
+      w.expr(e->container());
+      w.expr(e->member());
+      w.ref(e->var);
+      w.size(e->path_.size());
+      for (int n : e->path_)
+        w.word(n);
+    }
+
+    void operator()(Method_expr const* e)
+    {
+      w.byte(method_expr);
+      w.type(e->type());
+      w.expr(e->container());
+      w.expr(e->member());
+      w.ref(e->fn);
+    }
+
+    void operator()(Index_expr const* e)
+    {
+      w.byte(index_expr);
+      w.type(e->type());
+      w.expr(e->array());
+      w.expr(e->index());
+      w.byte(e->in_bounds());
+    }
+
+    void operator()(Vector_expr const* e)
+    {
+      w.byte(vector_expr);
+      w.type(e->type());
+      w.size(e->elements().size());
+      for (Expr const* x : e->elements())
+        w.expr(x);
+    }
+
+    void operator()(Shuffle_expr const* e)
+    {
+      w.byte(shuffle_expr);
+      w.type(e->type());
+      w.expr(e->vector());
+      w.size(e->indexes().size());
+      for (std::size_t i = 0; i < e->indexes().size(); ++i)
+        w.word(e->index(i));
+    }
+
+    void operator()(Reduce_expr const* e)
+    {
+      w.byte(reduce_expr);
+      w.type(e->type());
+      w.byte(e->reduction());
+      w.expr(e->operand());
+    }
+
+    void operator()(Value_conv const* e)   { conv(value_conv, e); }
+    void operator()(Block_conv const* e)   { conv(block_conv, e); }
+    void operator()(Promote_conv const* e) { conv(promote_conv, e); }
+
+    void operator()(Base_conv const* e)
+    {
+      conv(base_conv, e);
+      w.size(e->path_.size());
+      for (int n : e->path_)
+        w.word(n);
+    }
+
+    void operator()(Default_init const* e)
+    {
+      w.byte(default_init);
+      w.type(e->type());
+    }
+
+    void operator()(Trivial_init const* e)
+    {
+      w.byte(trivial_init);
+      w.type(e->type());
+    }
+
+    void operator()(Copy_init const* e)
+    {
+      w.byte(copy_init);
+      w.type(e->type());
+      w.expr(e->value());
+    }
+
+    void operator()(Reference_init const* e)
+    {
+      w.byte(reference_init);
+      w.type(e->type());
+      w.expr(e->object());
+    }
+  };
+
+  if (!e)
+    byte(no_expr);
+  else
+    apply(e, Fn{*this});
+}
+
+
+void
+Writer::stmt(Stmt const* s)
+{
+  struct Fn
+  {
+    Writer& w;
+
+    void operator()(Empty_stmt const* s)    { w.byte(empty_stmt); }
+    void operator()(Break_stmt const* s)    { w.byte(break_stmt); }
+    void operator()(Continue_stmt const* s) { w.byte(continue_stmt); }
+
+    void operator()(Block_stmt const* s)
+    {
+      w.byte(block_stmt);
+      w.size(s->statements().size());
+      for (Stmt const* x : s->statements())
+        w.stmt(x);
+    }
+
+    void operator()(Assign_stmt const* s)
+    {
+      w.byte(assign_stmt);
+      w.expr(s->object());
+      w.expr(s->value());
+    }
+
+    void operator()(Return_stmt const* s)
+    {
+      w.byte(return_stmt);
+      w.expr(s->value());
+    }
+
+    void operator()(If_then_stmt const* s)
+    {
+      w.byte(if_then_stmt);
+      w.expr(s->condition());
+      w.stmt(s->body());
+    }
+
+    void operator()(If_else_stmt const* s)
+    {
+      w.byte(if_else_stmt);
+      w.expr(s->condition());
+      w.stmt(s->true_branch());
+      w.stmt(s->false_branch());
+    }
+
+    void operator()(Switch_stmt const* s)
+    {
+      w.byte(switch_stmt);
+      w.expr(s->condition());
+      w.size(s->cases().size());
+      for (Switch_case const& k : s->cases()) {
+        w.size(k.labels().size());
+        for (Expr const* e : k.labels())
+          w.expr(e);
+        w.stmt(k.body());
+      }
+      w.stmt(s->default_case());
+    }
+
+    void operator()(While_stmt const* s)
+    {
+      w.byte(while_stmt);
+      w.expr(s->condition());
+      w.stmt(s->body());
+      w.byte(s->vectorize());
+    }
+
+    void operator()(For_stmt const* s)
+    {
+      Integer_value n = s->trip_count();
+      w.byte(for_stmt);
+      w.ref(s->variable());
+      w.expr(s->lower());
+      w.expr(s->upper());
+      w.stmt(s->body());
+      w.byte(s->vectorize());
+      w.bytes(&n, sizeof(n));
+    }
+
+    void operator()(Parallel_for_stmt const* s)
+    {
+      w.byte(parallel_for_stmt);
+      w.ref(s->variable());
+      w.expr(s->lower());
+      w.expr(s->upper());
+      w.stmt(s->body());
+    }
+
+    void operator()(Expression_stmt const* s)
+    {
+      w.byte(expression_stmt);
+      w.expr(s->expression());
+    }
+
+    void operator()(Declaration_stmt const* s)
+    {
+      w.byte(declaration_stmt);
+      w.ref(s->declaration());
+    }
+  };
+
+  if (!s)
+    byte(no_stmt);
+  else
+    apply(s, Fn{*this});
+}
+
+
+// Write the contents of the declaration d. Its kind
+// and name have already been written.
+void
+Writer::decl(Decl const* d)
+{
+  word(d->specifiers());
+  type(d->type_);
+  ref(d->context());
+
+  if (Variable_decl const* v = as<Variable_decl>(d)) {
+    expr(v->init());
+    word(v->slot());
+  } else if (Function_decl const* f = as<Function_decl>(d)) {
+    refs(f->parameters());
+    byte(f->virtual_parameters() != nullptr);
+    if (f->virtual_parameters())
+      refs(*f->virtual_parameters());
+    stmt(f->body());
+    word(f->frame_size());
+    if (Method_decl const* m = as<Method_decl>(d))
+      word(m->vtable_entry());
+  } else if (Parameter_decl const* p = as<Parameter_decl>(d)) {
+    word(p->slot());
+  } else if (Record_decl const* r = as<Record_decl>(d)) {
+    refs(r->fields());
+    refs(r->members());
+    type(r->base_);
+    ref(r->vref());
+    byte(r->vtable() != nullptr);
+    if (r->vtable())
+      refs(*r->vtable());
+    refs(r->layout());
+    size(r->display_.size());
+    for (Record_decl const* x : r->display_)
+      ref(x);
+    byte(r->flat_);
+  } else if (Field_decl const* f = as<Field_decl>(d)) {
+    word(f->index());
+    word(f->offset());
+  } else if (Module_decl const* m = as<Module_decl>(d)) {
+    refs(m->declarations());
+    word(m->frame_size());
+  }
+}
+
+
+// -------------------------------------------------------------------------- //
+// Reading
+
+struct Reader
+{
+  // A reference or element whose target is resolved
+  // after all storage has been read.
+  struct Fixup
+  {
+    Value*        value;
+    int           rep;
+    std::uint64_t pos;
+  };
+
+  // A use of a variable or parameter in the body of
+  // the function fn (or in no function), a field of a
+  // record, or a call to a declared function. These are
+  // checked once every declaration has been read.
+  struct Local_use
+  {
+    Decl const*          decl;
+    Function_decl const* fn;
+  };
+
+  struct Field_use
+  {
+    Field_decl const* field;
+    Type const*       type;
+  };
+
+  Reader(char const*, char const*, Symbol_table&);
+
+  [[noreturn]] void error();
+
+  void          bytes(void*, std::size_t);
+  int           byte();
+  std::int32_t  word();
+  std::uint64_t size();
+  std::uint64_t count();
+  String        string();
+
+  Decl*        allocate(int);
+  Decl*        ref();
+  Decl_seq     refs();
+  template<typename T> T* ref_to();
+  template<typename T> Decl_seq refs_to();
+  Symbol const* name();
+  Type const*  type();
+  void         value(Value&);
+  void         aggregate(Value&, bool);
+  Expr*        expr();
+  Expr*        operand();
+  Stmt*        stmt();
+  Stmt*        substmt();
+  void         decl(Decl*);
+  void         check();
+  void         fix();
+
+  Image image();
+
+  char const*   first;
+  char const*   last;
+  Symbol_table& syms;
+
+  Decl_seq           decls;
+  std::vector<Value> reps;
+  std::vector<Fixup> fixups;
+  Frame*             globals;
+
+  Function_decl const*          fn;
+  std::vector<Local_use>       locals;
+  std::vector<Field_use>       fields;
+  std::vector<Call_expr const*> calls;
+};
+
+
+Reader::Reader(char const* f, char const* l, Symbol_table& s)
+  : first(f), last(l), syms(s), globals(nullptr), fn(nullptr)
+{ }
+
+
+void
+Reader::error()
+{
+  throw std::runtime_error("invalid image");
+}
+
+
+void
+Reader::bytes(void* p, std::size_t n)
+{
+  if (std::size_t(last - first) < n)
+    error();
+  std::copy(first, first + n, static_cast<char*>(p));
+  first += n;
+}
+
+
+int
+Reader::byte()
+{
+  std::uint8_t n;
+  bytes(&n, sizeof(n));
+  return n;
+}
+
+
+std::int32_t
+Reader::word()
+{
+  std::int32_t n;
+  bytes(&n, sizeof(n));
+  return n;
+}
+
+
+std::uint64_t
+Reader::size()
+{
+  std::uint64_t n;
+  bytes(&n, sizeof(n));
+  return n;
+}
+
+
+// Read the number of elements of a sequence. Each
+// element occupies at least one byte.
+std::uint64_t
+Reader::count()
+{
+  std::uint64_t n = size();
+  if (n > std::uint64_t(last - first))
+    error();
+  return n;
+}
+
+
+String
+Reader::string()
+{
+  std::uint64_t n = count();
+  String s(first, first + n);
+  first += n;
+  return s;
+}
+
+
+// Allocate a declaration of the given kind. Its
+// contents are read later.
+Decl*
+Reader::allocate(int k)
+{
+  switch (k) {
+  case variable_tag:
+    return new Variable_decl(nullptr, nullptr, nullptr);
+  case function_tag:
+    return new Function_decl(nullptr, nullptr, {}, nullptr);
+  case parameter_tag:
+    return new Parameter_decl(nullptr, nullptr);
+  case record_tag:
+    return new Record_decl(nullptr, {}, {}, nullptr);
+  case field_tag:
+    return new Field_decl(nullptr, nullptr);
+  case method_tag:
+    return new Method_decl(nullptr, nullptr, {}, nullptr);
+  case module_tag:
+    return new Module_decl();
+  default:
+    error();
+  }
+}
+
+
+Decl*
+Reader::ref()
+{
+  std::int32_t n = word();
+  if (n == -1)
+    return nullptr;
+  if (n < 0 || std::size_t(n) >= decls.size())
+    error();
+  return decls[n];
+}
+
+
+Decl_seq
+Reader::refs()
+{
+  Decl_seq ds(count());
+  for (Decl*& d : ds)
+    d = ref();
+  return ds;
+}
+
+
+// Read a reference to a declaration of kind T. It is
+// an error if the declaration is null or has another
+// kind.
+template<typename T>
+T*
+Reader::ref_to()
+{
+  T* d = as<T>(ref());
+  if (!d)
+    error();
+  return d;
+}
+
+
+template<typename T>
+Decl_seq
+Reader::refs_to()
+{
+  Decl_seq ds(count());
+  for (Decl*& d : ds)
+    d = ref_to<T>();
+  return ds;
+}
+
+
+Symbol const*
+Reader::name()
+{
+  if (!byte())
+    return nullptr;
+  String s = string();
+  if (Symbol const* sym = syms.get(s))
+    return sym;
+  return syms.put<Identifier_sym>(s, identifier_tok);
+}
+
+
+Type const*
+Reader::type()
+{
+  switch (byte()) {
+  case no_type:
+    return nullptr;
+  case boolean_type:
+    return get_boolean_type();
+  case character_type:
+    return get_character_type();
+  case integer_type: {
+    bool s = byte();
+    int p = word();
+    return get_integer_type(s, p);
+  }
+  case float_type:
+    return get_float_type();
+  case double_type:
+    return get_double_type();
+  case function_type: {
+    Type_seq ts(count());
+    for (Type const*& t : ts)
+      t = type();
+    Type const* r = type();
+    return get_function_type(ts, r);
+  }
+  case array_type: {
+    Type const* t = type();
+    Expr* n = new Literal_expr(get_integer_type(), Value(Integer_value(size())));
+    return get_array_type(t, n);
+  }
+  case vector_type: {
+    Type const* t = type();
+    std::uint64_t n = size();
+    if (!is_scalar(t) || n == 0 || n > std::uint64_t(std::numeric_limits<int>::max()))
+      error();
+    return get_vector_type(t, int(n));
+  }
+  case block_type:
+    return get_block_type(type());
+  case reference_type:
+    return get_reference_type(type());
+  case record_type:
+    return get_record_type(ref_to<Record_decl>());
+  default:
+    error();
+  }
+}
+
+
+// Read a value into v. References and elements are
+// resolved by fix().
+void
+Reader::value(Value& v)
+{
+  switch (byte()) {
+  case error_value:
+    v = Value();
+    return;
+
+  case integer_value: {
+    Integer_value n;
+    bytes(&n, sizeof(n));
+    v = n;
+    return;
+  }
+
+  case float_value: {
+    Float_value n;
+    bytes(&n, sizeof(n));
+    v = n;
+    return;
+  }
+
+  case function_value: {
+    Decl* d = ref();
+    if (d && !is<Function_decl>(d))
+      error();
+    v = Value(Function_value(d ? cast<Function_decl>(d) : nullptr));
+    return;
+  }
+
+  case reference_value: {
+    int rep = word();
+    std::uint64_t pos = size();
+    v = Value((Value*)nullptr);
+    if (rep != -2)
+      fixups.push_back({&v, rep, pos});
+    return;
+  }
+
+  case array_value:
+    return aggregate(v, false);
+
+  case tuple_value:
+    return aggregate(v, true);
+
+  case string_value: {
+    String key = string();
+    String str = string();
+    Symbol const* s = syms.put<String_sym>(key, string_tok, str);
+    if (!is<String_sym>(s))
+      error();
+    v = &cast<String_sym>(s)->value();
+    return;
+  }
+
+  case buffer_value: {
+    std::size_t id = word();
+    if (id < reps.size()) {
+      v = reps[id];
+      if (!v.is_buffer())
+        error();
+      return;
+    }
+    if (id != reps.size())
+      error();
+    int k = byte();
+    if (k > double_element)
+      error();
+    std::uint64_t n = size();
+    if (n > std::uint64_t(last - first))
+      error();
+    Buffer_value b(Element_kind(k), n);
+    bytes(b.data(), n * element_size(b.kind()));
+    v = b;
+    reps.push_back(v);
+    return;
+  }
+
+  case element_value: {
+    int rep = word();
+    std::uint64_t pos = size();
+    v = Element_value{nullptr};
+    fixups.push_back({&v, rep, pos});
+    return;
+  }
+
+  default:
+    error();
+  }
+}
+
+
+// Read an array or tuple into v.
+void
+Reader::aggregate(Value& v, bool tuple)
+{
+  std::size_t id = word();
+  if (id < reps.size()) {
+    v = reps[id];
+    if (tuple ? !v.is_tuple() : !v.is_array())
+      error();
+  } else {
+    if (id != reps.size())
+      error();
+    std::size_t n = count();
+    Value* data;
+    if (tuple) {
+      Tuple_value t(n);
+      v = t;
+      data = t.data();
+    } else {
+      Array_value a(n);
+      v = a;
+      data = a.data();
+    }
+    reps.push_back(v);
+    for (std::size_t i = 0; i < n; ++i)
+      value(data[i]);
+  }
+  if (tuple) {
+    Decl* r = ref();
+    if (r && !is<Record_decl>(r))
+      error();
+    v.get_tuple().rep->record = r ? cast<Record_decl>(r) : nullptr;
+  }
+}
+
+
+// Check the uses of declarations that depend on other
+// declarations:
+//
+// - A variable or parameter is stored in the frame of
+//   the function that uses it, or in the global store.
+// - A field is at its offset in the layout of the record
+//   that contains it.
+// - A call to a declared function has an argument for
+//   each parameter.
+void
+Reader::check()
+{
+  for (Local_use const& u : locals) {
+    int slot;
+    std::size_t size;
+    Variable_decl const* v = as<Variable_decl>(u.decl);
+    if (v && is_global_variable(v)) {
+      slot = v->slot_;
+      size = globals->size();
+    } else {
+      if (!u.fn || u.decl->cxt_ != u.fn)
+        error();
+      slot = v ? v->slot_ : cast<Parameter_decl>(u.decl)->slot_;
+      size = u.fn->frame_;
+    }
+    if (slot < 0 || std::size_t(slot) >= size)
+      error();
+  }
+
+  for (Decl const* d : decls) {
+    Function_decl const* f = as<Function_decl>(d);
+    if (!f)
+      continue;
+    for (Decl const* p : f->parms_) {
+      int slot = cast<Parameter_decl>(p)->slot_;
+      if (slot < 0 || slot >= f->frame_)
+        error();
+    }
+  }
+
+  for (Field_use const& u : fields) {
+    Record_type const* t = as<Record_type>(u.type ? u.type->nonref() : nullptr);
+    if (!t)
+      error();
+    Decl_seq const& l = t->declaration()->layout_;
+    int n = u.field->offset_;
+    if (n < 0 || std::size_t(n) >= l.size() || l[n] != u.field)
+      error();
+  }
+
+  for (Call_expr const* c : calls) {
+    Decl_expr const* e = as<Decl_expr>(c->target());
+    if (!e)
+      continue;
+    Function_decl const* f = as<Function_decl>(e->declaration());
+    if (!f || f->parms_.size() != c->arguments().size())
+      error();
+  }
+}
+
+
+// Resolve the targets of references and elements.
+void
+Reader::fix()
+{
+  for (Fixup const& f : fixups) {
+    if (f.value->is_reference()) {
+      Value* p;
+      if (f.rep == -1) {
+        if (f.pos >= globals->size())
+          error();
+        p = &(*globals)[f.pos];
+      } else {
+        if (f.rep < 0 || std::size_t(f.rep) >= reps.size())
+          error();
+        Value const& a = reps[f.rep];
+        if (a.is_buffer())
+          error();
+        Aggregate_value x = a.is_array() ? Aggregate_value(a.get_array()) : a.get_tuple();
+        if (f.pos >= x.len())
+          error();
+        p = x.data() + f.pos;
+      }
+      *f.value = Value(p);
+    } else {
+      if (f.rep < 0 || std::size_t(f.rep) >= reps.size() || !reps[f.rep].is_buffer())
+        error();
+      Buffer_value b = reps[f.rep].get_buffer();
+      if (f.pos >= b.len() * element_size(b.kind()))
+        error();
+      *f.value = Element_value{b.data() + f.pos};
+    }
+  }
+}
+
+
+Expr*
+Reader::expr()
+{
+  int k = byte();
+  if (k == no_expr)
+    return nullptr;
+  Type const* t = type();
+  if (!t)
+    error();
+
+  Expr* e;
+  switch (k) {
+  case literal_expr: {
+    Literal_expr* l = new Literal_expr(t, Value());
+    value(l->val);
+    return l;
+  }
+
+  case decl_expr: {
+    Decl* d = ref();
+    if (!d)
+      error();
+    if (is<Variable_decl>(d) || is<Parameter_decl>(d))
+      locals.push_back({d, fn});
+    return new Decl_expr(t, d);
+  }
+
+  case add_expr: { Expr* a = operand(); e = new Add_expr(a, operand()); break; }
+  case sub_expr: { Expr* a = operand(); e = new Sub_expr(a, operand()); break; }
+  case mul_expr: { Expr* a = operand(); e = new Mul_expr(a, operand()); break; }
+  case div_expr: { Expr* a = operand(); e = new Div_expr(a, operand()); break; }
+  case rem_expr: { Expr* a = operand(); e = new Rem_expr(a, operand()); break; }
+  case neg_expr: e = new Neg_expr(operand()); break;
+  case pos_expr: e = new Pos_expr(operand()); break;
+  case eq_expr:  { Expr* a = operand(); e = new Eq_expr(a, operand()); break; }
+  case ne_expr:  { Expr* a = operand(); e = new Ne_expr(a, operand()); break; }
+  case lt_expr:  { Expr* a = operand(); e = new Lt_expr(a, operand()); break; }
+  case gt_expr:  { Expr* a = operand(); e = new Gt_expr(a, operand()); break; }
+  case le_expr:  { Expr* a = operand(); e = new Le_expr(a, operand()); break; }
+  case ge_expr:  { Expr* a = operand(); e = new Ge_expr(a, operand()); break; }
+  case and_expr: { Expr* a = operand(); e = new And_expr(a, operand()); break; }
+  case or_expr:  { Expr* a = operand(); e = new Or_expr(a, operand()); break; }
+  case not_expr: e = new Not_expr(operand()); break;
+
+  case call_expr: {
+    int slot = word();
+    Expr* f = operand();
+    Expr_seq args(count());
+    for (Expr*& a : args)
+      a = operand();
+    Call_expr* c = new Call_expr(t, f, args);
+    c->slot = slot;
+    calls.push_back(c);
+    return c;
+  }
+
+  case field_expr: {
+    Expr* e1 = operand();
+    Expr* e2 = expr();
+    Field_decl* v = ref_to<Field_decl>();
+    fields.push_back({v, e1->type()});
+    Field_path p(count());
+    for (int& n : p)
+      n = word();
+    return new Field_expr(t, e1, e2, v, p);
+  }
+
+  case method_expr: {
+    Expr* e1 = operand();
+    Expr* e2 = operand();
+    e = new Method_expr(e1, e2, ref_to<Method_decl>());
+    break;
+  }
+
+  case index_expr: {
+    Expr* e1 = operand();
+    Index_expr* x = new Index_expr(e1, operand());
+    x->safe = byte();
+    e = x;
+    break;
+  }
+
+  case vector_expr: {
+    Expr_seq es(count());
+    for (Expr*& x : es)
+      x = operand();
+    return new Vector_expr(t, es);
+  }
+
+  // Each index selects an element of the vector.
+  case shuffle_expr: {
+    Expr* v = operand();
+    Vector_type const* vt = as<Vector_type>(v->type() ? v->type()->nonref() : nullptr);
+    if (!vt)
+      error();
+    Expr_seq ix(count());
+    for (Expr*& i : ix) {
+      int n = word();
+      if (n < 0 || n >= vt->size())
+        error();
+      i = new Literal_expr(get_integer_type(), Value(Integer_value(n)));
+    }
+    e = new Shuffle_expr(v, ix);
+    break;
+  }
+
+  case reduce_expr: {
+    Reduction r = Reduction(byte());
+    if (r > any_reduction)
+      error();
+    e = new Reduce_expr(r, operand());
+    break;
+  }
+
+  case value_conv:   return new Value_conv(t, operand());
+  case block_conv:   return new Block_conv(t, operand());
+  case promote_conv: return new Promote_conv(t, operand());
+
+  case base_conv: {
+    Base_conv* c = new Base_conv(t, operand());
+    c->path_.resize(count());
+    for (int& n : c->path_)
+      n = word();
+    return c;
+  }
+
+  case default_init: return new Default_init(t);
+  case trivial_init: return new Trivial_init(t);
+  case copy_init:    return new Copy_init(t, operand());
+
+  case reference_init: return new Reference_init(t, operand());
+
+  default:
+    error();
+  }
+
+  // The operands of a binary expression are converted
+  // to a common type.
+  if (Binary_expr const* b = as<Binary_expr>(e)) {
+    if (b->left()->type()->nonref() != b->right()->type()->nonref())
+      error();
+  }
+  e->type_ = t;
+  return e;
+}
+
+
+// Read an expression that cannot be omitted.
+Expr*
+Reader::operand()
+{
+  Expr* e = expr();
+  if (!e)
+    error();
+  return e;
+}
+
+
+Stmt*
+Reader::stmt()
+{
+  switch (byte()) {
+  case no_stmt:
+    return nullptr;
+  case empty_stmt:
+    return new Empty_stmt();
+  case break_stmt:
+    return new Break_stmt();
+  case continue_stmt:
+    return new Continue_stmt();
+
+  case block_stmt: {
+    Stmt_seq ss(count());
+    for (Stmt*& s : ss)
+      s = substmt();
+    return new Block_stmt(ss);
+  }
+
+  case assign_stmt: {
+    Expr* e1 = operand();
+    return new Assign_stmt(e1, operand());
+  }
+
+  case return_stmt:
+    return new Return_stmt(operand());
+
+  case if_then_stmt: {
+    Expr* e = operand();
+    return new If_then_stmt(e, substmt());
+  }
+
+  case if_else_stmt: {
+    Expr* e = operand();
+    Stmt* s1 = substmt();
+    return new If_else_stmt(e, s1, substmt());
+  }
+
+  // The body of a case and the default case can be
+  // omitted.
+  case switch_stmt: {
+    Expr* e = operand();
+    Case_seq cs;
+    for (std::uint64_t n = count(); n != 0; --n) {
+      Expr_seq ls(count());
+      for (Expr*& l : ls) {
+        l = operand();
+        Literal_expr const* k = as<Literal_expr>(l);
+        if (!k || !k->value().is_integer())
+          error();
+      }
+      cs.emplace_back(ls, stmt());
+    }
+    return new Switch_stmt(e, cs, stmt());
+  }
+
+  case while_stmt: {
+    Expr* e = operand();
+    Stmt* s = substmt();
+    return new While_stmt(e, s, byte());
+  }
+
+  case for_stmt: {
+    Variable_decl* d = ref_to<Variable_decl>();
+    locals.push_back({d, fn});
+    Expr* e1 = operand();
+    Expr* e2 = operand();
+    Stmt* s = substmt();
+    For_stmt* f = new For_stmt(d, e1, e2, s, byte());
+    bytes(&f->trips, sizeof(f->trips));
+    return f;
+  }
+
+  case parallel_for_stmt: {
+    Variable_decl* d = ref_to<Variable_decl>();
+    locals.push_back({d, fn});
+    Expr* e1 = operand();
+    Expr* e2 = operand();
+    return new Parallel_for_stmt(d, e1, e2, substmt());
+  }
+
+  case expression_stmt:
+    return new Expression_stmt(operand());
+
+  case declaration_stmt: {
+    Variable_decl* d = ref_to<Variable_decl>();
+    locals.push_back({d, fn});
+    return new Declaration_stmt(d);
+  }
+
+  default:
+    error();
+  }
+}
+
+
+// Read a statement that cannot be omitted.
+Stmt*
+Reader::substmt()
+{
+  Stmt* s = stmt();
+  if (!s)
+    error();
+  return s;
+}
+
+
+// Read the contents of the declaration d.
+void
+Reader::decl(Decl* d)
+{
+  d->spec_ = Specifier(word());
+  d->type_ = type();
+  d->cxt_ = ref();
+
+  if (Variable_decl* v = as<Variable_decl>(d)) {
+    // The elaborator binds the initializer of each
+    // variable to the variable. The initializer of a
+    // local variable is evaluated in its function.
+    fn = as<Function_decl>(d->cxt_);
+    Expr* e = expr();
+    fn = nullptr;
+    if (e && !is<Init>(e))
+      error();
+    v->init_ = e;
+    v->slot_ = word();
+    if (Init* i = as<Init>(v->init_))
+      i->decl_ = v;
+  } else if (Function_decl* f = as<Function_decl>(d)) {
+    if (!is<Function_type>(f->type_))
+      error();
+    f->parms_ = refs_to<Parameter_decl>();
+    if (byte())
+      f->vparms_ = new Decl_seq(refs_to<Parameter_decl>());
+    fn = f;
+    f->body_ = stmt();
+    fn = nullptr;
+    f->frame_ = word();
+    if (f->frame_ < 0)
+      error();
+    if (Method_decl* m = as<Method_decl>(d)) {
+      if (!is<Record_decl>(d->cxt_))
+        error();
+      m->vtent_ = word();
+    }
+  } else if (Parameter_decl* p = as<Parameter_decl>(d)) {
+    p->slot_ = word();
+  } else if (Record_decl* r = as<Record_decl>(d)) {
+    r->fields_ = refs_to<Field_decl>();
+    r->members_ = refs_to<Method_decl>();
+    r->base_ = type();
+    if (r->base_ && !is<Record_type>(r->base_))
+      error();
+    r->vref_ = ref();
+    if (r->vref_ && !is<Field_decl>(r->vref_))
+      error();
+    if (byte())
+      r->vtbl_ = new Decl_seq(refs_to<Function_decl>());
+    r->layout_ = refs_to<Field_decl>();
+    r->display_.resize(count());
+    for (Record_decl const*& x : r->display_)
+      x = ref_to<Record_decl>();
+    r->flat_ = byte();
+  } else if (Field_decl* f = as<Field_decl>(d)) {
+    if (d->cxt_ && !is<Record_decl>(d->cxt_))
+      error();
+    f->index_ = word();
+    f->offset_ = word();
+  } else if (Module_decl* m = as<Module_decl>(d)) {
+    m->decls_ = refs();
+    m->frame_ = word();
+  }
+}
+
+
+Image
+Reader::image()
+{
+  char buf[sizeof(magic)];
+  bytes(buf, sizeof(buf));
+  if (!std::equal(buf, buf + sizeof(buf), magic))
+    error();
+  std::uint64_t sum = size();
+  if (sum != checksum(first, last))
+    error();
+
+  // Allocate the declarations.
+  decls.resize(count());
+  for (Decl*& d : decls) {
+    d = allocate(byte());
+    d->name_ = name();
+  }
+  if (decls.empty() || !is<Module_decl>(decls[0]))
+    error();
+
+  // Read the global store, then the declarations.
+  Image img;
+  img.globals.resize(count());
+  globals = &img.globals;
+  for (Value& v : img.globals)
+    value(v);
+  for (Decl* d : decls)
+    decl(d);
+  check();
+  fix();
+
+  img.module = cast<Module_decl>(decls[0]);
+  img.main = as<Function_decl>(ref());
+  if (first != last)
+    error();
+  return img;
+}
+
+
+} // namespace
+
+
+// Save an image of the module m, whose entry point is
+// main and whose global store is g, to the file path.
+void
+save_image(String const& path, Symbol_table const& syms, Module_decl const* m, Function_decl const* main, Frame const& g)
+{
+  std::ofstream ofs(path, std::ios::binary);
+  if (!ofs)
+    throw std::runtime_error(format("cannot open image '{}'", path));
+
+  // The image is written to memory so that its checksum
+  // can precede it.
+  std::ostringstream ss;
+  Writer w(ss, syms);
+  w.collect(m);
+  w.locate(g);
+
+  w.size(w.decls.size());
+  for (Decl const* d : w.decls) {
+    w.byte(get_tag(d));
+    w.name(d->name());
+  }
+  w.size(g.size());
+  for (Value const& v : g)
+    w.value(v);
+  for (Decl const* d : w.decls)
+    w.decl(d);
+  w.ref(main);
+
+  String buf = ss.str();
+  std::uint64_t sum = checksum(buf.data(), buf.data() + buf.size());
+  ofs.write(magic, sizeof(magic));
+  ofs.write(reinterpret_cast<char const*>(&sum), sizeof(sum));
+  ofs.write(buf.data(), buf.size());
+  if (!ofs)
+    throw std::runtime_error(format("cannot write image '{}'", path));
+}
+
+
+// Load the image in the file path. Throws an exception
+// if the image cannot be read.
+Image
+load_image(String const& path, Symbol_table& syms)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error(format("cannot open image '{}'", path));
+  struct stat st;
+  void* p = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0)
+    p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED)
+    throw std::runtime_error(format("cannot map image '{}'", path));
+
+  char const* first = static_cast<char const*>(p);
+  Image img;
+  try {
+    Reader r(first, first + st.st_size, syms);
+    img = r.image();
+  } catch (...) {
+    munmap(p, st.st_size);
+    throw;
+  }
+  munmap(p, st.st_size);
+  return img;
+}
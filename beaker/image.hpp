@@ -0,0 +1,38 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_IMAGE_HPP
+#define BEAKER_IMAGE_HPP
+
+// The image module saves and loads snapshots of an
+// interpreted program. An image holds the elaborated
+// module, its entry point, and the global store after
+// the module's declarations have been evaluated.
+//
+// Loading an image maps the file into memory and
+// rebuilds the program in a single pass, so starting
+// from an image skips lexing, parsing, elaboration,
+// and the evaluation of global initializers.
+//
+// Images record the program as it is represented by
+// this build of the interpreter. They are not portable
+// across versions or hosts.
+
+#include <beaker/prelude.hpp>
+#include <beaker/evaluator.hpp>
+
+
+// A program restored from an image.
+struct Image
+{
+  Module_decl*   module;
+  Function_decl* main;    // The entry point, if any
+  Frame          globals; // The evaluated global store
+};
+
+
+void  save_image(String const&, Symbol_table const&, Module_decl const*, Function_decl const*, Frame const&);
+Image load_image(String const&, Symbol_table&);
+
+
+#endif
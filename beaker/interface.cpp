@@ -0,0 +1,484 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/interface.hpp"
+#include "beaker/type.hpp"
+#include "beaker/expr.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/value.hpp"
+#include "beaker/token.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+
+// An interface starts with a magic number and a version,
+// followed by the number of declarations and then the
+// declarations. Integers are written in little endian
+// order. Strings are written as their length followed
+// by their characters.
+//
+// Each declaration starts with its kind, its specifiers,
+// and its name.
+//
+// - A variable is followed by its type.
+// - A function is followed by its parameters (specifiers,
+//   name, and type) and its return type.
+// - A record is followed by the name of its base (if
+//   any), its fields (name and type), and its methods.
+//   A method is written as a function, without its
+//   implicit this parameter.
+//
+// Types are written as a tag followed by their operands.
+// A record type is written as the name of its record.
+
+namespace
+{
+
+char const magic[] = { 'B', 'K', 'I', 1 };
+
+
+enum Decl_kind : std::uint8_t
+{
+  variable_kind = 1,
+  function_kind,
+  record_kind,
+};
+
+
+enum Type_tag : std::uint8_t
+{
+  boolean_tag,
+  character_tag,
+  integer_tag,
+  float_tag,
+  double_tag,
+  function_tag,
+  array_tag,
+  block_tag,
+  reference_tag,
+  record_tag,
+  vector_tag,
+};
+
+
+// -------------------------------------------------------------------------- //
+// Writing
+
+struct Writer
+{
+  Writer(std::ostream& os)
+    : os(os)
+  { }
+
+  void byte(int);
+  void word(std::uint32_t);
+  void string(String const&);
+  void name(Symbol const*);
+
+  void type(Type const*);
+
+  void decl(Decl const*);
+  void function(Function_decl const*, int);
+
+  std::ostream& os;
+};
+
+
+void
+Writer::byte(int n)
+{
+  os.put(char(n));
+}
+
+
+void
+Writer::word(std::uint32_t n)
+{
+  for (int i = 0; i < 4; ++i)
+    byte(n >> (8 * i));
+}
+
+
+void
+Writer::string(String const& s)
+{
+  word(s.size());
+  os.write(s.data(), s.size());
+}
+
+
+void
+Writer::name(Symbol const* s)
+{
+  string(s->spelling());
+}
+
+
+void
+Writer::type(Type const* t)
+{
+  struct Fn
+  {
+    Writer& w;
+
+    void operator()(Id_type const* t)
+    {
+      lingo_unreachable();
+    }
+
+    void operator()(Boolean_type const* t)
+    {
+      w.byte(boolean_tag);
+    }
+
+    void operator()(Character_type const* t)
+    {
+      w.byte(character_tag);
+    }
+
+    void operator()(Integer_type const* t)
+    {
+      w.byte(integer_tag);
+      w.byte(t->is_signed());
+      w.byte(t->precision());
+    }
+
+    void operator()(Float_type const* t)
+    {
+      w.byte(float_tag);
+    }
+
+    void operator()(Double_type const* t)
+    {
+      w.byte(double_tag);
+    }
+
+    void operator()(Function_type const* t)
+    {
+      w.byte(function_tag);
+      w.word(t->parameter_types().size());
+      for (Type const* p : t->parameter_types())
+        w.type(p);
+      w.type(t->return_type());
+    }
+
+    void operator()(Array_type const* t)
+    {
+      w.byte(array_tag);
+      w.type(t->type());
+      w.word(t->size());
+    }
+
+    void operator()(Vector_type const* t)
+    {
+      w.byte(vector_tag);
+      w.type(t->type());
+      w.word(t->size());
+    }
+
+    void operator()(Block_type const* t)
+    {
+      w.byte(block_tag);
+      w.type(t->type());
+    }
+
+    void operator()(Reference_type const* t)
+    {
+      w.byte(reference_tag);
+      w.type(t->type());
+    }
+
+    void operator()(Record_type const* t)
+    {
+      w.byte(record_tag);
+      w.name(t->declaration()->name());
+    }
+  };
+
+  apply(t, Fn{*this});
+}
+
+
+// Write the parameters and return type of f, skipping
+// the first n parameters.
+void
+Writer::function(Function_decl const* f, int n)
+{
+  Decl_seq const& parms = f->parameters();
+  word(parms.size() - n);
+  for (auto iter = parms.begin() + n; iter != parms.end(); ++iter) {
+    word((*iter)->specifiers());
+    name((*iter)->name());
+    type((*iter)->type());
+  }
+  type(f->return_type());
+}
+
+
+void
+Writer::decl(Decl const* d)
+{
+  if (Variable_decl const* v = as<Variable_decl>(d)) {
+    byte(variable_kind);
+    word(v->specifiers());
+    name(v->name());
+    type(v->type());
+  } else if (Function_decl const* f = as<Function_decl>(d)) {
+    byte(function_kind);
+    word(f->specifiers());
+    name(f->name());
+    function(f, 0);
+  } else if (Record_decl const* r = as<Record_decl>(d)) {
+    // The specifiers of a record are re-derived from
+    // its methods and base when it is elaborated.
+    byte(record_kind);
+    word(no_spec);
+    name(r->name());
+    if (Record_decl const* b = r->base_declaration()) {
+      byte(1);
+      name(b->name());
+    } else {
+      byte(0);
+    }
+    word(r->fields().size());
+    for (Decl const* f : r->fields()) {
+      name(f->name());
+      type(f->type());
+    }
+    word(r->members().size());
+    for (Decl const* m : r->members()) {
+      word(m->specifiers());
+      name(m->name());
+      function(cast<Method_decl>(m), 1);
+    }
+  }
+}
+
+
+// Returns true if d is exported by its module. Imported
+// and compiler-generated declarations are not, and
+// neither is the entry point of the program.
+bool
+is_exported(Decl const* d)
+{
+  if (!is<Variable_decl>(d) && !is<Function_decl>(d) && !is<Record_decl>(d))
+    return false;
+  if (d->is_imported() || d->specifiers() & generated_spec)
+    return false;
+  return d->name()->spelling() != "main";
+}
+
+
+// -------------------------------------------------------------------------- //
+// Reading
+
+struct Reader
+{
+  Reader(std::istream& is, Symbol_table& syms)
+    : is(is), syms(syms)
+  { }
+
+  int           byte();
+  std::uint32_t word();
+  String        string();
+  Symbol const* name();
+
+  Type const* type();
+
+  Decl*    decl();
+  Decl_seq parameters();
+
+  [[noreturn]] void error();
+
+  std::istream& is;
+  Symbol_table& syms;
+};
+
+
+void
+Reader::error()
+{
+  throw std::runtime_error("invalid module interface");
+}
+
+
+int
+Reader::byte()
+{
+  int c = is.get();
+  if (c == std::istream::traits_type::eof())
+    error();
+  return c;
+}
+
+
+std::uint32_t
+Reader::word()
+{
+  std::uint32_t n = 0;
+  for (int i = 0; i < 4; ++i)
+    n |= std::uint32_t(byte()) << (8 * i);
+  return n;
+}
+
+
+String
+Reader::string()
+{
+  std::uint32_t n = word();
+  String s(n, 0);
+  if (n && !is.read(&s[0], n))
+    error();
+  return s;
+}
+
+
+Symbol const*
+Reader::name()
+{
+  return syms.put<Identifier_sym>(string(), identifier_tok);
+}
+
+
+Type const*
+Reader::type()
+{
+  switch (byte()) {
+  case boolean_tag:
+    return get_boolean_type();
+  case character_tag:
+    return get_character_type();
+  case integer_tag: {
+    bool s = byte();
+    int p = byte();
+    return get_integer_type(s, p);
+  }
+  case float_tag:
+    return get_float_type();
+  case double_tag:
+    return get_double_type();
+  case function_tag: {
+    Type_seq ts(word());
+    for (Type const*& t : ts)
+      t = type();
+    Type const* r = type();
+    return get_function_type(ts, r);
+  }
+  case array_tag: {
+    Type const* t = type();
+    Expr* n = new Literal_expr(get_integer_type(), Value(Integer_value(word())));
+    return get_array_type(t, n);
+  }
+  case vector_tag: {
+    Type const* t = type();
+    return get_vector_type(t, int(word()));
+  }
+  case block_tag:
+    return get_block_type(type());
+  case reference_tag:
+    return get_reference_type(type());
+  case record_tag:
+    return get_id_type(name());
+  default:
+    error();
+  }
+}
+
+
+Decl_seq
+Reader::parameters()
+{
+  Decl_seq ps(word());
+  for (Decl*& p : ps) {
+    Specifier spec = Specifier(word());
+    Symbol const* n = name();
+    p = new Parameter_decl(spec, n, type());
+  }
+  return ps;
+}
+
+
+Decl*
+Reader::decl()
+{
+  int k = byte();
+  Specifier spec = Specifier(word());
+  spec |= imported_spec;
+  Symbol const* n = name();
+  switch (k) {
+  case variable_kind: {
+    Type const* t = type();
+    return new Variable_decl(spec, n, t, new Default_init(t));
+  }
+  case function_kind: {
+    Decl_seq ps = parameters();
+    Type const* t = get_function_type(ps, type());
+    return new Function_decl(spec, n, t, ps, nullptr);
+  }
+  case record_kind: {
+    Type const* base = nullptr;
+    if (byte())
+      base = get_id_type(name());
+    Decl_seq fs(word());
+    for (Decl*& f : fs) {
+      Symbol const* fn = name();
+      f = new Field_decl(fn, type());
+    }
+    Decl_seq ms(word());
+    for (Decl*& m : ms) {
+      Specifier ms = Specifier(word());
+      ms |= imported_spec;
+      Symbol const* mn = name();
+      Decl_seq ps = parameters();
+      Type const* t = get_function_type(ps, type());
+      m = new Method_decl(ms, mn, t, ps, nullptr);
+    }
+    Record_decl* r = new Record_decl(n, fs, ms, base);
+    r->spec_ = spec;
+    return r;
+  }
+  default:
+    error();
+  }
+}
+
+
+} // namespace
+
+
+// Write the interface of the module m to os.
+void
+write_interface(std::ostream& os, Module_decl const* m)
+{
+  Decl_seq ds;
+  for (Decl* d : m->declarations())
+    if (is_exported(d))
+      ds.push_back(d);
+
+  Writer w(os);
+  os.write(magic, sizeof(magic));
+  w.word(ds.size());
+  for (Decl const* d : ds)
+    w.decl(d);
+}
+
+
+// Read a module interface from is. Returns the imported
+// declarations. Throws an exception if the interface
+// is invalid.
+Decl_seq
+read_interface(std::istream& is, Symbol_table& syms)
+{
+  Reader r(is, syms);
+  char buf[sizeof(magic)];
+  if (!is.read(buf, sizeof(buf)) || !std::equal(buf, buf + sizeof(buf), magic))
+    r.error();
+  Decl_seq ds(r.word());
+  for (Decl*& d : ds)
+    d = r.decl();
+  return ds;
+}
@@ -0,0 +1,30 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_INTERFACE_HPP
+#define BEAKER_INTERFACE_HPP
+
+// The interface module reads and writes module
+// interfaces. An interface is a compact binary encoding
+// of the declarations that a module exports: its global
+// variables, its functions, and its records, including
+// their fields and methods.
+//
+// An imported declaration is rebuilt as if it had been
+// parsed without a definition, and is marked with the
+// imported specifier. It is elaborated with the rest of
+// the importing module, so its type, mangled name, and
+// record layout are the same as in the exporting module.
+// Definitions (function bodies, initializers, and
+// virtual tables) stay in the exporting module.
+
+#include <beaker/prelude.hpp>
+
+#include <iosfwd>
+
+
+void     write_interface(std::ostream&, Module_decl const*);
+Decl_seq read_interface(std::istream&, Symbol_table&);
+
+
+#endif
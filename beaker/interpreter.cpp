@@ -8,6 +8,8 @@
 #include "beaker/evaluator.hpp"
 #include "beaker/generator.hpp"
 #include "beaker/error.hpp"
+#include "beaker/image.hpp"
+#include "beaker/options.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -19,19 +21,97 @@
 using namespace std;
 
 
+// Print usage information.
+static void
+usage(std::ostream& os, po::options_description& desc)
+{
+  os << "usage: beaker-interpret [options] input-file\n";
+  os << desc << '\n';
+}
+
+
+// Run a program saved in an image.
+static int
+run_image(String const& path, Symbol_table& syms)
+{
+  Image img;
+  try {
+    img = load_image(path, syms);
+  } catch (std::runtime_error& err) {
+    std::cerr << "error: " << err.what() << '\n';
+    return -1;
+  }
+
+  try {
+    if (img.main) {
+      Evaluator ev;
+      ev.init(img.module, std::move(img.globals));
+      Value v = ev.exec(img.main);
+      std::cout << "result: " << v << '\n';
+    } else {
+      std::cout << "no main\n";
+    }
+  } catch (Translation_error& err) {
+    diagnose(err);
+    return -1;
+  }
+  return 0;
+}
+
+
 int
 main(int argc, char* argv[])
 {
   init_colors();
 
+  po::options_description opts("Options");
+  opts.add_options()
+    ("help",       po::bool_switch(),   "Print this message and exit.")
+    ("input,i",    po::value<String>(), "Specify the input file.")
+    ("save-image", po::value<String>(), "Save an image of the initialized program and exit.")
+    ("load-image", po::value<String>(), "Run the program saved in an image.");
+
+  po::positional_options_description positional_opts;
+  positional_opts.add("input", 1);
+
+  po::variables_map vm;
+  try {
+    po::store(
+      po::command_line_parser(argc, argv)
+        .options(opts)
+        .positional(positional_opts)
+        .run(),
+      vm);
+    po::notify(vm);
+  } catch(std::exception& err) {
+    std::cerr << "error: " << err.what() << "\n\n";
+    usage(std::cerr, opts);
+    return -1;
+  }
+  if (vm["help"].as<bool>()) {
+    usage(std::cout, opts);
+    return 0;
+  }
+
   // Prepare the symbol table.
   Symbol_table syms;
   init_symbols(syms);
 
+  // Starting from an image skips translation and the
+  // initialization of global variables.
+  if (vm.count("load-image"))
+    return run_image(vm["load-image"].as<String>(), syms);
+
+  if (!vm.count("input")) {
+    std::cerr << "error: no input file\n\n";
+    usage(std::cerr, opts);
+    return -1;
+  }
+
   Module_decl mod;
 
   // Prepare the input buffer.
-  File src = argv[1];
+  File src = vm["input"].as<String>().c_str();
   Input_buffer in = src;
 
   try {
@@ -58,6 +138,20 @@ main(int argc, char* argv[])
     Elaborator elab(locs, syms);
     elab.elaborate(&mod);
 
+    // Evaluate the global variables and save the
+    // program in an image.
+    if (vm.count("save-image")) {
+      Evaluator ev;
+      ev.eval(&mod);
+      try {
+        save_image(vm["save-image"].as<String>(), syms, &mod, elab.main, ev.global_store());
+      } catch (std::runtime_error& err) {
+        std::cerr << "error: " << err.what() << '\n';
+        return -1;
+      }
+      return 0;
+    }
+
     // Find an entry point for evaluation.
     //
     // TODO: The resolution of main is a little artificial.
@@ -0,0 +1,473 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/kernel.hpp"
+#include "beaker/type.hpp"
+#include "beaker/expr.hpp"
+#include "beaker/decl.hpp"
+#include "beaker/stmt.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+// -------------------------------------------------------------------------- //
+// Recognition of kernels
+
+namespace
+{
+
+// Returns the variable or parameter named by e, or
+// nullptr if e does not name one.
+Decl const*
+as_variable(Expr const* e)
+{
+  if (Decl_expr const* d = as<Decl_expr>(e))
+    if (is<Variable_decl>(d->declaration()) || is<Parameter_decl>(d->declaration()))
+      return d->declaration();
+  return nullptr;
+}
+
+
+// Returns the variable whose value is read by e, or
+// nullptr if e does not read a variable.
+Decl const*
+as_value_of(Expr const* e)
+{
+  if (Value_conv const* c = as<Value_conv>(e))
+    return as_variable(c->source());
+  return nullptr;
+}
+
+
+// Returns true if d is a variable of integral type. A
+// reference could refer to an element of an array that
+// the loop modifies, so references are excluded.
+inline bool
+is_integral_variable(Decl const* d)
+{
+  return d && is_integral(d->type());
+}
+
+
+// Builds the elementwise expression of a kernel.
+struct Kernel_matcher
+{
+  Loop_kernel& k;
+
+  int  node(Kernel_op op, int a = -1, int b = -1)
+  {
+    k.nodes.push_back({op, a, b});
+    return k.nodes.size() - 1;
+  }
+
+  int  invariant(Expr const* e)
+  {
+    k.invariants.push_back(e);
+    return node(invariant_op, k.invariants.size() - 1);
+  }
+
+  bool is_invariant(Decl const* d) const
+  {
+    return d != k.index && d != k.accum && is_integral_variable(d);
+  }
+
+  bool is_index(Expr const* e) const
+  {
+    return as_value_of(e) == k.index;
+  }
+
+  bool is_element(Index_expr const*) const;
+  int  array(Index_expr const*);
+  int  expr(Expr const*);
+  int  binary(Kernel_op, Binary_expr const*);
+};
+
+
+// Returns true if e is a[i], where a is an array of
+// integers and i is the loop index.
+bool
+Kernel_matcher::is_element(Index_expr const* e) const
+{
+  if (!is_index(e->index()))
+    return false;
+  Decl const* d = as_variable(e->array());
+  if (!d)
+    return false;
+  Array_type const* t = as<Array_type>(d->type()->nonref());
+  return t && is_integral(t->type());
+}
+
+
+// Returns the index of the array of a[i], or -1 if e
+// is not an element.
+int
+Kernel_matcher::array(Index_expr const* e)
+{
+  if (!is_element(e))
+    return -1;
+
+  // Reuse the array if it has already been seen.
+  Decl const* d = as_variable(e->array());
+  for (std::size_t i = 0; i < k.arrays.size(); ++i)
+    if (as_variable(k.arrays[i]) == d)
+      return i;
+  k.arrays.push_back(e->array());
+  return k.arrays.size() - 1;
+}
+
+
+int
+Kernel_matcher::binary(Kernel_op op, Binary_expr const* e)
+{
+  int a = expr(e->left());
+  if (a < 0)
+    return -1;
+  int b = expr(e->right());
+  if (b < 0)
+    return -1;
+  return node(op, a, b);
+}
+
+
+// Returns the index of the root node of e, or -1 if e is
+// not an elementwise expression.
+int
+Kernel_matcher::expr(Expr const* e)
+{
+  if (!is_integral(e->type()))
+    return -1;
+
+  if (Literal_expr const* l = as<Literal_expr>(e))
+    return l->value().is_integer() ? invariant(e) : -1;
+
+  if (Value_conv const* c = as<Value_conv>(e)) {
+    if (Decl const* d = as_variable(c->source())) {
+      if (d == k.index)
+        return node(index_op);
+      return is_invariant(d) ? invariant(e) : -1;
+    }
+    if (Index_expr const* x = as<Index_expr>(c->source())) {
+      int a = array(x);
+      return a < 0 ? -1 : node(load_op, a);
+    }
+    return -1;
+  }
+
+  if (Add_expr const* x = as<Add_expr>(e)) return binary(add_op, x);
+  if (Sub_expr const* x = as<Sub_expr>(e)) return binary(sub_op, x);
+  if (Mul_expr const* x = as<Mul_expr>(e)) return binary(mul_op, x);
+  if (Div_expr const* x = as<Div_expr>(e)) return binary(div_op, x);
+  if (Rem_expr const* x = as<Rem_expr>(e)) return binary(rem_op, x);
+  if (Eq_expr const* x = as<Eq_expr>(e)) return binary(eq_op, x);
+  if (Ne_expr const* x = as<Ne_expr>(e)) return binary(ne_op, x);
+  if (Lt_expr const* x = as<Lt_expr>(e)) return binary(lt_op, x);
+  if (Gt_expr const* x = as<Gt_expr>(e)) return binary(gt_op, x);
+  if (Le_expr const* x = as<Le_expr>(e)) return binary(le_op, x);
+  if (Ge_expr const* x = as<Ge_expr>(e)) return binary(ge_op, x);
+  return -1;
+}
+
+
+// Returns true if s is the increment i = i + 1.
+bool
+is_increment(Stmt const* s, Decl const* i)
+{
+  Assign_stmt const* a = as<Assign_stmt>(s);
+  if (!a || as_variable(a->object()) != i)
+    return false;
+  Add_expr const* e = as<Add_expr>(a->value());
+  if (!e || as_value_of(e->left()) != i)
+    return false;
+  Literal_expr const* one = as<Literal_expr>(e->right());
+  return one && one->value().is_integer() && one->value().get_integer() == 1;
+}
+
+
+// Match the statement a[i] = e or s = s + e.
+bool
+match_statement(Loop_kernel& k, Stmt const* s)
+{
+  Assign_stmt const* a = as<Assign_stmt>(s);
+  if (!a)
+    return false;
+  Kernel_matcher m {k};
+
+  // The statement a[i] = e.
+  if (Index_expr const* x = as<Index_expr>(a->object())) {
+    if (!m.is_element(x))
+      return false;
+    k.target = x->array();
+    return m.expr(a->value()) >= 0;
+  }
+
+  // The statement s = s + e.
+  Decl const* d = as_variable(a->object());
+  if (!is_integral_variable(d) || d == k.index)
+    return false;
+  Add_expr const* e = as<Add_expr>(a->value());
+  if (!e || as_value_of(e->left()) != d)
+    return false;
+  k.accum = d;
+  return m.expr(e->right()) >= 0;
+}
+
+
+} // namespace
+
+
+// Returns the kernel for the loop s. If s is not a kernel,
+// the ok flag of the result is false.
+Loop_kernel
+match_kernel(While_stmt const* s)
+{
+  Loop_kernel k;
+
+  // The condition is i < n.
+  Lt_expr const* c = as<Lt_expr>(s->condition());
+  if (!c)
+    return k;
+  Decl const* i = as_value_of(c->left());
+  if (!is_integral_variable(i) || !is<Integer_type>(i->type()))
+    return k;
+  k.index = i;
+
+  // The body is a statement followed by the increment.
+  Block_stmt const* b = as<Block_stmt>(s->body());
+  if (!b || b->statements().size() != 2)
+    return k;
+  if (!is_increment(b->statements()[1], i))
+    return k;
+  if (!match_statement(k, b->statements()[0]))
+    return k;
+
+  // The bound is invariant. It is matched last so that
+  // the accumulator is known.
+  Kernel_matcher m {k};
+  Expr const* n = c->right();
+  if (is<Literal_expr>(n))
+    k.bound = n;
+  else if (m.is_invariant(as_value_of(n)))
+    k.bound = n;
+  else
+    return k;
+
+  k.ok = true;
+  return k;
+}
+
+
+// Returns the kernel for the for loop s. The bounds of
+// the loop are evaluated before the loop, so they need
+// not be invariant.
+Loop_kernel
+match_kernel(For_stmt const* s)
+{
+  Loop_kernel k;
+  k.index = s->variable();
+
+  // The body is a single statement.
+  Stmt const* b = s->body();
+  if (Block_stmt const* bs = as<Block_stmt>(b)) {
+    if (bs->statements().size() != 1)
+      return k;
+    b = bs->statements()[0];
+  }
+  if (!match_statement(k, b))
+    return k;
+
+  k.bound = s->upper();
+  k.ok = true;
+  return k;
+}
+
+
+// Returns true if elements of kind k are integers.
+bool
+is_integer_element(Element_kind k)
+{
+  return k <= uint64_element;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Evaluation of kernels
+
+namespace
+{
+
+// The number of elements evaluated at a time.
+constexpr std::size_t block_size = 256;
+
+
+template<typename T>
+inline void
+load_block(T const* p, Integer_value* out, std::size_t n)
+{
+  for (std::size_t j = 0; j < n; ++j)
+    out[j] = p[j];
+}
+
+
+// Load n elements of the buffer starting at first.
+void
+load_block(Buffer_value b, Integer_value first, Integer_value* out, std::size_t n)
+{
+  void const* p = b.element(first);
+  switch (b.kind()) {
+    case int8_element: return load_block(static_cast<int8_t const*>(p), out, n);
+    case uint8_element: return load_block(static_cast<uint8_t const*>(p), out, n);
+    case int16_element: return load_block(static_cast<int16_t const*>(p), out, n);
+    case uint16_element: return load_block(static_cast<uint16_t const*>(p), out, n);
+    case int32_element: return load_block(static_cast<int32_t const*>(p), out, n);
+    case uint32_element: return load_block(static_cast<uint32_t const*>(p), out, n);
+    case int64_element: return load_block(static_cast<int64_t const*>(p), out, n);
+    case uint64_element: return load_block(static_cast<uint64_t const*>(p), out, n);
+    default: lingo_unreachable();
+  }
+}
+
+
+template<typename T>
+inline void
+store_block(T* p, Integer_value const* in, std::size_t n)
+{
+  for (std::size_t j = 0; j < n; ++j)
+    p[j] = in[j];
+}
+
+
+// Store n elements into the buffer starting at first.
+void
+store_block(Buffer_value b, Integer_value first, Integer_value const* in, std::size_t n)
+{
+  void* p = b.element(first);
+  switch (b.kind()) {
+    case int8_element: return store_block(static_cast<int8_t*>(p), in, n);
+    case uint8_element: return store_block(static_cast<uint8_t*>(p), in, n);
+    case int16_element: return store_block(static_cast<int16_t*>(p), in, n);
+    case uint16_element: return store_block(static_cast<uint16_t*>(p), in, n);
+    case int32_element: return store_block(static_cast<int32_t*>(p), in, n);
+    case uint32_element: return store_block(static_cast<uint32_t*>(p), in, n);
+    case int64_element: return store_block(static_cast<int64_t*>(p), in, n);
+    case uint64_element: return store_block(static_cast<uint64_t*>(p), in, n);
+    default: lingo_unreachable();
+  }
+}
+
+
+template<typename F>
+inline void
+apply_block(Integer_value const* a, Integer_value const* b, Integer_value* out, std::size_t n, F fn)
+{
+  for (std::size_t j = 0; j < n; ++j)
+    out[j] = fn(a[j], b[j]);
+}
+
+
+// Division by 0 is diagnosed before any quotient
+// is computed.
+inline void
+check_divisor(Integer_value const* b, std::size_t n)
+{
+  if (std::find(b, b + n, 0) != b + n)
+    throw std::runtime_error("division by 0");
+}
+
+
+// Evaluate each node of the kernel for the n elements
+// starting at first. The values of each node are stored
+// in consecutive blocks of the registers.
+void
+eval_block(Loop_kernel const& k, Kernel_frame const& f, Integer_value first, std::size_t n, Integer_value* regs)
+{
+  for (std::size_t i = 0; i < k.nodes.size(); ++i) {
+    Kernel_node const& x = k.nodes[i];
+    Integer_value* out = regs + i * block_size;
+    Integer_value const* a = regs + x.first * block_size;
+    Integer_value const* b = regs + x.second * block_size;
+    switch (x.op) {
+      case load_op:
+        load_block(f.arrays[x.first], first, out, n);
+        break;
+      case index_op:
+        for (std::size_t j = 0; j < n; ++j)
+          out[j] = first + j;
+        break;
+      case invariant_op:
+        std::fill(out, out + n, f.invariants[x.first]);
+        break;
+      case add_op:
+        apply_block(a, b, out, n, std::plus<Integer_value>());
+        break;
+      case sub_op:
+        apply_block(a, b, out, n, std::minus<Integer_value>());
+        break;
+      case mul_op:
+        apply_block(a, b, out, n, std::multiplies<Integer_value>());
+        break;
+      case div_op:
+        check_divisor(b, n);
+        apply_block(a, b, out, n, std::divides<Integer_value>());
+        break;
+      case rem_op:
+        check_divisor(b, n);
+        apply_block(a, b, out, n, std::modulus<Integer_value>());
+        break;
+      case eq_op:
+        apply_block(a, b, out, n, std::equal_to<Integer_value>());
+        break;
+      case ne_op:
+        apply_block(a, b, out, n, std::not_equal_to<Integer_value>());
+        break;
+      case lt_op:
+        apply_block(a, b, out, n, std::less<Integer_value>());
+        break;
+      case gt_op:
+        apply_block(a, b, out, n, std::greater<Integer_value>());
+        break;
+      case le_op:
+        apply_block(a, b, out, n, std::less_equal<Integer_value>());
+        break;
+      case ge_op:
+        apply_block(a, b, out, n, std::greater_equal<Integer_value>());
+        break;
+    }
+  }
+}
+
+
+} // namespace
+
+
+// Run a kernel that assigns to the elements of the
+// target buffer.
+void
+run_kernel(Loop_kernel const& k, Kernel_frame const& f, Buffer_value t)
+{
+  std::vector<Integer_value> regs(k.nodes.size() * block_size);
+  Integer_value const* root = regs.data() + (k.nodes.size() - 1) * block_size;
+  for (Integer_value i = f.first; i < f.last; i += block_size) {
+    std::size_t n = std::min<Integer_value>(block_size, f.last - i);
+    eval_block(k, f, i, n, regs.data());
+    store_block(t, i, root, n);
+  }
+}
+
+
+// Run a kernel that accumulates a sum, and return
+// the sum.
+Integer_value
+run_kernel(Loop_kernel const& k, Kernel_frame const& f)
+{
+  std::vector<Integer_value> regs(k.nodes.size() * block_size);
+  Integer_value const* root = regs.data() + (k.nodes.size() - 1) * block_size;
+  Integer_value sum = 0;
+  for (Integer_value i = f.first; i < f.last; i += block_size) {
+    std::size_t n = std::min<Integer_value>(block_size, f.last - i);
+    eval_block(k, f, i, n, regs.data());
+    for (std::size_t j = 0; j < n; ++j)
+      sum += root[j];
+  }
+  return sum;
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_KERNEL_HPP
+#define BEAKER_KERNEL_HPP
+
+// The kernel module recognizes simple counted loops over
+// arrays so that the evaluator can run them a block of
+// elements at a time instead of one statement at a time.
+//
+// A kernel is a loop of one of these forms:
+//
+//    while (i < n) { a[i] = e; i = i + 1; }
+//    while (i < n) { s = s + e; i = i + 1; }
+//    for i in m .. n { a[i] = e; }
+//    for i in m .. n { s = s + e; }
+//
+// where n is invariant in the while loop and e is an elementwise
+// expression. An elementwise expression is built from the
+// elements b[i] of integer arrays, the index i, invariant
+// variables, integer literals, and the arithmetic and
+// comparison operators.
+//
+// Each operation of the expression is applied to a whole
+// block of elements by a simple loop over contiguous
+// storage, which the host compiler can vectorize.
+
+#include <beaker/prelude.hpp>
+#include <beaker/value.hpp>
+
+
+// The operations of an elementwise expression.
+enum Kernel_op
+{
+  load_op,      // The element of an array
+  index_op,     // The loop index
+  invariant_op, // An invariant value
+  add_op,
+  sub_op,
+  mul_op,
+  div_op,
+  rem_op,
+  eq_op,
+  ne_op,
+  lt_op,
+  gt_op,
+  le_op,
+  ge_op,
+};
+
+
+// A node of an elementwise expression. For loads and
+// invariants, the first operand is the index of the array
+// or the invariant expression. For other operations, the
+// operands are the indexes of earlier nodes.
+struct Kernel_node
+{
+  Kernel_op op;
+  int       first;
+  int       second;
+};
+
+
+// A loop that can be evaluated as a kernel. The nodes of
+// the elementwise expression are in post-order, so the
+// last node is its root. Either the target or the
+// accumulator is non-null.
+struct Loop_kernel
+{
+  using Expr_list = std::vector<Expr const*>;
+
+  bool                     ok = false;
+  Decl const*              index = nullptr;  // The loop variable
+  Expr const*              bound = nullptr;  // The upper bound
+  Expr const*              target = nullptr; // The array assigned to
+  Decl const*              accum = nullptr;  // The accumulator
+  Expr_list                arrays;           // The arrays read
+  Expr_list                invariants;       // The invariant values
+  std::vector<Kernel_node> nodes;
+};
+
+
+// The values used by one run of a kernel.
+struct Kernel_frame
+{
+  Integer_value              first; // The first index
+  Integer_value              last;  // One past the last index
+  std::vector<Buffer_value>  arrays;
+  std::vector<Integer_value> invariants;
+};
+
+
+Loop_kernel   match_kernel(While_stmt const*);
+Loop_kernel   match_kernel(For_stmt const*);
+void          run_kernel(Loop_kernel const&, Kernel_frame const&, Buffer_value);
+Integer_value run_kernel(Loop_kernel const&, Kernel_frame const&);
+
+bool is_integer_element(Element_kind);
+
+
+#endif
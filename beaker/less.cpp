@@ -103,6 +103,7 @@ is_less(Type const* a, Type const* b)
     bool operator()(Double_type const* a) { return false; }
     bool operator()(Function_type const* a) { return is_less(a, cast<Function_type>(b)); }
     bool operator()(Array_type const* a) { return is_less(a, cast<Array_type>(b)); }
+    bool operator()(Vector_type const* a) { return is_less(a, cast<Vector_type>(b)); }
     bool operator()(Block_type const* a) { return is_less(a, cast<Block_type>(b)); }
     bool operator()(Reference_type const* a) { return is_less(a, cast<Reference_type>(b)); }
     bool operator()(Record_type const* a) { return is_less(a, cast<Record_type>(b)); }
@@ -162,16 +163,48 @@ bool
 is_less(Array_value const& a, Array_value const& b)
 { 
   auto cmp = [](Value const& x, Value const& y) { return is_less(x, y); };
-  return std::lexicographical_compare(a.data, a.data + a.len,
-                                      b.data, b.data + b.len, cmp);
+  return std::lexicographical_compare(a.data(), a.data() + a.len(),
+                                      b.data(), b.data() + b.len(), cmp);
 }
 
 bool
 is_less(Tuple_value const& a, Tuple_value const& b)
 { 
   auto cmp = [](Value const& x, Value const& y) { return is_less(x, y); };
-  return std::lexicographical_compare(a.data, a.data + a.len,
-                                      b.data, b.data + b.len, cmp);
+  return std::lexicographical_compare(a.data(), a.data() + a.len(),
+                                      b.data(), b.data() + b.len(), cmp);
+}
+
+// Buffers are compared element-wise.
+bool
+is_less(Buffer_value const& a, Buffer_value const& b)
+{
+  for (std::size_t i = 0; i < std::min(a.len(), b.len()); ++i) {
+    Value x = load(a.kind(), a.element(i));
+    Value y = load(b.kind(), b.element(i));
+    if (is_less(x, y))
+      return true;
+    if (is_less(y, x))
+      return false;
+  }
+  return a.len() < b.len();
+}
+
+// Element references are compared by address.
+bool
+is_less(Element_value const& a, Element_value const& b)
+{
+  std::less<void*> cmp;
+  return cmp(a.addr, b.addr);
+}
+
+// Strings in the pool are unique, but compare their
+// contents so that the order does not depend on the
+// order of allocation.
+bool
+is_less(String_value const& a, String_value const& b)
+{
+  return *a < *b;
 }
 
 // FIXME: Use a visitor for values. Also, push this into
@@ -189,6 +222,9 @@ is_less(Value const& a, Value const& b)
     bool operator()(Reference_value const& a) const  { return is_less(a, b.get_reference()); }
     bool operator()(Array_value const& a) const  { return is_less(a, b.get_array()); }
     bool operator()(Tuple_value const& a) const { return is_less(a, b.get_tuple()); }
+    bool operator()(String_value const& a) const { return is_less(a, b.get_string()); }
+    bool operator()(Buffer_value const& a) const { return is_less(a, b.get_buffer()); }
+    bool operator()(Element_value const& a) const { return is_less(a, b.get_element()); }
   };
 
   if (a.kind() < b.kind())
@@ -253,6 +289,9 @@ is_less(Expr const* a, Expr const* b)
     bool operator()(Field_expr const* a) { lingo_unreachable(); }
     bool operator()(Method_expr const* a) { lingo_unreachable(); }
     bool operator()(Index_expr const* a) { lingo_unreachable(); }
+    bool operator()(Vector_expr const* a) { lingo_unreachable(); }
+    bool operator()(Shuffle_expr const* a) { lingo_unreachable(); }
+    bool operator()(Reduce_expr const* a) { lingo_unreachable(); }
     bool operator()(Value_conv const* a) { lingo_unreachable(); }
     bool operator()(Block_conv const* a) { lingo_unreachable(); }
     bool operator()(Base_conv const* a) { lingo_unreachable(); }
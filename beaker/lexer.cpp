@@ -268,9 +268,9 @@ Lexer::on_character()
   int rep;
   char const* p = str.c_str();
   if (*++p == '\\')
-    rep = *p;
-  else
     rep = translate_escape(*++p);
+  else
+    rep = *p;
   Symbol* sym = syms_.put<Character_sym>(str, character_tok, rep);
 
   return Token(loc_, character_tok, sym);
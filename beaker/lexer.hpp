@@ -103,6 +103,18 @@ Input_buffer::peek() const
 }
 
 
+// Returns the character n positions past the current
+// character, or 0 if that is past the end of the input.
+inline char
+Input_buffer::peek(int n) const
+{
+  if (buf_.end() - pos_ <= n)
+    return 0;
+  else
+    return pos_[n];
+}
+
+
 // Returns the current line number.
 inline int
 Input_buffer::line_no() const
@@ -359,7 +371,12 @@ Lexer::semicolon()
 inline Token
 Lexer::dot()
 {
-  return symbol1();
+  assert(peek() == '.');
+  get();
+  if (peek() == '.')
+    return symbol1();
+  else
+    return symbol0();
 }
 
 
@@ -506,6 +523,9 @@ Lexer::word()
 // integer ::= digit+
 // decimal ::= digit*.digit+
 //
+// An integer followed by '..' is the start of a range,
+// not a decimal.
+//
 // FIXME: Support real decimal formats.
 inline Token
 Lexer::number()
@@ -514,7 +534,7 @@ Lexer::number()
   digit();
   while (is_decimal_digit(peek()))
     digit();
-  if (peek() == '.') {
+  if (peek() == '.' && peek(1) != '.') {
     get();
     while (is_decimal_digit(peek()))
       digit();
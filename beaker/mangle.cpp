@@ -89,6 +89,16 @@ mangle(std::ostream& os, Array_type const* t)
 }
 
 
+// 'V' n t
+void
+mangle(std::ostream& os, Vector_type const* t)
+{
+  os << 'V';
+  os << t->size() << '_';
+  mangle(os, t->type());
+}
+
+
 // 'B' t
 void
 mangle(std::ostream& os, Block_type const* t)
@@ -131,6 +141,7 @@ mangle(std::ostream& os, Type const* t)
     void operator()(Double_type const* t) { return mangle(os, t); }
     void operator()(Function_type const* t) { return mangle(os, t); }
     void operator()(Array_type const* t) { return mangle(os, t); }
+    void operator()(Vector_type const* t) { return mangle(os, t); }
     void operator()(Block_type const* t) { return mangle(os, t); }
     void operator()(Reference_type const* t) { return mangle(os, t); }
     void operator()(Record_type const* t) { return mangle(os, t); }
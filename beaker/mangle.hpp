@@ -22,6 +22,7 @@ void mangle(std::ostream&, Float_type const*);
 void mangle(std::ostream&, Double_type const*);
 void mangle(std::ostream&, Function_type const*);
 void mangle(std::ostream&, Array_type const*);
+void mangle(std::ostream&, Vector_type const*);
 void mangle(std::ostream&, Block_type const*);
 void mangle(std::ostream&, Reference_type const*);
 void mangle(std::ostream&, Record_type const*);
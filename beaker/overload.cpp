@@ -59,3 +59,15 @@ can_overload(Decl const* d1, Decl const* d2)
   return true;
 }
 
+
+// Combine the addresses of the overload set and the
+// argument types.
+std::size_t
+Resolution_hash::operator()(Resolution_key const& k) const
+{
+  std::hash<void const*> h;
+  std::size_t n = h(k.ovl) ^ k.size;
+  for (Type const* t : k.args)
+    n = n * 31 + h(t);
+  return n;
+}
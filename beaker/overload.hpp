@@ -6,6 +6,8 @@
 
 #include <beaker/prelude.hpp>
 
+#include <unordered_map>
+
 
 // Represents a set of overloaded declarations. All
 // declarations have the same name, scope, and kind,
@@ -20,4 +22,40 @@ struct Overload : std::vector<Decl*>
 
 bool can_overload(Decl const*, Decl const*);
 
+
+// -------------------------------------------------------------------------- //
+// Resolution cache
+
+// The result of overload resolution depends only on the
+// overload set and the types of the arguments. Types are
+// unique, so they can be compared by address.
+//
+// The size of the overload set is part of the key so
+// that adding a declaration to the set invalidates
+// earlier resolutions.
+struct Resolution_key
+{
+  Overload const* ovl;
+  std::size_t     size;
+  Type_seq        args;
+};
+
+
+inline bool
+operator==(Resolution_key const& a, Resolution_key const& b)
+{
+  return a.ovl == b.ovl && a.size == b.size && a.args == b.args;
+}
+
+
+struct Resolution_hash
+{
+  std::size_t operator()(Resolution_key const&) const;
+};
+
+
+// Maps resolved calls to the selected function.
+using Resolution_cache =
+  std::unordered_map<Resolution_key, Function_decl*, Resolution_hash>;
+
 #endif
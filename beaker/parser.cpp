@@ -8,7 +8,9 @@
 #include "beaker/decl.hpp"
 #include "beaker/stmt.hpp"
 #include "beaker/error.hpp"
+#include "beaker/interface.hpp"
 
+#include <fstream>
 #include <iostream>
 #include <sstream>
 
@@ -16,6 +18,7 @@
 // Parse a primary expression.
 //
 //    primary-expr -> literal | identifier | '(' expr ')'
+//                  | vector-expr | shuffle-expr | reduce-expr
 //
 //    literal -> integer-literal
 //             | boolean-literal
@@ -48,6 +51,18 @@ Parser::primary_expr()
   if (Token tok = match_if(string_tok))
     return on_str(tok);
 
+  // vector-expr
+  if (lookahead() == vec_kw)
+    return vector_expr();
+
+  // shuffle-expr
+  if (lookahead() == shuffle_kw)
+    return shuffle_expr();
+
+  // reduce-expr
+  if (lookahead() == reduce_kw)
+    return reduce_expr();
+
   // NOTE NOTE NOTE
   // Lambda additions
   if (lookahead() == f_slash_tok)
@@ -67,6 +82,71 @@ Parser::primary_expr()
 
 
 
+// Parse a vector expression.
+//
+//    vector-expr -> vector-type '(' expr-list ')'
+Expr*
+Parser::vector_expr()
+{
+  Type const* t = vector_type();
+  match(lparen_tok);
+  Expr_seq args;
+  while (lookahead() != rparen_tok) {
+    args.push_back(expr());
+    if (match_if(comma_tok))
+      continue;
+    else
+      break;
+  }
+  match(rparen_tok);
+  return on_vector(t, args);
+}
+
+
+// Parse a shuffle expression.
+//
+//    shuffle-expr -> 'shuffle' '(' expr ',' expr-list ')'
+Expr*
+Parser::shuffle_expr()
+{
+  require(shuffle_kw);
+  match(lparen_tok);
+  Expr* e = expr();
+  Expr_seq ix;
+  while (match_if(comma_tok))
+    ix.push_back(expr());
+  match(rparen_tok);
+  return on_shuffle(e, ix);
+}
+
+
+// Parse a reduction.
+//
+//    reduce-expr -> 'reduce' '(' reduce-op ',' expr ')'
+//
+//    reduce-op -> '+' | '*' | '<' | '>' | '&&' | '||'
+Expr*
+Parser::reduce_expr()
+{
+  require(reduce_kw);
+  match(lparen_tok);
+  Reduction r;
+  switch (lookahead()) {
+    case plus_tok: r = sum_reduction; break;
+    case star_tok: r = product_reduction; break;
+    case lt_tok: r = min_reduction; break;
+    case gt_tok: r = max_reduction; break;
+    case and_tok: r = all_reduction; break;
+    case or_tok: r = any_reduction; break;
+    default: error("expected reduction operator");
+  }
+  accept();
+  match(comma_tok);
+  Expr* e = expr();
+  match(rparen_tok);
+  return on_reduce(r, e);
+}
+
 
 // Parse a postfix expression.
 //
@@ -347,6 +427,7 @@ Parser::expr()
 //                  | 'int'
 //                  | 'char'
 //                  | id-type
+//                  | vector-type
 //                  | function-type
 //
 //    function-type -> '(' type-list ')' '->' type
@@ -423,6 +504,10 @@ Parser::primary_type()
   else if (match_if(double_kw))
       return get_double_type();
 
+  // vector-type
+  else if (lookahead() == vec_kw)
+    return vector_type();
+
   // function-type
   else if (match_if(lparen_tok)) {
     Type_seq ts;
@@ -447,6 +532,25 @@ Parser::primary_type()
 }
 
 
+// Parse a vector type.
+//
+//    vector-type -> 'vec' '<' type ',' additive-expr '>'
+//
+// The extent is an additive expression so that the
+// closing '>' is not parsed as an operator.
+Type const*
+Parser::vector_type()
+{
+  require(vec_kw);
+  match(lt_tok);
+  Type const* t = type();
+  match(comma_tok);
+  Expr* n = additive_expr();
+  match(gt_tok);
+  return on_vector_type(t, n);
+}
+
+
 // Parse a postfix type.
 //
 //    postfix-type -> primary_type
@@ -851,18 +955,131 @@ Parser::if_stmt()
 }
 
 
+// Parse a switch statement.
+//
+//    switch-stmt -> 'switch' '(' expr ')' '{' case-seq '}'
+//
+//    case -> case-label-seq stmt-seq
+//          | 'default' ':' stmt-seq
+//
+//    case-label -> 'case' expr-list ':'
+//
+// The statements of a case extend to the next case or to
+// the end of the switch. Consecutive labels share the
+// statements that follow them.
+Stmt*
+Parser::switch_stmt()
+{
+  require(switch_kw);
+  match(lparen_tok);
+  Expr* e = expr();
+  match(rparen_tok);
+  match(lbrace_tok);
+  Case_seq cases;
+  Stmt* def = nullptr;
+  while (lookahead() != rbrace_tok) {
+    if (match_if(default_kw)) {
+      if (def)
+        error("multiple default cases");
+      match(colon_tok);
+      def = case_body();
+      continue;
+    }
+    Expr_seq labels;
+    do {
+      match(case_kw);
+      do
+        labels.push_back(expr());
+      while (match_if(comma_tok));
+      match(colon_tok);
+    } while (lookahead() == case_kw);
+    cases.emplace_back(labels, case_body());
+  }
+  match(rbrace_tok);
+  return on_switch(e, cases, def);
+}
+
+
+// Parse the statements of a case.
+//
+//    stmt-seq -> stmt*
+Stmt*
+Parser::case_body()
+{
+  Stmt_seq stmts;
+  while (lookahead() != case_kw && lookahead() != default_kw && lookahead() != rbrace_tok)
+    stmts.push_back(stmt());
+  return on_block(stmts);
+}
+
+
+// Parse an optional loop hint, returning true if the
+// loop is to be vectorized.
+//
+//    loop-hint -> '[' 'vectorize' ']'
+bool
+Parser::loop_hint()
+{
+  if (match_if(lbrack_tok)) {
+    Token tok = match(identifier_tok);
+    if (tok.spelling() != "vectorize")
+      error("unknown loop hint");
+    match(rbrack_tok);
+    return true;
+  }
+  return false;
+}
+
+
 // Parse a while statement.
 //
-//    while -> 'while' '(' expr ')' stmt
+//    while -> 'while' [loop-hint] '(' expr ')' stmt
 Stmt*
 Parser::while_stmt()
 {
   require(while_kw);
+  bool vec = loop_hint();
   match(lparen_tok);
   Expr* e = expr();
   match(rparen_tok);
   Stmt* s = stmt();
-  return on_while(e, s);
+  return on_while(e, s, vec);
+}
+
+
+// Parse a for statement.
+//
+//    for-stmt -> 'for' [loop-hint] identifier 'in' expr '..' expr stmt
+Stmt*
+Parser::for_stmt()
+{
+  require(for_kw);
+  bool vec = loop_hint();
+  Token n = match(identifier_tok);
+  match(in_kw);
+  Expr* e1 = expr();
+  match(dot_dot_tok);
+  Expr* e2 = expr();
+  Stmt* s = stmt();
+  return on_for(n, e1, e2, s, vec);
+}
+
+
+// Parse a parallel for statement.
+//
+//    parallel-for-stmt -> 'parallel' 'for' identifier 'in' expr '..' expr stmt
+Stmt*
+Parser::parallel_for_stmt()
+{
+  require(parallel_kw);
+  match(for_kw);
+  Token n = match(identifier_tok);
+  match(in_kw);
+  Expr* e1 = expr();
+  match(dot_dot_tok);
+  Expr* e2 = expr();
+  Stmt* s = stmt();
+  return on_parallel_for(n, e1, e2, s);
 }
 
 
@@ -945,9 +1162,18 @@ Parser::stmt()
     case if_kw:
       return if_stmt();
 
+    case switch_kw:
+      return switch_stmt();
+
     case while_kw:
       return while_stmt();
 
+    case for_kw:
+      return for_stmt();
+
+    case parallel_kw:
+      return parallel_for_stmt();
+
     case break_kw:
       return break_stmt();
 
@@ -970,12 +1196,28 @@ Parser::stmt()
 // Top level parsing
 
 
+// Parse an import declaration. This returns the
+// declarations of the imported module.
+//
+//    import-decl -> 'import' identifier ';'
+Decl_seq
+Parser::import_decl()
+{
+  require(import_kw);
+  Token n = match(identifier_tok);
+  match(semicolon_tok);
+  return on_import(n);
+}
+
+
 // Parse a module.
 //
 //    module -> decl-seq | <empty>
 //
 //    decl-seq -> decl | decl-seq
 //
+//    decl -> import-decl
+//
 // TODO: Return an empty module.
 Decl*
 Parser::module(Module_decl* m)
@@ -983,6 +1225,11 @@ Parser::module(Module_decl* m)
   Decl_seq decls;
   while (!ts_.eof()) {
     try {
+      if (lookahead() == import_kw) {
+        Decl_seq ds = import_decl();
+        decls.insert(decls.end(), ds.begin(), ds.end());
+        continue;
+      }
       Decl* d = decl();
       decls.push_back(d);
     } catch (Translation_error& err) {
@@ -1114,6 +1361,13 @@ Parser::on_array_type(Type const* t , Expr* n)
 }
 
 
+Type const*
+Parser::on_vector_type(Type const* t, Expr* n)
+{
+  return get_vector_type(t, n);
+}
+
+
 // TODO: Ensure that we can actually construt
 // a array-of-T.
 Type const*
@@ -1176,18 +1430,16 @@ Parser::on_char(Token tok)
 Expr*
 Parser::on_str(Token tok)
 {
-  // Build the string value.
+  // Build the string value. The string refers to
+  // the spelling in the symbol table.
   String_sym const* s = tok.string_symbol();
-  Array_value v {
-     s->value().c_str(),
-     s->value().size()
-  };
+  String_value v = &s->value();
 
   // Create the extent of the literal array. This is
   // explicitly more than the length of the string,
   // and includes the null character.
   Type const* z = get_integer_type();
-  Expr* n = new Literal_expr(z, v.len + 1);
+  Expr* n = new Literal_expr(z, v->size() + 1);
 
   // Create the array type.
   Type const* c = get_character_type();
@@ -1328,6 +1580,27 @@ Parser::on_dot(Expr* e1, Expr* e2)
   return new Dot_expr(e1, e2);
 }
 
+
+Expr*
+Parser::on_vector(Type const* t, Expr_seq const& a)
+{
+  return new Vector_expr(t, a);
+}
+
+
+Expr*
+Parser::on_shuffle(Expr* e, Expr_seq const& ix)
+{
+  return new Shuffle_expr(e, ix);
+}
+
+
+Expr*
+Parser::on_reduce(Reduction r, Expr* e)
+{
+  return new Reduce_expr(r, e);
+}
+
 // NOTE NOTE NOTE
 // ADDITIONS FOR LAMBDAS
 //Lambda_expr(Symbol * s, Decl_seq const& d, Type const * t, Stmt* const& b)
@@ -1441,11 +1714,36 @@ Parser::on_field(Specifier spec, Token n, Type const* t)
 }
 
 
+// Read the interface of the module n from the file
+// n.bki in the current directory. The import has
+// already been parsed, so errors are diagnosed here
+// rather than recovered from by the caller.
+Decl_seq
+Parser::on_import(Token n)
+{
+  String path = n.spelling() + ".bki";
+  std::ifstream ifs(path, std::ios::binary);
+  String msg = format("cannot open module interface '{}'", path);
+  if (ifs) {
+    try {
+      return read_interface(ifs, syms_);
+    } catch (std::runtime_error&) {
+      msg = format("invalid module interface '{}'", path);
+    }
+  }
+  Syntax_error err(n.location(), msg);
+  diagnose(err);
+  ++errs_;
+  return {};
+}
+
+
 // Append the parsed declarations to the module.
 // This returns the module m.
 Decl*
 Parser::on_module(Module_decl* m, Decl_seq const& d)
 {
+  lingo_assert(!m->is_frozen());
   Decl_seq& d0 = m->decls_;
   d0.insert(d0.end(), d.begin(), d.end());
   return m;
@@ -1495,9 +1793,35 @@ Parser::on_if_else(Expr* e, Stmt* s1, Stmt* s2)
 
 
 Stmt*
-Parser::on_while(Expr* c, Stmt* s)
+Parser::on_switch(Expr* e, Case_seq const& cs, Stmt* d)
+{
+  return new Switch_stmt(e, cs, d);
+}
+
+
+Stmt*
+Parser::on_while(Expr* c, Stmt* s, bool v)
+{
+  return new While_stmt(c, s, v);
+}
+
+
+// The loop variable is an int, which is assigned before
+// each iteration of the loop.
+Stmt*
+Parser::on_for(Token n, Expr* e1, Expr* e2, Stmt* s, bool v)
+{
+  Decl* d = on_variable(no_spec, n, get_integer_type(), trivial_kw);
+  return new For_stmt(cast<Variable_decl>(d), e1, e2, s, v);
+}
+
+
+// As above, the loop variable is an int.
+Stmt*
+Parser::on_parallel_for(Token n, Expr* e1, Expr* e2, Stmt* s)
 {
-  return new While_stmt(c, s);
+  Decl* d = on_variable(no_spec, n, get_integer_type(), trivial_kw);
+  return new Parallel_for_stmt(cast<Variable_decl>(d), e1, e2, s);
 }
 
 
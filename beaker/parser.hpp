@@ -7,6 +7,7 @@
 
 #include <beaker/prelude.hpp>
 #include <beaker/decl.hpp>
+#include <beaker/expr.hpp>
 #include <beaker/specifier.hpp>
 #include <beaker/token.hpp>
 
@@ -29,6 +30,9 @@ public:
   Expr* lambda_expr();
 
   Expr* call_expr();
+  Expr* vector_expr();
+  Expr* shuffle_expr();
+  Expr* reduce_expr();
   Expr* postfix_expr();
   Expr* unary_expr();
   Expr* multiplicative_expr();
@@ -41,6 +45,7 @@ public:
 
   // Type parsers
   Type const* primary_type();
+  Type const* vector_type();
   Type const* postfix_type();
   Type const* type();
 
@@ -64,13 +69,19 @@ public:
   Stmt* block_stmt();
   Stmt* return_stmt();
   Stmt* if_stmt();
+  Stmt* switch_stmt();
+  Stmt* case_body();
   Stmt* while_stmt();
+  bool  loop_hint();
+  Stmt* for_stmt();
+  Stmt* parallel_for_stmt();
   Stmt* break_stmt();
   Stmt* continue_stmt();
   Stmt* declaration_stmt();
   Stmt* expression_stmt();
 
   // Top-level.
+  Decl_seq import_decl();
   Decl* module(Module_decl*);
 
   // Parse state
@@ -83,6 +94,7 @@ private:
   Type const* on_id_type(Token);
   Type const* on_reference_type(Type const*);
   Type const* on_array_type(Type const*, Expr*);
+  Type const* on_vector_type(Type const*, Expr*);
   Type const* on_block_type(Type const*);
   Type const* on_function_type(Type_seq const&, Type const*);
 
@@ -111,6 +123,9 @@ private:
   Expr* on_call(Expr*, Expr_seq const&);
   Expr* on_index(Expr*, Expr*);
   Expr* on_dot(Expr*, Expr*);
+  Expr* on_vector(Type const*, Expr_seq const&);
+  Expr* on_shuffle(Expr*, Expr_seq const&);
+  Expr* on_reduce(Reduction, Expr*);
   // NOTE NOTE NOTE
   // LAMBDA ADDITIONS
   Expr* on_lambda(Token, Decl_seq const&, Type const*, Stmt* );
@@ -130,6 +145,7 @@ private:
   //refence on_method for implementation
   //Decl* on_ctor(Specifier, Token, Decl_seq const&, Type const* Stmt*);
   //Decl* on_dtor(Specifier, Token, Decl_seq const&, Type const* Stmt*);
+  Decl_seq on_import(Token);
   Decl* on_module(Module_decl*, Decl_seq const&);
 
   // FIXME: Remove _stmt from handlers.
@@ -139,7 +155,10 @@ private:
   Stmt* on_return(Expr*);
   Stmt* on_if_then(Expr*, Stmt*);
   Stmt* on_if_else(Expr*, Stmt*, Stmt*);
-  Stmt* on_while(Expr*, Stmt*);
+  Stmt* on_switch(Expr*, Case_seq const&, Stmt*);
+  Stmt* on_while(Expr*, Stmt*, bool);
+  Stmt* on_for(Token, Expr*, Expr*, Stmt*, bool);
+  Stmt* on_parallel_for(Token, Expr*, Expr*, Stmt*);
   Stmt* on_break();
   Stmt* on_continue();
   Stmt* on_expression(Expr*);
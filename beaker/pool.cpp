@@ -0,0 +1,192 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/pool.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+
+namespace
+{
+
+// The number of chunks dealt to each thread. More chunks
+// balance uneven iterations better, but cost more to
+// schedule.
+constexpr Integer_value chunks_per_thread = 8;
+
+
+// True for the threads of a pool, and for a thread that
+// is running a parallel loop.
+thread_local bool in_loop = false;
+
+
+} // namespace
+
+
+// Create a pool of n threads, including the thread that
+// runs loops. A pool of one thread runs every loop on the
+// calling thread.
+Thread_pool::Thread_pool(int n)
+  : remaining(0), failed(false)
+{
+  n = std::max(n, 1);
+  for (int i = 0; i < n; ++i)
+    queues.emplace_back(new Queue());
+  for (int i = 1; i < n; ++i)
+    workers.emplace_back([this, i]() { work(i); });
+}
+
+
+Thread_pool::~Thread_pool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  wake.notify_all();
+  for (std::thread& t : workers)
+    t.join();
+}
+
+
+// Call fn on the chunks of the range [first, last). If
+// fn throws an exception, the remaining chunks are
+// skipped, and the exception is rethrown once the loop
+// has finished.
+void
+Thread_pool::run(Integer_value first, Integer_value last, Body const& fn)
+{
+  if (first >= last)
+    return;
+
+  // Run the loop on this thread if there is no one to
+  // share it with.
+  std::unique_lock<std::mutex> lock(busy, std::defer_lock);
+  if (size() == 1 || in_loop || !lock.try_lock()) {
+    fn(first, last);
+    return;
+  }
+
+  // The body is published before any chunk is queued,
+  // so that a thread that steals a chunk sees it.
+  Integer_value n = last - first;
+  Integer_value grain = std::max<Integer_value>(1, n / (size() * chunks_per_thread));
+  remaining = n;
+  failed = false;
+  error = nullptr;
+  {
+    std::lock_guard<std::mutex> l(mutex);
+    body = &fn;
+  }
+  int q = 0;
+  for (Integer_value i = first; i < last; i += grain) {
+    Queue& queue = *queues[q];
+    std::lock_guard<std::mutex> l(queue.mutex);
+    queue.ranges.push_back({i, std::min(i + grain, last)});
+    q = (q + 1) % size();
+  }
+  {
+    std::lock_guard<std::mutex> l(mutex);
+    ++loop;
+  }
+  wake.notify_all();
+
+  // Take part in the loop, and then wait for the chunks
+  // that are still running on other threads.
+  in_loop = true;
+  execute(0);
+  in_loop = false;
+  {
+    std::unique_lock<std::mutex> l(mutex);
+    done.wait(l, [this]() { return remaining == 0; });
+    body = nullptr;
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
+
+// The main loop of a worker thread.
+void
+Thread_pool::work(int id)
+{
+  in_loop = true;
+  std::size_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [&]() { return stop || loop != seen; });
+      if (stop)
+        return;
+      seen = loop;
+    }
+    execute(id);
+  }
+}
+
+
+// Run chunks until there are none left to take.
+void
+Thread_pool::execute(int id)
+{
+  Iteration_range r;
+  while (next(id, r)) {
+    if (!failed) {
+      try {
+        (*body)(r.first, r.last);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error)
+          error = std::current_exception();
+        failed = true;
+      }
+    }
+    if ((remaining -= r.last - r.first) == 0) {
+      std::lock_guard<std::mutex> lock(mutex);
+      done.notify_all();
+    }
+  }
+}
+
+
+// Take the next chunk for the thread id, from its own
+// queue if possible, and otherwise from another.
+bool
+Thread_pool::next(int id, Iteration_range& r)
+{
+  {
+    Queue& q = *queues[id];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (!q.ranges.empty()) {
+      r = q.ranges.back();
+      q.ranges.pop_back();
+      return true;
+    }
+  }
+  for (int i = 1; i < size(); ++i) {
+    Queue& q = *queues[(id + i) % size()];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (!q.ranges.empty()) {
+      r = q.ranges.front();
+      q.ranges.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+
+// Returns the pool used by the interpreter. It has one
+// thread per processor, unless the BEAKER_THREADS
+// environment variable gives another number.
+Thread_pool&
+parallel_pool()
+{
+  static Thread_pool pool([]() {
+    if (char const* s = std::getenv("BEAKER_THREADS"))
+      return std::atoi(s);
+    return int(std::thread::hardware_concurrency());
+  }());
+  return pool;
+}
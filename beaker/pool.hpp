@@ -0,0 +1,84 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_POOL_HPP
+#define BEAKER_POOL_HPP
+
+// The pool module provides the threads on which the
+// interpreter runs the iterations of parallel loops.
+//
+// The iterations of a loop are divided into chunks,
+// which are dealt to a queue for each thread. A thread
+// takes chunks from the back of its own queue, and when
+// that is empty, steals chunks from the front of the
+// queues of other threads. The thread that runs a loop
+// takes part in it, and returns when every iteration
+// has finished.
+//
+// A loop that is started while another is running (for
+// example, a nested parallel loop, or a loop in another
+// engine) runs on the calling thread.
+
+#include <beaker/prelude.hpp>
+#include <beaker/value.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+// A half-open range of loop iterations.
+struct Iteration_range
+{
+  Integer_value first;
+  Integer_value last;
+};
+
+
+class Thread_pool
+{
+public:
+  using Body = std::function<void(Integer_value, Integer_value)>;
+
+  explicit Thread_pool(int);
+  ~Thread_pool();
+
+  int  size() const { return queues.size(); }
+  void run(Integer_value, Integer_value, Body const&);
+
+private:
+  struct Queue
+  {
+    std::mutex                  mutex;
+    std::deque<Iteration_range> ranges;
+  };
+
+  void work(int);
+  void execute(int);
+  bool next(int, Iteration_range&);
+
+  std::vector<std::unique_ptr<Queue>> queues; // Queue 0 belongs to the caller
+  std::vector<std::thread>            workers;
+
+  std::mutex                 mutex;     // Guards the state of the loop
+  std::condition_variable    wake;      // Signals the start of a loop
+  std::condition_variable    done;      // Signals the end of a loop
+  std::mutex                 busy;      // Held while a loop runs
+  Body const*                body = nullptr;
+  std::size_t                loop = 0;  // Counts the loops started
+  std::atomic<Integer_value> remaining; // Iterations not yet finished
+  std::atomic<bool>          failed;    // True if an iteration threw
+  std::exception_ptr         error;     // The first exception thrown
+  bool                       stop = false;
+};
+
+
+Thread_pool& parallel_pool();
+
+
+#endif
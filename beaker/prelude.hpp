@@ -57,6 +57,9 @@ struct Dot_expr;
 struct Field_expr;
 struct Method_expr;
 struct Index_expr;
+struct Vector_expr;
+struct Shuffle_expr;
+struct Reduce_expr;
 
 struct Conv;
 struct Value_conv;
@@ -79,6 +82,7 @@ struct Float_type;
 struct Double_type;
 struct Function_type;
 struct Array_type;
+struct Vector_type;
 struct Block_type;
 struct Reference_type;
 struct Record_type;
@@ -99,17 +103,22 @@ struct Assign_stmt;
 struct Return_stmt;
 struct If_then_stmt;
 struct If_else_stmt;
+struct Switch_stmt;
 struct While_stmt;
+struct For_stmt;
+struct Parallel_for_stmt;
 struct Break_stmt;
 struct Continue_stmt;
 struct Expression_stmt;
 struct Declaration_stmt;
+struct Switch_case;
 
 
 using Expr_seq = std::vector<Expr*>;
 using Type_seq = std::vector<Type const*>;
 using Decl_seq = std::vector<Decl*>;
 using Stmt_seq = std::vector<Stmt*>;
+using Case_seq = std::vector<Switch_case>;
 
 
 #include <beaker/symbol.hpp> // TODO: Do I need this?
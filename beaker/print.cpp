@@ -28,6 +28,7 @@ operator<<(std::ostream& os, Type const& t)
     void operator()(Function_type const* t) { os << *t; }
     void operator()(Block_type const* t) { os << *t; }
     void operator()(Array_type const* t) { os << *t; }
+    void operator()(Vector_type const* t) { os << *t; }
     void operator()(Reference_type const* t) { os << *t; }
     void operator()(Record_type const* t) { os << *t; }
   };
@@ -98,6 +99,13 @@ operator<<(std::ostream& os, Array_type const& t)
 }
 
 
+std::ostream&
+operator<<(std::ostream& os, Vector_type const& t)
+{
+  return os << "vec<" << *t.type() << ", " << *t.extent() << '>';
+}
+
+
 std::ostream&
 operator<<(std::ostream& os, Block_type const& t)
 {
@@ -155,6 +163,9 @@ operator<<(std::ostream& os, Expr const& e)
     void operator()(Field_expr const* e) { os << *e; }
     void operator()(Method_expr const* e) { os << *e; }
     void operator()(Index_expr const* e) { os << *e; }
+    void operator()(Vector_expr const* e) { os << *e; }
+    void operator()(Shuffle_expr const* e) { os << *e; }
+    void operator()(Reduce_expr const* e) { os << *e; }
     void operator()(Value_conv const* e) { os << *e; }
     void operator()(Block_conv const* e) { os << *e; }
     void operator()(Base_conv const* e) { os << *e; }
@@ -344,6 +355,38 @@ operator<<(std::ostream& os, Index_expr const& e)
 }
 
 
+std::ostream&
+operator<<(std::ostream& os, Vector_expr const& e)
+{
+  os << *e.type() << '(';
+  Expr_seq const& es = e.elements();
+  for (auto iter = es.begin(); iter != es.end(); ++iter) {
+    os << **iter;
+    if (std::next(iter) != es.end())
+      os << ',';
+  }
+  return os << ')';
+}
+
+
+std::ostream&
+operator<<(std::ostream& os, Shuffle_expr const& e)
+{
+  os << "shuffle(" << *e.vector();
+  for (Expr const* i : e.indexes())
+    os << ',' << *i;
+  return os << ')';
+}
+
+
+std::ostream&
+operator<<(std::ostream& os, Reduce_expr const& e)
+{
+  static char const* ops[] = { "+", "*", "<", ">", "&&", "||" };
+  return os << "reduce(" << ops[e.reduction()] << ',' << *e.operand() << ')';
+}
+
+
 std::ostream&
 operator<<(std::ostream& os, Value_conv const& e)
 {
@@ -18,6 +18,7 @@ std::ostream& operator<<(std::ostream&, Double_type const&);
 std::ostream& operator<<(std::ostream&, Function_type const&);
 std::ostream& operator<<(std::ostream&, Block_type const&);
 std::ostream& operator<<(std::ostream&, Array_type const&);
+std::ostream& operator<<(std::ostream&, Vector_type const&);
 std::ostream& operator<<(std::ostream&, Reference_type const&);
 std::ostream& operator<<(std::ostream&, Record_type const&);
 
@@ -47,6 +48,9 @@ std::ostream& operator<<(std::ostream&, Dot_expr const&);
 std::ostream& operator<<(std::ostream&, Field_expr const&);
 std::ostream& operator<<(std::ostream&, Method_expr const&);
 std::ostream& operator<<(std::ostream&, Index_expr const&);
+std::ostream& operator<<(std::ostream&, Vector_expr const&);
+std::ostream& operator<<(std::ostream&, Shuffle_expr const&);
+std::ostream& operator<<(std::ostream&, Reduce_expr const&);
 std::ostream& operator<<(std::ostream&, Value_conv const&);
 std::ostream& operator<<(std::ostream&, Block_conv const&);
 std::ostream& operator<<(std::ostream&, Promote_conv const&);
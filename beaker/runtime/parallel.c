@@ -0,0 +1,138 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// The parallel runtime runs the parallel loops of
+// compiled programs. The generator outlines the body of
+// each loop into a function that runs a range of its
+// iterations, and calls __beaker_parallel_for.
+//
+// The iterations are divided into chunks, which the
+// threads take in order from a shared counter until none
+// are left. The calling thread takes part in the loop.
+// As in the interpreter, a loop that is started while
+// another is running runs on the calling thread.
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+typedef void (*Body)(void*, int64_t, int64_t);
+
+
+// The number of chunks for each thread.
+enum { chunks_per_thread = 8 };
+
+
+static pthread_once_t  once  = PTHREAD_ONCE_INIT;
+static pthread_mutex_t busy  = PTHREAD_MUTEX_INITIALIZER; // Held while a loop runs
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER; // Guards the loop
+static pthread_cond_t  wake  = PTHREAD_COND_INITIALIZER;  // Signals the start of a loop
+static pthread_cond_t  done  = PTHREAD_COND_INITIALIZER;  // Signals the end of a loop
+
+static int           threads = 1;
+static unsigned long loop    = 0; // Counts the loops started
+static int           active  = 0; // Workers still in the loop
+static Body          body;
+static void*         env;
+static int64_t       last;
+static int64_t       grain;
+static atomic_llong  next;
+
+// True for the workers, and for a thread running a loop.
+static _Thread_local int in_loop = 0;
+
+
+// Run chunks of the current loop until there are none
+// left.
+static void
+execute(void)
+{
+  int64_t i;
+  while ((i = atomic_fetch_add(&next, grain)) < last) {
+    int64_t j = i + grain < last ? i + grain : last;
+    body(env, i, j);
+  }
+}
+
+
+static void*
+work(void* arg)
+{
+  unsigned long seen = 0;
+  in_loop = 1;
+  for (;;) {
+    pthread_mutex_lock(&mutex);
+    while (loop == seen)
+      pthread_cond_wait(&wake, &mutex);
+    seen = loop;
+    pthread_mutex_unlock(&mutex);
+
+    execute();
+
+    pthread_mutex_lock(&mutex);
+    if (--active == 0)
+      pthread_cond_signal(&done);
+    pthread_mutex_unlock(&mutex);
+  }
+  return NULL;
+}
+
+
+// Start one worker per processor, less the thread that
+// runs loops, unless BEAKER_THREADS gives another number.
+static void
+start(void)
+{
+  char const* s = getenv("BEAKER_THREADS");
+  threads = s ? atoi(s) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads < 1)
+    threads = 1;
+  for (int i = 1; i < threads; ++i) {
+    pthread_t t;
+    if (pthread_create(&t, NULL, work, NULL) != 0) {
+      threads = i;
+      break;
+    }
+    pthread_detach(t);
+  }
+}
+
+
+// Call fn(e, i, j) on chunks [i, j) of the iterations
+// [lo, hi), and return when every iteration has finished.
+void
+__beaker_parallel_for(Body fn, void* e, int64_t lo, int64_t hi)
+{
+  if (lo >= hi)
+    return;
+  pthread_once(&once, start);
+  if (threads == 1 || in_loop || pthread_mutex_trylock(&busy) != 0) {
+    fn(e, lo, hi);
+    return;
+  }
+
+  int64_t g = (hi - lo) / (threads * chunks_per_thread);
+  pthread_mutex_lock(&mutex);
+  body = fn;
+  env = e;
+  last = hi;
+  grain = g < 1 ? 1 : g;
+  atomic_store(&next, lo);
+  active = threads - 1;
+  ++loop;
+  pthread_cond_broadcast(&wake);
+  pthread_mutex_unlock(&mutex);
+
+  in_loop = 1;
+  execute();
+  in_loop = 0;
+
+  pthread_mutex_lock(&mutex);
+  while (active != 0)
+    pthread_cond_wait(&done, &mutex);
+  pthread_mutex_unlock(&mutex);
+  pthread_mutex_unlock(&busy);
+}
@@ -5,6 +5,82 @@
 #include "beaker/decl.hpp"
 
 
+// Make b the innermost binding of sym, saving the
+// binding that it shadows.
+void
+Scope_stack::enter(Symbol const* sym, Binding* b)
+{
+  std::size_t n = sym->id();
+  if (n >= bindings.size())
+    bindings.resize(n + 1, nullptr);
+  shadows.emplace_back(sym, bindings[n]);
+  bindings[n] = b;
+}
+
+
+// Restore the bindings shadowed by the current scope.
+void
+Scope_stack::leave()
+{
+  std::size_t m = marks.back();
+  marks.pop_back();
+  while (shadows.size() > m) {
+    Shadow& s = shadows.back();
+    bindings[s.first->id()] = s.second;
+    shadows.pop_back();
+  }
+}
+
+
+// Push an existing scope onto the stack. Its bindings
+// become visible.
+void
+Scope_stack::push(Scope* s)
+{
+  Stack<Scope>::push(s);
+  marks.push_back(shadows.size());
+  for (Binding& b : *s)
+    enter(b.first, &b);
+}
+
+
+// Push a new scope associated with the declaration d.
+void
+Scope_stack::push(Decl* d)
+{
+  push(new Scope(d));
+}
+
+
+// Pop and destroy the current scope.
+void
+Scope_stack::pop()
+{
+  leave();
+  Stack<Scope>::pop();
+}
+
+
+// Remove the current scope from the stack and return
+// it. This does not destroy the scope.
+Scope*
+Scope_stack::take()
+{
+  leave();
+  return Stack<Scope>::take();
+}
+
+
+// Bind the symbol in the current scope.
+auto
+Scope_stack::bind(Symbol const* sym, Overload const& ovl) -> Binding&
+{
+  Binding& b = current().bind(sym, ovl);
+  enter(sym, &b);
+  return b;
+}
+
+
 // Returns the innermost declaration context.
 Decl*
 Scope_stack::context() const
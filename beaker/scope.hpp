@@ -34,8 +34,24 @@ struct Scope : Environment<Symbol const*, Overload>
 // elaboration. It adapts the more general stack to
 // provide more language-specific names for those
 // operations.
+//
+// Unqualified lookup does not search each scope in
+// turn. Instead, the stack maintains a table, indexed
+// by symbol id, of the innermost binding of each
+// symbol. Binding a symbol saves the binding it
+// shadows, and popping a scope restores them. Lookup
+// is a single index, regardless of nesting depth.
 struct Scope_stack : Stack<Scope>
 {
+  void push(Scope*);
+  void push(Decl* = nullptr);
+  void pop();
+  Scope* take();
+
+  Binding& bind(Symbol const*, Overload const&);
+
+  Binding* lookup(Symbol const*) const;
+
   Scope&       current()       { return top(); }
   Scope const& current() const { return top(); }
 
@@ -46,7 +62,29 @@ struct Scope_stack : Stack<Scope>
   Module_decl*   module() const;
   Function_decl* function() const;
   Record_decl*   record() const;
+
+private:
+  // A binding that was shadowed by a new binding of
+  // the same symbol.
+  using Shadow = std::pair<Symbol const*, Binding*>;
+
+  void enter(Symbol const*, Binding*);
+  void leave();
+
+  std::vector<Binding*> bindings; // Innermost binding of each symbol
+  std::vector<Shadow>   shadows;  // Shadowed bindings, innermost last
+  std::vector<size_t>   marks;    // The first shadow of each scope
 };
 
 
+// Returns the innermost binding of the symbol, or
+// nullptr if the symbol is not bound.
+inline Scope::Binding*
+Scope_stack::lookup(Symbol const* sym) const
+{
+  std::size_t n = sym->id();
+  return n < bindings.size() ? bindings[n] : nullptr;
+}
+
+
 #endif
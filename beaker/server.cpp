@@ -0,0 +1,255 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/server.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+// A request is sent as a 32-bit length followed by
+// the working directory and the arguments, each
+// terminated by a null character. The client's streams
+// are passed as rights with the length.
+
+namespace
+{
+
+// Initialize the address of the socket at path. Returns
+// false if the path is too long.
+bool
+make_address(std::string const& path, sockaddr_un& addr)
+{
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path))
+    return false;
+  std::strcpy(addr.sun_path, path.c_str());
+  return true;
+}
+
+
+// Create the directory of the socket at path, if it does
+// not exist. Returns false unless the directory belongs
+// to this user and no one else can use it, so that
+// no other user can replace the socket.
+bool
+make_private_directory(std::string const& path)
+{
+  std::size_t n = path.rfind('/');
+  std::string dir = n == std::string::npos ? "." : path.substr(0, n);
+  if (dir.empty())
+    dir = "/";
+  mkdir(dir.c_str(), 0700);
+  struct stat st;
+  if (lstat(dir.c_str(), &st) < 0)
+    return false;
+  return S_ISDIR(st.st_mode) && st.st_uid == getuid() && (st.st_mode & 077) == 0;
+}
+
+
+bool
+write_all(int fd, void const* p, std::size_t n)
+{
+  char const* s = static_cast<char const*>(p);
+  while (n) {
+    ssize_t k = write(fd, s, n);
+    if (k <= 0)
+      return false;
+    s += k;
+    n -= k;
+  }
+  return true;
+}
+
+
+bool
+read_all(int fd, void* p, std::size_t n)
+{
+  char* s = static_cast<char*>(p);
+  while (n) {
+    ssize_t k = read(fd, s, n);
+    if (k <= 0)
+      return false;
+    s += k;
+    n -= k;
+  }
+  return true;
+}
+
+
+} // namespace
+
+
+// Returns the path of the server's socket. This is
+// given by the BEAKER_SERVER environment variable, or
+// is in the user's runtime directory, or is in a
+// per-user directory in /tmp.
+std::string
+default_server_socket()
+{
+  if (char const* p = std::getenv("BEAKER_SERVER"))
+    return p;
+  if (char const* p = std::getenv("XDG_RUNTIME_DIR"))
+    return std::string(p) + "/beaker.sock";
+  return "/tmp/beaker-" + std::to_string(getuid()) + "/server.sock";
+}
+
+
+// Listen for clients on the socket at path, replacing
+// any existing socket. The directory of the socket is
+// created if needed, and must be private to this user.
+// Only this user can connect to the socket. Returns the
+// listening socket, or -1 on error.
+int
+open_server(std::string const& path)
+{
+  sockaddr_un addr;
+  if (!make_address(path, addr) || !make_private_directory(path))
+    return -1;
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return -1;
+  unlink(path.c_str());
+  mode_t mask = umask(0177);
+  int r = bind(fd, (sockaddr*)&addr, sizeof(addr));
+  umask(mask);
+  if (r < 0 || chmod(path.c_str(), 0600) < 0 || listen(fd, SOMAXCONN) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+
+// Connect to the server at path. Returns the connected
+// socket, or -1 on error. A server run by another user
+// is refused, so that the client's streams are not
+// passed to it.
+int
+connect_server(std::string const& path)
+{
+  sockaddr_un addr;
+  if (!make_address(path, addr))
+    return -1;
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return -1;
+  if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || !is_same_user(fd)) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+
+// Returns true if the process at the other end of the
+// connected socket fd runs as the same user as this one.
+bool
+is_same_user(int fd)
+{
+  ucred cred;
+  socklen_t n = sizeof(cred);
+  if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &n) < 0)
+    return false;
+  return cred.uid == getuid();
+}
+
+
+bool
+send_request(int fd, Server_request const& req)
+{
+  std::string buf = req.cwd;
+  buf += '\0';
+  for (std::string const& s : req.args) {
+    buf += s;
+    buf += '\0';
+  }
+  std::uint32_t len = buf.size();
+
+  // Send the length with the streams.
+  int fds[2] { req.out, req.err };
+  char ctl[CMSG_SPACE(sizeof(fds))];
+  std::memset(ctl, 0, sizeof(ctl));
+  iovec iov { &len, sizeof(len) };
+  msghdr msg {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctl;
+  msg.msg_controllen = sizeof(ctl);
+  cmsghdr* c = CMSG_FIRSTHDR(&msg);
+  c->cmsg_level = SOL_SOCKET;
+  c->cmsg_type = SCM_RIGHTS;
+  c->cmsg_len = CMSG_LEN(sizeof(fds));
+  std::memcpy(CMSG_DATA(c), fds, sizeof(fds));
+  if (sendmsg(fd, &msg, 0) != sizeof(len))
+    return false;
+
+  return write_all(fd, buf.data(), buf.size());
+}
+
+
+bool
+recv_request(int fd, Server_request& req)
+{
+  // Receive the length and the streams.
+  std::uint32_t len;
+  int fds[2];
+  char ctl[CMSG_SPACE(sizeof(fds))];
+  iovec iov { &len, sizeof(len) };
+  msghdr msg {};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctl;
+  msg.msg_controllen = sizeof(ctl);
+  if (recvmsg(fd, &msg, 0) != sizeof(len))
+    return false;
+  cmsghdr* c = CMSG_FIRSTHDR(&msg);
+  if (!c || c->cmsg_type != SCM_RIGHTS || c->cmsg_len != CMSG_LEN(sizeof(fds)))
+    return false;
+  std::memcpy(fds, CMSG_DATA(c), sizeof(fds));
+  req.out = fds[0];
+  req.err = fds[1];
+
+  // Receive the directory and arguments.
+  std::string buf(len, 0);
+  if (!read_all(fd, &buf[0], len) || buf.empty() || buf.back() != 0) {
+    close(req.out);
+    close(req.err);
+    return false;
+  }
+  std::size_t i = buf.find('\0');
+  req.cwd = buf.substr(0, i);
+  req.args.clear();
+  for (++i; i < buf.size(); ) {
+    std::size_t j = buf.find('\0', i);
+    req.args.push_back(buf.substr(i, j - i));
+    i = j + 1;
+  }
+  return true;
+}
+
+
+bool
+send_status(int fd, int status)
+{
+  std::int32_t n = status;
+  return write_all(fd, &n, sizeof(n));
+}
+
+
+bool
+recv_status(int fd, int& status)
+{
+  std::int32_t n;
+  if (!read_all(fd, &n, sizeof(n)))
+    return false;
+  status = n;
+  return true;
+}
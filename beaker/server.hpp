@@ -0,0 +1,54 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_SERVER_HPP
+#define BEAKER_SERVER_HPP
+
+// The compile server runs compilations for clients
+// that connect to it through a local socket. A client
+// sends its working directory, its command line, and
+// its standard output and error streams. The server
+// runs the compilation in that directory, writing to
+// those streams, and replies with the exit status.
+//
+// Running many small compilations in one process avoids
+// starting the compiler for each. It also lets the
+// server keep its symbol table, its canonical types,
+// and the tokens of unchanged source files between
+// compilations.
+//
+// The socket is created in a directory that only its
+// user can use, and each end of a connection checks
+// that the other runs as the same user.
+//
+// This module only implements the protocol. It does not
+// depend on the rest of the library so that the client
+// can be kept small.
+
+#include <string>
+#include <vector>
+
+
+// A request to run a compilation.
+struct Server_request
+{
+  std::string              cwd;  // The client's working directory
+  std::vector<std::string> args; // The client's command line
+  int                      out;  // The client's standard output
+  int                      err;  // The client's standard error
+};
+
+
+std::string default_server_socket();
+
+int open_server(std::string const&);
+int connect_server(std::string const&);
+bool is_same_user(int);
+
+bool send_request(int, Server_request const&);
+bool recv_request(int, Server_request&);
+bool send_status(int, int);
+bool recv_status(int, int&);
+
+
+#endif
@@ -0,0 +1,299 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#include "beaker/simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+
+namespace
+{
+
+// Call fn with a null pointer to the type of the elements
+// of kind k.
+template<typename F>
+inline auto
+with_elements(Element_kind k, F fn)
+{
+  switch (k) {
+    case int8_element: return fn(static_cast<int8_t*>(nullptr));
+    case uint8_element: return fn(static_cast<uint8_t*>(nullptr));
+    case int16_element: return fn(static_cast<int16_t*>(nullptr));
+    case uint16_element: return fn(static_cast<uint16_t*>(nullptr));
+    case int32_element: return fn(static_cast<int32_t*>(nullptr));
+    case uint32_element: return fn(static_cast<uint32_t*>(nullptr));
+    case int64_element: return fn(static_cast<int64_t*>(nullptr));
+    case uint64_element: return fn(static_cast<uint64_t*>(nullptr));
+    case float_element: return fn(static_cast<float*>(nullptr));
+    case double_element: return fn(static_cast<double*>(nullptr));
+  }
+  lingo_unreachable();
+}
+
+
+// The type in which arithmetic on elements of type T is
+// computed. Integers are computed as unsigned values of
+// at least the width of unsigned, so that they wrap.
+template<typename T, bool = std::is_integral<T>::value>
+struct Wrapping
+{
+  using type = T;
+};
+
+
+template<typename T>
+struct Wrapping<T, true>
+{
+  using type = std::common_type_t<unsigned, std::make_unsigned_t<T>>;
+};
+
+
+template<typename T>
+using Wrapping_t = typename Wrapping<T>::type;
+
+
+template<typename T>
+inline T
+remainder(T a, T b)
+{
+  return a % b;
+}
+
+
+inline float
+remainder(float a, float b)
+{
+  return std::fmod(a, b);
+}
+
+
+inline double
+remainder(double a, double b)
+{
+  return std::fmod(a, b);
+}
+
+
+template<typename T>
+inline T
+negate(T a)
+{
+  return T(Wrapping_t<T>(0) - Wrapping_t<T>(a));
+}
+
+
+inline float
+negate(float a)
+{
+  return -a;
+}
+
+
+inline double
+negate(double a)
+{
+  return -a;
+}
+
+
+// Integer division by 0 is diagnosed before any quotient
+// is computed. Floating point division by 0 is not an
+// error.
+template<typename T>
+inline void
+check_divisor(T const* b, std::size_t n)
+{
+  if (std::is_integral<T>::value && std::find(b, b + n, T(0)) != b + n)
+    throw std::runtime_error("division by 0");
+}
+
+
+template<typename T, typename F>
+inline void
+apply_elements(T const* a, T const* b, T* out, std::size_t n, F fn)
+{
+  for (std::size_t i = 0; i < n; ++i)
+    out[i] = fn(a[i], b[i]);
+}
+
+
+template<typename T, typename F>
+inline void
+compare_elements(T const* a, T const* b, uint8_t* out, std::size_t n, F fn)
+{
+  for (std::size_t i = 0; i < n; ++i)
+    out[i] = fn(a[i], b[i]);
+}
+
+
+template<typename T>
+void
+arithmetic(Vector_op op, T const* a, T const* b, T* out, std::size_t n)
+{
+  using W = Wrapping_t<T>;
+  switch (op) {
+    case vector_add:
+      return apply_elements(a, b, out, n, [](T x, T y) { return T(W(x) + W(y)); });
+    case vector_sub:
+      return apply_elements(a, b, out, n, [](T x, T y) { return T(W(x) - W(y)); });
+    case vector_mul:
+      return apply_elements(a, b, out, n, [](T x, T y) { return T(W(x) * W(y)); });
+    case vector_div:
+      check_divisor(b, n);
+      return apply_elements(a, b, out, n, [](T x, T y) { return T(x / y); });
+    case vector_rem:
+      check_divisor(b, n);
+      return apply_elements(a, b, out, n, [](T x, T y) { return T(remainder(x, y)); });
+    default:
+      lingo_unreachable();
+  }
+}
+
+
+template<typename T>
+void
+comparison(Vector_op op, T const* a, T const* b, uint8_t* out, std::size_t n)
+{
+  switch (op) {
+    case vector_eq: return compare_elements(a, b, out, n, std::equal_to<T>());
+    case vector_ne: return compare_elements(a, b, out, n, std::not_equal_to<T>());
+    case vector_lt: return compare_elements(a, b, out, n, std::less<T>());
+    case vector_gt: return compare_elements(a, b, out, n, std::greater<T>());
+    case vector_le: return compare_elements(a, b, out, n, std::less_equal<T>());
+    case vector_ge: return compare_elements(a, b, out, n, std::greater_equal<T>());
+    default: lingo_unreachable();
+  }
+}
+
+
+// Combine the n elements of p by fn. While the number of
+// elements is even, each element of the lower half is
+// combined with the corresponding element of the upper
+// half; the rest are then combined in order. This is the
+// order in which generated code reduces a vector, so that
+// floating point results agree.
+template<typename T, typename F>
+T
+fold_elements(T const* p, std::size_t n, F fn)
+{
+  std::vector<T> v(p, p + n);
+  while (n > 1 && n % 2 == 0) {
+    n /= 2;
+    for (std::size_t i = 0; i < n; ++i)
+      v[i] = fn(v[i], v[i + n]);
+  }
+  T r = v[0];
+  for (std::size_t i = 1; i < n; ++i)
+    r = fn(r, v[i]);
+  return r;
+}
+
+
+template<typename T>
+T
+fold(Reduction r, T const* p, std::size_t n)
+{
+  using W = Wrapping_t<T>;
+  switch (r) {
+    case sum_reduction:
+      return fold_elements(p, n, [](T x, T y) { return T(W(x) + W(y)); });
+    case product_reduction:
+      return fold_elements(p, n, [](T x, T y) { return T(W(x) * W(y)); });
+    case min_reduction:
+      return fold_elements(p, n, [](T x, T y) { return y < x ? y : x; });
+    case max_reduction:
+      return fold_elements(p, n, [](T x, T y) { return x < y ? y : x; });
+    case all_reduction:
+      return fold_elements(p, n, [](T x, T y) { return T(x && y); });
+    case any_reduction:
+      return fold_elements(p, n, [](T x, T y) { return T(x || y); });
+  }
+  lingo_unreachable();
+}
+
+
+} // namespace
+
+
+// Returns a new buffer holding the result of op applied
+// to each pair of elements of a and b, which have the
+// same kind and length.
+Buffer_value
+vector_binary(Vector_op op, Buffer_value a, Buffer_value b)
+{
+  lingo_assert(a.kind() == b.kind() && a.len() == b.len());
+  std::size_t n = a.len();
+  bool cmp = op >= vector_eq;
+  Buffer_value r(cmp ? uint8_element : a.kind(), n);
+  with_elements(a.kind(), [&](auto t) {
+    using T = std::remove_pointer_t<decltype(t)>;
+    T const* x = reinterpret_cast<T const*>(a.data());
+    T const* y = reinterpret_cast<T const*>(b.data());
+    if (cmp)
+      comparison(op, x, y, reinterpret_cast<uint8_t*>(r.data()), n);
+    else
+      arithmetic(op, x, y, reinterpret_cast<T*>(r.data()), n);
+  });
+  return r;
+}
+
+
+// Returns a new buffer holding the negation of each
+// element of a.
+Buffer_value
+vector_negate(Buffer_value a)
+{
+  std::size_t n = a.len();
+  Buffer_value r(a.kind(), n);
+  with_elements(a.kind(), [&](auto t) {
+    using T = std::remove_pointer_t<decltype(t)>;
+    T const* x = reinterpret_cast<T const*>(a.data());
+    T* out = reinterpret_cast<T*>(r.data());
+    for (std::size_t i = 0; i < n; ++i)
+      out[i] = negate(x[i]);
+  });
+  return r;
+}
+
+
+// Returns a new buffer of n elements, each of which is v.
+Buffer_value
+vector_splat(Element_kind k, std::size_t n, Value const& v)
+{
+  Buffer_value r(k, n);
+  store(k, r.data(), v);
+  with_elements(k, [&](auto t) {
+    using T = std::remove_pointer_t<decltype(t)>;
+    T* out = reinterpret_cast<T*>(r.data());
+    std::fill(out + 1, out + n, out[0]);
+  });
+  return r;
+}
+
+
+// Returns the combination of the elements of a by the
+// operator of the reduction r.
+Value
+vector_reduce(Reduction r, Buffer_value a)
+{
+  return with_elements(a.kind(), [&](auto t) -> Value {
+    using T = std::remove_pointer_t<decltype(t)>;
+    T x = fold(r, reinterpret_cast<T const*>(a.data()), a.len());
+    if (std::is_floating_point<T>::value)
+      return Float_value(x);
+    return Integer_value(x);
+  });
+}
+
+
+// Free the storage of a vector that is no longer
+// referred to.
+void
+vector_release(Buffer_value a)
+{
+  operator delete(a.rep);
+}
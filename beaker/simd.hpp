@@ -0,0 +1,47 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+#ifndef BEAKER_SIMD_HPP
+#define BEAKER_SIMD_HPP
+
+// The simd module implements the operations on vector
+// values for the evaluator. A vector value is a buffer
+// whose elements have the representation of the vector's
+// element type.
+//
+// Each operation is a simple loop over the contiguous
+// storage of its operands, which the host compiler can
+// vectorize. Integer arithmetic wraps, as it does in
+// generated code, and comparisons produce a buffer of
+// bytes that are 0 or 1.
+
+#include <beaker/prelude.hpp>
+#include <beaker/value.hpp>
+#include <beaker/expr.hpp>
+
+
+// The elementwise operations on vectors.
+enum Vector_op
+{
+  vector_add,
+  vector_sub,
+  vector_mul,
+  vector_div,
+  vector_rem,
+  vector_eq,
+  vector_ne,
+  vector_lt,
+  vector_gt,
+  vector_le,
+  vector_ge,
+};
+
+
+Buffer_value vector_binary(Vector_op, Buffer_value, Buffer_value);
+Buffer_value vector_negate(Buffer_value);
+Buffer_value vector_splat(Element_kind, std::size_t, Value const&);
+Value        vector_reduce(Reduction, Buffer_value);
+void         vector_release(Buffer_value);
+
+
+#endif
@@ -44,6 +44,10 @@ enum Specifier
   // TODO: Support foreign language linkage for other
   // other languages?
   foreign_spec = 1 << 10,
+
+  // The declaration was imported from the interface of
+  // another module. It is defined in that module.
+  imported_spec = 1 << 11,
 };
 
 
@@ -4,6 +4,9 @@
 #ifndef BEAKER_STMT_HPP
 #define BEAKER_STMT_HPP
 
+#include <beaker/prelude.hpp>
+#include <beaker/value.hpp>
+
 
 // The base class of all statements in the language.
 struct Stmt
@@ -27,7 +30,10 @@ struct Stmt::Visitor
   virtual void visit(Return_stmt const*) = 0;
   virtual void visit(If_then_stmt const*) = 0;
   virtual void visit(If_else_stmt const*) = 0;
+  virtual void visit(Switch_stmt const*) = 0;
   virtual void visit(While_stmt const*) = 0;
+  virtual void visit(For_stmt const*) = 0;
+  virtual void visit(Parallel_for_stmt const*) = 0;
   virtual void visit(Break_stmt const*) = 0;
   virtual void visit(Continue_stmt const*) = 0;
   virtual void visit(Expression_stmt const*) = 0;
@@ -44,7 +50,10 @@ struct Stmt::Mutator
   virtual void visit(Return_stmt*) = 0;
   virtual void visit(If_then_stmt*) = 0;
   virtual void visit(If_else_stmt*) = 0;
+  virtual void visit(Switch_stmt*) = 0;
   virtual void visit(While_stmt*) = 0;
+  virtual void visit(For_stmt*) = 0;
+  virtual void visit(Parallel_for_stmt*) = 0;
   virtual void visit(Break_stmt*) = 0;
   virtual void visit(Continue_stmt*) = 0;
   virtual void visit(Expression_stmt*) = 0;
@@ -155,13 +164,65 @@ struct If_else_stmt : Stmt
 };
 
 
+// A case of a switch statement. The labels are integer
+// or character literals.
+struct Switch_case
+{
+  Switch_case(Expr_seq const& es, Stmt* s)
+    : first(es), second(s)
+  { }
+
+  Expr_seq const& labels() const { return first; }
+  Stmt*           body() const   { return second; }
+
+  Expr_seq first;
+  Stmt*    second;
+};
+
+
+// A statement of the form:
+//
+//    switch (e) {
+//      case c1, c2: s1
+//      ...
+//      default: sn
+//    }
+//
+// The body of the case whose label is the value of e is
+// evaluated. If there is no such case, the body of the
+// default case is evaluated, if any. Control does not
+// fall through from one case to the next; a break
+// statement leaves the switch.
+struct Switch_stmt : Stmt
+{
+  Switch_stmt(Expr* e, Case_seq const& cs, Stmt* d)
+    : first(e), second(cs), third(d)
+  { }
+
+  void accept(Visitor& v) const { return v.visit(this); }
+  void accept(Mutator& v)       { return v.visit(this); }
+
+  Expr*           condition() const    { return first; }
+  Case_seq const& cases() const        { return second; }
+  Stmt*           default_case() const { return third; }
+
+  Expr*    first;
+  Case_seq second;
+  Stmt*    third;
+};
+
+
 // A statement of the form:
 //
 //    while (e) s
+//    while [vectorize] (e) s
+//
+// The vectorize hint asks the compiler to vectorize
+// the loop. It does not change the meaning of the loop.
 struct While_stmt : Stmt
 {
-  While_stmt(Expr* e, Stmt* s)
-    : first(e), second(s)
+  While_stmt(Expr* e, Stmt* s, bool v = false)
+    : first(e), second(s), vec(v)
   { }
 
   void accept(Visitor& v) const { return v.visit(this); }
@@ -169,9 +230,80 @@ struct While_stmt : Stmt
 
   Expr* condition() const { return first; }
   Stmt* body() const      { return second; }
+  bool  vectorize() const { return vec; }
 
   Expr* first;
   Stmt* second;
+  bool  vec;
+};
+
+
+// A statement of the form:
+//
+//    for [vectorize] x in e1 .. e2 s
+//
+// The body s is evaluated once for each integer x in
+// the half-open range [e1, e2), in increasing order. The
+// bounds are evaluated once, before the first iteration,
+// and x is assigned from a separate counter before each
+// iteration, so assigning to x does not change the
+// number of iterations.
+//
+// When the bounds are literals, the trip count is
+// determined during elaboration. Otherwise, it is -1.
+struct For_stmt : Stmt
+{
+  For_stmt(Variable_decl* d, Expr* e1, Expr* e2, Stmt* s, bool v)
+    : first(d), second(e1), third(e2), fourth(s), vec(v)
+  { }
+
+  void accept(Visitor& v) const { return v.visit(this); }
+  void accept(Mutator& v)       { return v.visit(this); }
+
+  Variable_decl* variable() const   { return first; }
+  Expr*          lower() const      { return second; }
+  Expr*          upper() const      { return third; }
+  Stmt*          body() const       { return fourth; }
+  bool           vectorize() const  { return vec; }
+  Integer_value  trip_count() const { return trips; }
+
+  Variable_decl* first;
+  Expr*          second;
+  Expr*          third;
+  Stmt*          fourth;
+  bool           vec;
+  Integer_value  trips = -1;
+};
+
+
+// A statement of the form:
+//
+//    parallel for x in e1 .. e2 s
+//
+// The body s is evaluated once for each integer x in
+// the half-open range [e1, e2). The iterations may run
+// concurrently and in any order, so the body shall not
+// break out of the loop, return, or assign to objects
+// declared outside of the loop other than the elements
+// of arrays indexed by x.
+struct Parallel_for_stmt : Stmt
+{
+  Parallel_for_stmt(Variable_decl* d, Expr* e1, Expr* e2, Stmt* s)
+    : first(d), second(e1), third(e2), fourth(s)
+  { }
+
+  void accept(Visitor& v) const { return v.visit(this); }
+  void accept(Mutator& v)       { return v.visit(this); }
+
+  Variable_decl* variable() const { return first; }
+  Expr*          lower() const    { return second; }
+  Expr*          upper() const    { return third; }
+  Stmt*          body() const     { return fourth; }
+
+  Variable_decl* first;
+  Expr*          second;
+  Expr*          third;
+  Stmt*          fourth;
 };
 
 
@@ -243,7 +375,10 @@ struct Generic_stmt_visitor : Stmt::Visitor, lingo::Generic_visitor<F, T>
   void visit(Return_stmt const* d) { this->invoke(d); };
   void visit(If_then_stmt const* d) { this->invoke(d); };
   void visit(If_else_stmt const* d) { this->invoke(d); };
+  void visit(Switch_stmt const* d) { this->invoke(d); };
   void visit(While_stmt const* d) { this->invoke(d); };
+  void visit(For_stmt const* d) { this->invoke(d); };
+  void visit(Parallel_for_stmt const* d) { this->invoke(d); };
   void visit(Break_stmt const* d) { this->invoke(d); };
   void visit(Continue_stmt const* d) { this->invoke(d); };
   void visit(Expression_stmt const* d) { this->invoke(d); };
@@ -277,7 +412,10 @@ struct Generic_stmt_mutator : Stmt::Mutator, lingo::Generic_mutator<F, T>
   void visit(Return_stmt* d) { this->invoke(d); };
   void visit(If_then_stmt* d) { this->invoke(d); };
   void visit(If_else_stmt* d) { this->invoke(d); };
+  void visit(Switch_stmt* d) { this->invoke(d); };
   void visit(While_stmt* d) { this->invoke(d); };
+  void visit(For_stmt* d) { this->invoke(d); };
+  void visit(Parallel_for_stmt* d) { this->invoke(d); };
   void visit(Break_stmt* d) { this->invoke(d); };
   void visit(Continue_stmt* d) { this->invoke(d); };
   void visit(Expression_stmt* d) { this->invoke(d); };
@@ -24,23 +24,25 @@ class Symbol
 
 public:
   Symbol(int k)
-    : str_(nullptr), tok_(k)
+    : str_(nullptr), tok_(k), id_(-1)
   { }
 
   virtual ~Symbol() { }
 
   String const& spelling() const { return *str_; }
   int           token() const    { return tok_; }
+  int           id() const       { return id_; }
 
 private:
   String const* str_; // The textual representation
   int           tok_; // The associated token kind
+  int           id_;  // The index of the symbol in its table
 };
 
 
-// Represents all identifiers.
-//
-// TODO: Track the innermost binding of the identifier?
+// Represents all identifiers. The innermost binding
+// of an identifier is tracked by the scope stack,
+// which is indexed by the symbol's id.
 struct Identifier_sym : Symbol
 {
   Identifier_sym(int k)
@@ -177,6 +179,10 @@ Symbol_table::~Symbol_table()
 // explicitly, and it must derive from the Symbol
 // class.
 //
+// Each new symbol is assigned the next id in the
+// table. Ids are dense, so they can be used to index
+// other tables.
+//
 // If the symbol already exists, no insertion is
 // performed. If new symbol is of a different kind
 // (e.g., redefining an integer as an identifier),
@@ -197,6 +203,7 @@ Symbol_table::put(String const& s, Args&&... args)
     // and bind its string representation.
     sym = new T(std::forward<Args>(args)...);
     sym->str_ = &iter->first;
+    sym->id_ = size() - 1;
   } else {
     // Insertion did not succeed. Check that we have
     // not redefined the symbol kind.
@@ -0,0 +1,56 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Run the program given on the command line, which is
+// test/cache-1.bkr, and check the counters of its
+// inline caches.
+
+#include "beaker/engine.hpp"
+
+#include <iostream>
+
+
+namespace
+{
+
+int failures = 0;
+
+
+void
+check(bool ok, char const* what)
+{
+  if (!ok) {
+    std::cerr << "failed: " << what << '\n';
+    ++failures;
+  }
+}
+
+
+} // namespace
+
+
+int
+main(int argc, char* argv[])
+{
+  if (argc != 2) {
+    std::cerr << "usage: test-cache program\n";
+    return 1;
+  }
+  Engine e;
+  e.load(argv[1]);
+  check(e.function("main").call<int>() == 200, "result");
+
+  // The loop runs 10 times. The monomorphic site misses
+  // once. The site with two receivers misses twice. The
+  // megamorphic site misses on each receiver the first
+  // time, and on the fifth receiver every time after.
+  Inline_cache_stats st = e.cache_stats();
+  check(st.sites == 3, "sites");
+  check(st.megamorphic == 1, "megamorphic sites");
+  check(st.hits == 9 + 18 + 36, "hits");
+  check(st.misses == 1 + 2 + 14, "misses");
+  if (failures)
+    std::cerr << "sites " << st.sites << ", megamorphic " << st.megamorphic
+              << ", hits " << st.hits << ", misses " << st.misses << '\n';
+  return failures != 0;
+}
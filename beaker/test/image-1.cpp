@@ -0,0 +1,95 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Run the program given as the first argument, which is
+// test/image-1.bkr, save its image, and load the image
+// in a fresh engine. The loaded program keeps the global
+// store of the saved one. An image with a corrupt byte
+// is rejected.
+
+#include "beaker/engine.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+
+namespace
+{
+
+int failures = 0;
+
+
+void
+check(bool ok, char const* what)
+{
+  if (!ok) {
+    std::cerr << "failed: " << what << '\n';
+    ++failures;
+  }
+}
+
+
+} // namespace
+
+
+int
+main(int argc, char* argv[])
+{
+  if (argc != 2) {
+    std::cerr << "usage: test-image program\n";
+    return 1;
+  }
+
+  char tmp[] = "/tmp/beaker-test-XXXXXX";
+  if (!mkdtemp(tmp) || chdir(tmp) != 0) {
+    std::cerr << "error: cannot create a directory\n";
+    return 1;
+  }
+
+  Engine app;
+  app.load(argv[1]);
+  check(app.function("main").call<int>() == 252, "result");
+  app.save_image("image-1.img");
+
+  // The image holds the store after the first run.
+  Engine img;
+  img.load_image("image-1.img");
+  check(img.main() != nullptr, "entry point");
+  check(img.function("count").call<int>() == 1, "preserved count");
+  check(img.function("sum").call<int>() == 252, "preserved sum");
+  check(img.function("main").call<int>() == 252, "loaded result");
+  check(img.function("count").call<int>() == 2, "updated count");
+  check(img.function("sum").call<int>() == 504, "updated sum");
+
+  // Flip a byte in the middle of the image.
+  std::string buf;
+  {
+    std::ifstream ifs("image-1.img", std::ios::binary);
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    buf = ss.str();
+  }
+  buf[buf.size() / 2] ^= 0x01;
+  {
+    std::ofstream ofs("image-2.img", std::ios::binary);
+    ofs << buf;
+  }
+  bool rejected = false;
+  try {
+    Engine bad;
+    bad.load_image("image-2.img");
+  } catch (std::runtime_error& err) {
+    rejected = std::string(err.what()) == "invalid image";
+  }
+  check(rejected, "corrupt image");
+
+  unlink("image-1.img");
+  unlink("image-2.img");
+  rmdir(tmp);
+  return failures != 0;
+}
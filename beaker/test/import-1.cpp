@@ -0,0 +1,77 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Write the interface of the module given as the first
+// argument, which is test/import-shapes.bkr, to shapes.bki,
+// then run the program given as the second argument,
+// which is test/import-1.bkr and imports it.
+
+#include "beaker/engine.hpp"
+#include "beaker/interface.hpp"
+#include "beaker/decl.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include <unistd.h>
+
+
+namespace
+{
+
+int failures = 0;
+
+
+void
+check(bool ok, char const* what)
+{
+  if (!ok) {
+    std::cerr << "failed: " << what << '\n';
+    ++failures;
+  }
+}
+
+
+} // namespace
+
+
+int
+main(int argc, char* argv[])
+{
+  if (argc != 3) {
+    std::cerr << "usage: test-import module program\n";
+    return 1;
+  }
+
+  // Imports are found in the current directory.
+  char tmp[] = "/tmp/beaker-test-XXXXXX";
+  if (!mkdtemp(tmp) || chdir(tmp) != 0) {
+    std::cerr << "error: cannot create a directory\n";
+    return 1;
+  }
+
+  Engine lib;
+  lib.load(argv[1]);
+  {
+    std::ofstream ofs("shapes.bki", std::ios::binary);
+    write_interface(ofs, lib.module());
+    check(bool(ofs), "write the interface");
+  }
+
+  // The program elaborates calls to the imported
+  // function and method, and uses the imported record.
+  Engine app;
+  app.load(argv[2]);
+  check(app.function("main").call<int>() == 12, "result");
+
+  int imported = 0;
+  for (Decl const* d : app.module()->declarations())
+    if (d->is_imported())
+      ++imported;
+  check(imported == 2, "imported declarations");
+
+  unlink("shapes.bki");
+  rmdir(tmp);
+  return failures != 0;
+}
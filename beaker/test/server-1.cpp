@@ -0,0 +1,103 @@
+// Copyright (c) 2015 Andrew Sutton
+// All rights reserved
+
+// Send a request to a compile server socket and check
+// that it is received intact, that the client's streams
+// are usable by the server, and that the status is
+// returned. Also check that the socket is private.
+
+#include "beaker/server.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace
+{
+
+int failures = 0;
+
+
+void
+check(bool ok, char const* what)
+{
+  if (!ok) {
+    std::cerr << "failed: " << what << '\n';
+    ++failures;
+  }
+}
+
+
+} // namespace
+
+
+int
+main()
+{
+  char tmp[] = "/tmp/beaker-test-XXXXXX";
+  if (!mkdtemp(tmp)) {
+    std::cerr << "error: cannot create a directory\n";
+    return 1;
+  }
+  std::string dir = tmp;
+  std::string path = dir + "/server.sock";
+
+  // The socket is only usable by this user.
+  int srv = open_server(path);
+  check(srv >= 0, "open the server");
+  if (srv < 0)
+    return 1;
+  struct stat st;
+  check(stat(path.c_str(), &st) == 0 && (st.st_mode & 0777) == 0600, "socket mode is 0600");
+
+  // Send a request whose output goes to a pipe.
+  int out[2];
+  check(pipe(out) == 0, "create a pipe");
+  Server_request req;
+  req.cwd = "/some/dir";
+  req.args = {"beaker-compile", "-c", "", "a b.bkr"};
+  req.out = out[1];
+  req.err = STDERR_FILENO;
+  int cli = connect_server(path);
+  check(cli >= 0, "connect to the server");
+  check(send_request(cli, req), "send the request");
+
+  // Receive it on the server's end.
+  int con = accept(srv, nullptr, nullptr);
+  check(con >= 0 && is_same_user(con), "accept a client of the same user");
+  Server_request got;
+  check(recv_request(con, got), "receive the request");
+  check(got.cwd == req.cwd, "working directory");
+  check(got.args == req.args, "arguments");
+
+  // The received stream is the client's pipe.
+  check(write(got.out, "ok", 2) == 2, "write to the client's stream");
+  char buf[2];
+  check(read(out[0], buf, 2) == 2 && buf[0] == 'o' && buf[1] == 'k', "read the client's stream");
+  close(got.out);
+  close(got.err);
+
+  // The status is returned to the client.
+  int status = 0;
+  check(send_status(con, 42), "send the status");
+  check(recv_status(cli, status) && status == 42, "receive the status");
+  close(con);
+  close(cli);
+  close(srv);
+
+  // A server cannot be opened in a directory that other
+  // users can write to.
+  check(chmod(tmp, 0777) == 0, "make the directory public");
+  int bad = open_server(path);
+  check(bad < 0, "refuse a public directory");
+  if (bad >= 0)
+    close(bad);
+
+  unlink(path.c_str());
+  rmdir(tmp);
+  return failures != 0;
+}
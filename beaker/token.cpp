@@ -22,6 +22,7 @@ spelling(Token_kind k)
     case colon_tok: return ":";
     case semicolon_tok: return ";";
     case dot_tok: return ".";
+    case dot_dot_tok: return "..";
     case equal_tok: return "=";
     case plus_tok: return "+";
     case minus_tok: return "-";
@@ -44,17 +45,27 @@ spelling(Token_kind k)
     case abstract_kw: return "abstract";
     case bool_kw: return "bool";
     case break_kw: return "break";
+    case case_kw: return "case";
     case char_kw: return "char";
     case continue_kw: return "continue";
     case def_kw: return "def";
+    case default_kw: return "default";
     case else_kw: return "else";
+    case for_kw: return "for";
     case foreign_kw: return "else";
     case if_kw: return "if";
+    case import_kw: return "import";
+    case in_kw: return "in";
+    case parallel_kw: return "parallel";
+    case reduce_kw: return "reduce";
     case return_kw: return "return";
+    case shuffle_kw: return "shuffle";
     case struct_kw: return "struct";
+    case switch_kw: return "switch";
     case this_kw: return "this";
     case trivial_kw: return "trivial";
     case var_kw: return "var";
+    case vec_kw: return "vec";
     case virtual_kw: return "virtual";
     case while_kw: return "while";
     case int_kw: return "int";
@@ -95,6 +106,7 @@ init_symbols(Symbol_table& syms)
   syms.put<Symbol>(":", colon_tok);
   syms.put<Symbol>(";", semicolon_tok);
   syms.put<Symbol>(".", dot_tok);
+  syms.put<Symbol>("..", dot_dot_tok);
   syms.put<Symbol>("=", equal_tok);
   syms.put<Symbol>("+", plus_tok);
   syms.put<Symbol>("-", minus_tok);
@@ -122,17 +134,27 @@ init_symbols(Symbol_table& syms)
   syms.put<Symbol>("abstract", abstract_kw);
   syms.put<Symbol>("bool", bool_kw);
   syms.put<Symbol>("break", break_kw);
+  syms.put<Symbol>("case", case_kw);
   syms.put<Symbol>("char", char_kw);
   syms.put<Symbol>("continue", continue_kw);
   syms.put<Symbol>("def", def_kw);
+  syms.put<Symbol>("default", default_kw);
   syms.put<Symbol>("else", else_kw);
+  syms.put<Symbol>("for", for_kw);
   syms.put<Symbol>("foreign", foreign_kw);
   syms.put<Symbol>("if", if_kw);
+  syms.put<Symbol>("import", import_kw);
+  syms.put<Symbol>("in", in_kw);
+  syms.put<Symbol>("parallel", parallel_kw);
+  syms.put<Symbol>("reduce", reduce_kw);
   syms.put<Symbol>("return", return_kw);
+  syms.put<Symbol>("shuffle", shuffle_kw);
   syms.put<Symbol>("struct", struct_kw);
+  syms.put<Symbol>("switch", switch_kw);
   syms.put<Symbol>("this", this_kw);
   syms.put<Symbol>("trivial", trivial_kw);
   syms.put<Symbol>("var", var_kw);
+  syms.put<Symbol>("vec", vec_kw);
   syms.put<Symbol>("int", int_kw);
   syms.put<Symbol>("uint", uint_kw);
   syms.put<Symbol>("short", short_kw);
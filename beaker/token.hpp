@@ -34,6 +34,7 @@ enum Token_kind
   colon_tok,
   semicolon_tok,
   dot_tok,
+  dot_dot_tok,
   equal_tok,
   plus_tok,
   minus_tok,
@@ -61,17 +62,27 @@ enum Token_kind
   abstract_kw,
   bool_kw,
   break_kw,
+  case_kw,
   char_kw,
   continue_kw,
   def_kw,
+  default_kw,
   else_kw,
+  for_kw,
   foreign_kw,
   if_kw,
+  import_kw,
+  in_kw,
+  parallel_kw,
+  reduce_kw,
   return_kw,
+  shuffle_kw,
   struct_kw,
+  switch_kw,
   this_kw,
   trivial_kw,
   var_kw,
+  vec_kw,
   virtual_kw,
   while_kw,
   int_kw,
@@ -2,11 +2,12 @@
 // All rights reserved
 
 #include "beaker/type.hpp"
+#include "beaker/expr.hpp"
 #include "beaker/decl.hpp"
 #include "beaker/less.hpp"
 #include "beaker/value.hpp"
-#include "beaker/evaluator.hpp"
 
+#include <mutex>
 #include <set>
 
 
@@ -55,13 +56,24 @@ Record_type::scope() const
 
 
 
-// Returns the size of the array as an
-// integer value.
+// Returns the size of the array as an integer value.
+// Elaboration reduces the extent to a literal, so only
+// elaborated array types have a size. Computing the size
+// does not evaluate anything, so it is safe to do so in
+// concurrent evaluations of the same module.
 int
 Array_type::size() const
 {
-  Value v = evaluate(extent());
-  return v.get_integer();
+  return cast<Literal_expr>(extent())->value().get_integer();
+}
+
+
+// Returns the number of elements of the vector. As with
+// arrays, only elaborated vector types have a size.
+int
+Vector_type::size() const
+{
+  return cast<Literal_expr>(extent())->value().get_integer();
 }
 
 
@@ -82,6 +94,27 @@ template<typename T>
 using Type_set = std::set<T, Type_less<T>>;
 
 
+// A table of canonical types. Types may be requested by
+// several threads at once (e.g., when modules are loaded
+// while others are being evaluated), so lookup and
+// insertion are serialized. Once created, a type is never
+// modified or moved, so reading it requires no lock.
+template<typename T>
+struct Type_table
+{
+  template<typename... Args>
+  Type const* get(Args&&... args)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto ins = types.emplace(std::forward<Args>(args)...);
+    return &*ins.first;
+  }
+
+  Type_set<T> types;
+  std::mutex  mutex;
+};
+
+
 // Note that id types are not canonicalized.
 // They don't need to be since they never
 // escape elaboration.
@@ -164,9 +197,8 @@ get_double_type()
 Type const*
 get_function_type(Type_seq const& t, Type const* r)
 {
-  static Type_set<Function_type> fn;
-  auto ins = fn.emplace(t, r);
-  return &*ins.first;
+  static Type_table<Function_type> fn;
+  return fn.get(t, r);
 }
 
 
@@ -184,18 +216,34 @@ get_function_type(Decl_seq const& d, Type const* r)
 Type const*
 get_array_type(Type const* t, Expr* n)
 {
-  static Type_set<Array_type> ts;
-  auto ins = ts.emplace(t, n);
-  return &*ins.first;
+  static Type_table<Array_type> ts;
+  return ts.get(t, n);
+}
+
+
+Type const*
+get_vector_type(Type const* t, Expr* n)
+{
+  static Type_table<Vector_type> ts;
+  return ts.get(t, n);
+}
+
+
+// Returns the vector of n elements of type t. This is
+// used for the types of vector operations, whose extents
+// are not written in the program.
+Type const*
+get_vector_type(Type const* t, int n)
+{
+  return get_vector_type(t, new Literal_expr(get_integer_type(), Value(Integer_value(n))));
 }
 
 
 Type const*
 get_block_type(Type const* t)
 {
-  static Type_set<Block_type> ts;
-  auto ins = ts.emplace(t);
-  return &*ins.first;
+  static Type_table<Block_type> ts;
+  return ts.get(t);
 }
 
 
@@ -203,18 +251,16 @@ get_block_type(Type const* t)
 Type const*
 get_reference_type(Type const* t)
 {
-  static Type_set<Reference_type> ts;
-  auto ins = ts.emplace(t);
-  return &*ins.first;
+  static Type_table<Reference_type> ts;
+  return ts.get(t);
 }
 
 
 Type const*
 get_record_type(Record_decl* r)
 {
-  static Type_set<Record_type> ts;
-  auto ins = ts.emplace(r);
-  return &*ins.first;
+  static Type_table<Record_type> ts;
+  return ts.get(r);
 }
 
 // Gets the rank of a type
@@ -259,18 +305,13 @@ get_scalar_rank(Type const* t)
     return default_rnk;
 }
 
+// Returns true if derived is the record type base or
+// a record type derived from base.
 bool
-is_derived(Type const* derived, Type const* base){
-  if (Record_type const* d = as<Record_type>(derived))  {
-    if (Record_type const* b = as<Record_type>(base)) {
-      // If D and B are the same return true
-      Record_decl * der = d->declaration();
-      do {
-        if (der == b->declaration())
-          return true;
-        der = der->base()->declaration();
-      } while (der);
-    }
-  }
+is_derived(Type const* derived, Type const* base)
+{
+  if (Record_type const* d = as<Record_type>(derived))
+    if (Record_type const* b = as<Record_type>(base))
+      return d->declaration()->is_derived_from(b->declaration());
   return false;
 }
@@ -18,6 +18,7 @@
 //          (t1, ..., tn) -> t  -- function types
 //          t[n]                -- array types
 //          t[]                 -- block types
+//          vec<t, n>           -- vector types
 //          ref t               -- reference types
 //          struct n { f* }     -- field types
 //
@@ -53,6 +54,7 @@ struct Type::Visitor
   virtual void visit(Double_type const*) = 0;
   virtual void visit(Function_type const*) = 0;
   virtual void visit(Array_type const*) = 0;
+  virtual void visit(Vector_type const*) = 0;
   virtual void visit(Block_type const*) = 0;
   virtual void visit(Reference_type const*) = 0;
   virtual void visit(Record_type const*) = 0;
@@ -159,6 +161,29 @@ struct Array_type : Type
 };
 
 
+// A fixed-width vector type vec<T, N> of N scalars of
+// type T. Arithmetic and comparison operators apply to
+// each element of a vector at once, and code generation
+// maps vectors to the SIMD registers of the target.
+//
+// N is required to be a positive constant of type int.
+struct Vector_type : Type
+{
+  Vector_type(Type const* t, Expr* e)
+    : first(t), second(e)
+  { }
+
+  void accept(Visitor& v) const { v.visit(this); };
+
+  Type const* type() const   { return first; }
+  Expr*       extent() const { return second; }
+  int         size() const;
+
+  Type const* first;
+  Expr*       second;
+};
+
+
 // The type T[] of a region of contiguous memory with unspecified
 // size. The number of elements in a block is determined by
 // the contents of memory (e.g., a null-terminated string)
@@ -228,6 +253,8 @@ Type const* get_double_type();
 Type const* get_function_type(Type_seq const&, Type const*);
 Type const* get_function_type(Decl_seq const&, Type const*);
 Type const* get_array_type(Type const*, Expr*);
+Type const* get_vector_type(Type const*, Expr*);
+Type const* get_vector_type(Type const*, int);
 Type const* get_block_type(Type const*);
 Type const* get_reference_type(Type const*);
 Type const* get_record_type(Record_decl*);
@@ -248,6 +275,16 @@ is_scalar(Type const* t)
 }
 
 
+// The integral types are bool, char, and int.
+inline bool
+is_integral(Type const* t)
+{
+  return is<Boolean_type>(t)
+      || is<Character_type>(t)
+      || is<Integer_type>(t);
+}
+
+
 // The aggregate types are record types and array
 // types.
 //
@@ -261,6 +298,17 @@ is_aggregate(Type const* t)
 }
 
 
+// Returns the element type of a vector type, or
+// nullptr if t is not a vector type.
+inline Type const*
+get_element_type(Type const* t)
+{
+  if (Vector_type const* v = as<Vector_type>(t))
+    return v->type();
+  return nullptr;
+}
+
+
 // Returns true if this is the type of a string
 // literal: char[N].
 inline bool
@@ -312,6 +360,7 @@ struct Generic_type_visitor : Type::Visitor, lingo::Generic_visitor<F, T>
   void visit(Double_type const* t) { this->invoke(t); }
   void visit(Function_type const* t) { this->invoke(t); }
   void visit(Array_type const* t) { this->invoke(t); }
+  void visit(Vector_type const* t) { this->invoke(t); }
   void visit(Block_type const* t) { this->invoke(t); }
   void visit(Reference_type const* t) { this->invoke(t); }
   void visit(Record_type const* t) { this->invoke(t); }
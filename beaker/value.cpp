@@ -13,8 +13,8 @@
 std::string
 Array_value::get_string() const
 {
-  std::string str(len, '\0');
-  std::transform(data, data + len, str.begin(), [](Value const& v) -> char {
+  std::string str(len(), '\0');
+  std::transform(data(), data() + len(), str.begin(), [](Value const& v) -> char {
     return (v.is_integer()?v.get_integer():v.get_float());
   });
   return str;
@@ -31,8 +31,8 @@ inline void
 print(std::ostream& os, Array_value const& v)
 {
   os << '[';
-  Value const* p = v.data;
-  Value const* q = p + v.len;
+  Value const* p = v.data();
+  Value const* q = p + v.len();
   while (p != q) {
     os << *p;
     if (p + 1 != q)
@@ -43,12 +43,39 @@ print(std::ostream& os, Array_value const& v)
 }
 
 
+// Strings are printed as arrays of characters.
+inline void
+print(std::ostream& os, String_value const& v)
+{
+  os << '[';
+  for (std::size_t i = 0; i < v->size(); ++i) {
+    os << (int)(*v)[i];
+    if (i + 1 != v->size())
+      os << ',';
+  }
+  os << ']';
+}
+
+
+inline void
+print(std::ostream& os, Buffer_value const& v)
+{
+  os << '[';
+  for (std::size_t i = 0; i < v.len(); ++i) {
+    os << load(v.kind(), v.element(i));
+    if (i + 1 != v.len())
+      os << ',';
+  }
+  os << ']';
+}
+
+
 inline void
 print(std::ostream& os, Tuple_value const& v)
 {
   os << '{';
-  Value const* p = v.data;
-  Value const* q = p + v.len;
+  Value const* p = v.data();
+  Value const* q = p + v.len();
   while (p != q) {
     os << *p;
     if (p + 1 != q)
@@ -73,6 +100,9 @@ operator<<(std::ostream& os, Value const& v)
     void operator()(Reference_value const& v) { os << *v << '@' << (void*)v; };
     void operator()(Array_value const& v) { print(os, v); }
     void operator()(Tuple_value const& v) { print(os, v); }
+    void operator()(String_value const& v) { print(os, v); }
+    void operator()(Buffer_value const& v) { print(os, v); }
+    void operator()(Element_value const& v) { os << '@' << v.addr; }
   };
 
   apply(v, Fn{os});
@@ -127,8 +157,15 @@ zero_init(Reference_value& v)
 void
 zero_init(Aggregate_value& v)
 {
-  for (std::size_t i = 0; i < v.len; ++i)
-    zero_init(v.data[i]);
+  for (std::size_t i = 0; i < v.len(); ++i)
+    zero_init(v.data()[i]);
+}
+
+// Zero initialize the elements of the buffer.
+void
+zero_init(Buffer_value& v)
+{
+  std::memset(v.data(), 0, v.len() * element_size(v.kind()));
 }
 
 // Zero initialzie the value.
@@ -143,6 +180,57 @@ zero_init(Value& v)
     void operator()(Function_value& v) { zero_init(v); }
     void operator()(Reference_value& v) { zero_init(v); }
     void operator()(Aggregate_value& v) { zero_init(v); };
+    void operator()(String_value& v) { lingo_unreachable(); };
+    void operator()(Buffer_value& v) { zero_init(v); };
+    void operator()(Element_value& v) { lingo_unreachable(); };
   };
   apply(v, Fn{});
 }
+
+
+// Copy the value of src into dst. The elements of an
+// aggregate are copied into the existing storage of dst,
+// so dst keeps its own dynamic type. In particular,
+// copying a derived object into a base object copies
+// only the base subobject.
+void
+copy_value(Value& dst, Value const& src)
+{
+  if (dst.is_tuple() && src.is_tuple()) {
+    Tuple_value d = dst.get_tuple();
+    Tuple_value s = src.get_tuple();
+    for (std::size_t i = 0; i < std::min(d.len(), s.len()); ++i)
+      copy_value(d.data()[i], s.data()[i]);
+  } else if (dst.is_array() && src.is_array()) {
+    Array_value d = dst.get_array();
+    Array_value s = src.get_array();
+    for (std::size_t i = 0; i < std::min(d.len(), s.len()); ++i)
+      copy_value(d.data()[i], s.data()[i]);
+  } else if (dst.is_buffer() && src.is_buffer()) {
+    Buffer_value d = dst.get_buffer();
+    Buffer_value s = src.get_buffer();
+    lingo_assert(d.kind() == s.kind());
+    std::memcpy(d.data(), s.data(), std::min(d.len(), s.len()) * element_size(d.kind()));
+  } else if (dst.is_buffer() && src.is_string()) {
+    Buffer_value d = dst.get_buffer();
+    String_value s = src.get_string();
+    std::size_t n = std::min(d.len(), s->size());
+    std::memcpy(d.data(), s->data(), n);
+    std::memset(d.data() + n, 0, d.len() - n);
+  } else if (src.is_string()) {
+    dst = make_array(src.get_string());
+  } else {
+    dst = src;
+  }
+}
+
+
+// Returns a new buffer holding the characters of the
+// string, followed by a null character.
+Buffer_value
+make_array(String_value s)
+{
+  Buffer_value a(int8_element, s->size() + 1);
+  std::memcpy(a.data(), s->data(), s->size());
+  return a;
+}
@@ -11,6 +11,9 @@
 
 #include <beaker/prelude.hpp>
 
+#include <cstring>
+#include <memory>
+
 
 struct Value;
 
@@ -24,6 +27,9 @@ enum Value_kind
   reference_value,
   array_value,
   tuple_value,
+  string_value,
+  buffer_value,
+  element_value,
 };
 
 
@@ -37,15 +43,94 @@ using Function_value = Function_decl const*;
 using Reference_value = Value*;
 
 
+// A string value refers to an immutable string in the
+// string pool. The pool is the set of string symbols in
+// the symbol table, so equal strings have the same
+// value. String literals are string values; the characters
+// of a string are copied into an array only when it is
+// stored in an object.
+using String_value = String const*;
+
+
+// The representation of an element of a buffer. Each
+// kind of element corresponds to a scalar type.
+enum Element_kind
+{
+  int8_element,
+  uint8_element,
+  int16_element,
+  uint16_element,
+  int32_element,
+  uint32_element,
+  int64_element,
+  uint64_element,
+  float_element,
+  double_element,
+};
+
+
+std::size_t element_size(Element_kind);
+
+
+// The storage of a buffer. The elements are packed
+// immediately after the header.
+struct Buffer_data
+{
+  std::size_t  len;
+  Element_kind kind;
+};
+
+
+// A buffer value is an array of scalars. Elements are
+// stored in their native representation, not as values,
+// so arrays of numbers are compact. Like aggregates, a
+// buffer value refers to its storage.
+struct Buffer_value
+{
+  Buffer_value(Element_kind, std::size_t n);
+
+  std::size_t  len() const  { return rep->len; }
+  Element_kind kind() const { return rep->kind; }
+  char*        data() const { return reinterpret_cast<char*>(rep + 1); }
+  void*        element(std::size_t n) const { return data() + n * element_size(kind()); }
+
+  Buffer_data* rep;
+};
+
+
+// An element value is a reference to an element of
+// a buffer. The kind of element is determined by the
+// static type of the expression that refers to it.
+struct Element_value
+{
+  void* addr;
+};
+
+
+// The storage of an aggregate. The elements are
+// allocated immediately after the header. The record
+// is the dynamic type of a record value, and is null
+// for arrays.
+struct Aggregate_data
+{
+  std::size_t        len;
+  Record_decl const* record;
+};
+
+
 // The common structure of array and tuple
-// values.
+// values. An aggregate value refers to its
+// storage, so copying an aggregate value does
+// not copy its elements.
 struct Aggregate_value
 {
   Aggregate_value(std::size_t n);
   Aggregate_value(char const*, std::size_t n);
 
-  std::size_t len;
-  Value*      data;
+  std::size_t len() const  { return rep->len; }
+  Value*      data() const { return reinterpret_cast<Value*>(rep + 1); }
+
+  Aggregate_data* rep;
 };
 
 
@@ -72,6 +157,8 @@ struct Array_value : Aggregate_value
 struct Tuple_value : Aggregate_value
 {
   using Aggregate_value::Aggregate_value;
+
+  Record_decl const* record() const { return rep->record; }
 };
 
 
@@ -84,6 +171,9 @@ union Value_rep
   Value_rep(Reference_value r) : ref_(r) { }
   Value_rep(Array_value a) : arr_(a) { }
   Value_rep(Tuple_value t) : tup_(t) { }
+  Value_rep(String_value s) : str_(s) { }
+  Value_rep(Buffer_value b) : buf_(b) { }
+  Value_rep(Element_value e) : elem_(e) { }
   ~Value_rep() { }
 
 
@@ -94,6 +184,9 @@ union Value_rep
   Reference_value ref_;
   Array_value     arr_;
   Tuple_value     tup_;
+  String_value    str_;
+  Buffer_value    buf_;
+  Element_value   elem_;
 };
 
 
@@ -141,6 +234,18 @@ struct Value
     : k(tuple_value), r(a)
   { }
 
+  Value(String_value s)
+    : k(string_value), r(s)
+  { }
+
+  Value(Buffer_value b)
+    : k(buffer_value), r(b)
+  { }
+
+  Value(Element_value e)
+    : k(element_value), r(e)
+  { }
+
   Value(Value* v);
 
   ~Value() { }
@@ -156,6 +261,9 @@ struct Value
   bool is_reference() const;
   bool is_array() const;
   bool is_tuple() const;
+  bool is_string() const;
+  bool is_buffer() const;
+  bool is_element() const;
 
   Error_value get_error() const;
   Integer_value get_integer() const;
@@ -164,6 +272,9 @@ struct Value
   Reference_value get_reference() const;
   Array_value get_array() const;
   Tuple_value get_tuple() const;
+  String_value get_string() const;
+  Buffer_value get_buffer() const;
+  Element_value get_element() const;
 
   Value_kind k;
   Value_rep r;
@@ -180,6 +291,9 @@ struct Value::Visitor
   virtual void visit(Reference_value const&) = 0;
   virtual void visit(Array_value const&) = 0;
   virtual void visit(Tuple_value const&) = 0;
+  virtual void visit(String_value const&) = 0;
+  virtual void visit(Buffer_value const&) = 0;
+  virtual void visit(Element_value const&) = 0;
 };
 
 
@@ -193,6 +307,9 @@ struct Value::Mutator
   virtual void visit(Reference_value&) = 0;
   virtual void visit(Array_value&) = 0;
   virtual void visit(Tuple_value&) = 0;
+  virtual void visit(String_value&) = 0;
+  virtual void visit(Buffer_value&) = 0;
+  virtual void visit(Element_value&) = 0;
 };
 
 
@@ -203,7 +320,7 @@ inline
 Value::Value(Value* v)
   : k(reference_value), r(v)
 {
-  assert(!v->is_reference());
+  assert(!v || !v->is_reference());
 }
 
 
@@ -261,6 +378,31 @@ Value::is_tuple() const
 }
 
 
+// Returns true if the value is a string.
+inline bool
+Value::is_string() const
+{
+  return k == string_value;
+}
+
+
+// Returns true if the value is a buffer.
+inline bool
+Value::is_buffer() const
+{
+  return k == buffer_value;
+}
+
+
+// Returns true if the value refers to an element
+// of a buffer.
+inline bool
+Value::is_element() const
+{
+  return k == element_value;
+}
+
+
 // Returns the error value.
 inline Error_value
 Value::get_error() const
@@ -324,6 +466,33 @@ Value::get_tuple() const
 }
 
 
+// Returns the string value.
+inline String_value
+Value::get_string() const
+{
+  assert(is_string());
+  return r.str_;
+}
+
+
+// Returns the buffer value.
+inline Buffer_value
+Value::get_buffer() const
+{
+  assert(is_buffer());
+  return r.buf_;
+}
+
+
+// Returns the element reference.
+inline Element_value
+Value::get_element() const
+{
+  assert(is_element());
+  return r.elem_;
+}
+
+
 inline void
 Value::accept(Visitor& v) const
 {
@@ -335,6 +504,9 @@ Value::accept(Visitor& v) const
     case reference_value: return v.visit(r.ref_);
     case array_value: return v.visit(r.arr_);
     case tuple_value: return v.visit(r.tup_);
+    case string_value: return v.visit(r.str_);
+    case buffer_value: return v.visit(r.buf_);
+    case element_value: return v.visit(r.elem_);
   }
 }
 
@@ -350,6 +522,9 @@ Value::accept(Mutator& v)
     case reference_value: return v.visit(r.ref_);
     case array_value: return v.visit(r.arr_);
     case tuple_value: return v.visit(r.tup_);
+    case string_value: return v.visit(r.str_);
+    case buffer_value: return v.visit(r.buf_);
+    case element_value: return v.visit(r.elem_);
   }
 }
 
@@ -371,6 +546,9 @@ struct Generic_value_visitor : Value::Visitor, lingo::Generic_visitor<F, T>
   void visit(Reference_value const& v) { this->invoke(v); };
   void visit(Array_value const& v) { this->invoke(v); };
   void visit(Tuple_value const& v) { this->invoke(v); };
+  void visit(String_value const& v) { this->invoke(v); };
+  void visit(Buffer_value const& v) { this->invoke(v); };
+  void visit(Element_value const& v) { this->invoke(v); };
 };
 
 
@@ -397,6 +575,9 @@ struct Generic_value_mutator : Value::Mutator, lingo::Generic_mutator<F, T>
   void visit(Reference_value& v) { this->invoke(v); };
   void visit(Array_value& v) { this->invoke(v); };
   void visit(Tuple_value& v) { this->invoke(v); };
+  void visit(String_value& v) { this->invoke(v); };
+  void visit(Buffer_value& v) { this->invoke(v); };
+  void visit(Element_value& v) { this->invoke(v); };
 };
 
 
@@ -413,17 +594,92 @@ apply(Value& v, F fn)
 // -------------------------------------------------------------------------- //
 // Aggregate values
 
+// Allocate storage for n values.
 inline
 Aggregate_value::Aggregate_value(std::size_t n)
-  : len(n), data(new Value[n])
-{ }
+  : rep(static_cast<Aggregate_data*>(operator new(sizeof(Aggregate_data) + n * sizeof(Value))))
+{
+  rep->len = n;
+  rep->record = nullptr;
+  std::uninitialized_fill_n(data(), n, Value());
+}
 
 
 inline
 Aggregate_value::Aggregate_value(char const* s, std::size_t n)
   : Aggregate_value(n)
 {
-  std::copy(s, s + n, data);
+  std::copy(s, s + n, data());
+}
+
+
+// -------------------------------------------------------------------------- //
+// Buffer values
+
+// Returns the size of an element in bytes.
+inline std::size_t
+element_size(Element_kind k)
+{
+  switch (k) {
+    case int8_element: case uint8_element: return 1;
+    case int16_element: case uint16_element: return 2;
+    case int32_element: case uint32_element: return 4;
+    case int64_element: case uint64_element: return 8;
+    case float_element: return 4;
+    case double_element: return 8;
+  }
+  lingo_unreachable();
+}
+
+
+// Allocate zero-initialized storage for n elements.
+inline
+Buffer_value::Buffer_value(Element_kind k, std::size_t n)
+  : rep(static_cast<Buffer_data*>(operator new(sizeof(Buffer_data) + n * element_size(k))))
+{
+  rep->len = n;
+  rep->kind = k;
+  std::memset(data(), 0, n * element_size(k));
+}
+
+
+// Returns the value of the element at p.
+inline Value
+load(Element_kind k, void const* p)
+{
+  switch (k) {
+    case int8_element: return Integer_value(*static_cast<int8_t const*>(p));
+    case uint8_element: return Integer_value(*static_cast<uint8_t const*>(p));
+    case int16_element: return Integer_value(*static_cast<int16_t const*>(p));
+    case uint16_element: return Integer_value(*static_cast<uint16_t const*>(p));
+    case int32_element: return Integer_value(*static_cast<int32_t const*>(p));
+    case uint32_element: return Integer_value(*static_cast<uint32_t const*>(p));
+    case int64_element: return Integer_value(*static_cast<int64_t const*>(p));
+    case uint64_element: return Integer_value(*static_cast<uint64_t const*>(p));
+    case float_element: return Float_value(*static_cast<float const*>(p));
+    case double_element: return Float_value(*static_cast<double const*>(p));
+  }
+  lingo_unreachable();
+}
+
+
+// Store the value v in the element at p.
+inline void
+store(Element_kind k, void* p, Value const& v)
+{
+  switch (k) {
+    case int8_element: *static_cast<int8_t*>(p) = v.get_integer(); return;
+    case uint8_element: *static_cast<uint8_t*>(p) = v.get_integer(); return;
+    case int16_element: *static_cast<int16_t*>(p) = v.get_integer(); return;
+    case uint16_element: *static_cast<uint16_t*>(p) = v.get_integer(); return;
+    case int32_element: *static_cast<int32_t*>(p) = v.get_integer(); return;
+    case uint32_element: *static_cast<uint32_t*>(p) = v.get_integer(); return;
+    case int64_element: *static_cast<int64_t*>(p) = v.get_integer(); return;
+    case uint64_element: *static_cast<uint64_t*>(p) = v.get_integer(); return;
+    case float_element: *static_cast<float*>(p) = v.get_float(); return;
+    case double_element: *static_cast<double*>(p) = v.get_float(); return;
+  }
+  lingo_unreachable();
 }
 
 
@@ -431,6 +687,8 @@ Aggregate_value::Aggregate_value(char const* s, std::size_t n)
 // Intrinsic behaviors
 
 void zero_init(Value&);
+void copy_value(Value&, Value const&);
+Buffer_value make_array(String_value);
 
 
 // -------------------------------------------------------------------------- //